@@ -0,0 +1,152 @@
+"""A small benchmark suite for PyMiniRacer.
+
+This exercises the main paths through the Python wrapper, the C++ frontend, and V8:
+evaluation, function calls, object property access, value conversion, Python callbacks
+from JavaScript, and a heavy real-world script (babel). It's used both as a training
+workload for profile-guided optimization builds (see `v8_build.py --pgo`), and to
+compare builds against each other.
+
+Results are written as JSON mapping benchmark name to seconds per iteration (lower is
+better).
+"""
+
+import json
+from argparse import ArgumentParser
+from asyncio import run as asyncio_run
+from os.path import abspath, dirname
+from os.path import join as pathjoin
+from sys import stdout
+from time import perf_counter
+
+from py_mini_racer import MiniRacer
+
+ROOT_DIR = dirname(abspath(__file__))
+
+
+def bench_eval_small(mr, n):
+    for _ in range(n):
+        mr.eval("1 + 1")
+
+
+def bench_eval_loop(mr, n):
+    for _ in range(n):
+        mr.eval("let x = 0; for (let i = 0; i < 100000; i++) { x += i % 7; } x")
+
+
+def bench_call(mr, n):
+    mr.eval("function add(a, b) { return a + b; }")
+    for i in range(n):
+        mr.call("add", i, 1)
+
+
+def bench_object_access(mr, n):
+    obj = mr.eval("({a: 1, b: 'two', c: [1, 2, 3]})")
+    found = 0
+    for i in range(n):
+        obj["a"] = i
+        found += obj["b"] == "two"
+        found += "c" in obj
+    assert found == 2 * n
+
+
+def bench_array_iteration(mr, n):
+    arr = mr.eval("Array.from({length: 1000}, (_, i) => i)")
+    for _ in range(n):
+        sum(arr)
+
+
+def bench_string_conversion(mr, n):
+    mr.eval("var s = 'x'.repeat(100000)")
+    for _ in range(n):
+        mr.eval("s")
+
+
+def bench_json_roundtrip(mr, n):
+    mr.eval("var data = Array.from({length: 1000}, (_, i) => ({id: i, s: `n${i}`}))")
+    for _ in range(n):
+        mr.execute("data")
+
+
+def bench_py_function(mr, n):
+    async def double(x):
+        return x * 2
+
+    async def run():
+        async with mr.wrap_py_function(double) as jsfunc:
+            mr.eval("f => this.double = f")(jsfunc)
+            for i in range(n):
+                await mr.eval(f"this.double({i})")
+
+    asyncio_run(run())
+
+
+def bench_babel(mr, n):
+    with open(pathjoin(ROOT_DIR, "..", "tests", "fixtures", "babel.js")) as f:
+        mr.eval(f"var self = this; {f.read()}")
+    for _ in range(n):
+        mr.eval("babel.transform('const f = (a, ...b) => [a, ...b];').code")
+
+
+BENCHMARKS = {
+    "eval_small": (bench_eval_small, 2000),
+    "eval_loop": (bench_eval_loop, 200),
+    "call": (bench_call, 2000),
+    "object_access": (bench_object_access, 1000),
+    "array_iteration": (bench_array_iteration, 20),
+    "string_conversion": (bench_string_conversion, 500),
+    "json_roundtrip": (bench_json_roundtrip, 200),
+    "py_function": (bench_py_function, 500),
+    "babel": (bench_babel, 20),
+}
+
+
+def run_benchmarks(names=None, repeat=3, scale=1.0):
+    results = {}
+    for name, (func, n) in BENCHMARKS.items():
+        if names and name not in names:
+            continue
+
+        iterations = max(1, int(n * scale))
+        best = None
+        for _ in range(repeat):
+            with MiniRacer() as mr:
+                start = perf_counter()
+                func(mr, iterations)
+                elapsed = (perf_counter() - start) / iterations
+            best = elapsed if best is None else min(best, elapsed)
+        results[name] = best
+
+    return results
+
+
+def format_comparison(before, after):
+    """Render a Markdown table comparing two sets of benchmark results."""
+
+    lines = [
+        "| benchmark | before (us) | after (us) | speedup |",
+        "| --- | ---: | ---: | ---: |",
+    ]
+    for name in before:
+        if name not in after:
+            continue
+        b, a = before[name] * 1e6, after[name] * 1e6
+        lines.append(f"| {name} | {b:.1f} | {a:.1f} | {b / a:.2f}x |")
+    return "\n".join(lines) + "\n"
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument("--output", help="Write JSON results to this file")
+    parser.add_argument("--repeat", type=int, default=3)
+    parser.add_argument(
+        "--scale", type=float, default=1.0, help="Multiply iteration counts by this"
+    )
+    parser.add_argument("benchmarks", nargs="*", help="Benchmarks to run (all)")
+    args = parser.parse_args()
+
+    res = run_benchmarks(args.benchmarks, repeat=args.repeat, scale=args.scale)
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(res, f, indent=2)
+    for bench_name, secs in res.items():
+        stdout.write(f"{bench_name:<20}{secs * 1e6:>12.1f} us\n")
@@ -0,0 +1,553 @@
+"""Replay a MiniRacer API call trace against a build of the MiniRacer DLL.
+
+Traces are recorded by py_mini_racer.start_trace() (see
+src/v8_py_frontend/call_tracer.h for the file format). This tool re-executes the
+recorded calls, in their original order, against the DLL found in --lib-dir (by
+default, the one in src/py_mini_racer), and compares per-call timings with the
+recording. Run it against two builds to measure a change against a real workload.
+"""
+
+import ctypes
+from argparse import ArgumentParser
+from collections import defaultdict
+from os.path import abspath, dirname
+from os.path import join as pathjoin
+from queue import Empty, Queue
+from struct import Struct
+from sys import platform, stdout
+from threading import Lock
+from time import perf_counter_ns
+
+ROOT_DIR = dirname(abspath(__file__))
+TRACE_MAGIC = b"MRTRACE1"
+
+_RECORD_HEADER = Struct("=BQQQI")
+_U64 = Struct("=Q")
+_I64 = Struct("=q")
+_F64 = Struct("=d")
+_U32 = Struct("=I")
+_RESULT_HANDLE = Struct("=QBQ")
+
+# These mirror MiniRacer::TraceTag:
+TAG_U64 = 1
+TAG_I64 = 2
+TAG_F64 = 3
+TAG_HANDLE = 4
+TAG_BYTES = 5
+TAG_RESULT_U64 = 6
+TAG_RESULT_HANDLE = 7
+
+# These mirror MiniRacer::TraceOp:
+OP_INIT_CONTEXT = 1
+OP_FREE_CONTEXT = 2
+OP_CALLBACK = 3
+OP_ALLOC_INT_VAL = 4
+OP_ALLOC_DOUBLE_VAL = 5
+OP_ALLOC_STRING_VAL = 6
+OP_FREE_VALUE = 7
+OP_EVAL = 8
+OP_CALL_FUNCTION = 9
+OP_CANCEL_TASK = 10
+OP_HEAP_STATS = 11
+OP_HEAP_SNAPSHOT = 12
+OP_MAKE_JS_CALLBACK = 13
+OP_GET_IDENTITY_HASH = 14
+OP_GET_OWN_PROPERTY_NAMES = 15
+OP_GET_OBJECT_ITEM = 16
+OP_SET_OBJECT_ITEM = 17
+OP_DEL_OBJECT_ITEM = 18
+OP_SPLICE_ARRAY = 19
+OP_SET_HARD_MEMORY_LIMIT = 20
+OP_SET_SOFT_MEMORY_LIMIT = 21
+OP_HARD_MEMORY_LIMIT_REACHED = 22
+OP_SOFT_MEMORY_LIMIT_REACHED = 23
+OP_LOW_MEMORY_NOTIFICATION = 24
+OP_SET_SPIN_WAIT = 25
+OP_SET_MICROTASK_POLICY = 26
+OP_CALL_JSON = 27
+OP_RUN_BATCH = 28
+OP_EXEC = 29
+OP_SET_TASK_WATCHDOG = 30
+OP_TASK_WATCHDOG_RECORDS = 31
+OP_HEAP_SUMMARY = 32
+OP_SET_HEAP_GROWTH_BASELINE = 33
+OP_HEAP_GROWTH = 34
+OP_VALUE_STATS = 35
+OP_INSTALL_CONSOLE = 36
+OP_DRAIN_CONSOLE = 37
+OP_ALLOW_FILE_READS = 38
+OP_MAP_JSON = 39
+OP_PIN_ISOLATE_THREAD = 40
+OP_TRIM_MEMORY = 41
+OP_SET_IDLE_TRIM = 42
+OP_TRIM_STATS = 43
+
+_H = ctypes.c_void_p
+_U = ctypes.c_uint64
+
+# Ops which map directly onto a DLL function: op -> (name, argtypes, restype).
+# Note that we pass handles around as plain addresses; we never look inside them.
+OPS = {
+    OP_INIT_CONTEXT: ("mr_init_context", None, _U),
+    OP_FREE_CONTEXT: ("mr_free_context", [_U], None),
+    OP_CALLBACK: ("callback", None, None),
+    OP_ALLOC_INT_VAL: ("mr_alloc_int_val", [_U, ctypes.c_int64, ctypes.c_uint8], _H),
+    OP_ALLOC_DOUBLE_VAL: (
+        "mr_alloc_double_val",
+        [_U, ctypes.c_double, ctypes.c_uint8],
+        _H,
+    ),
+    OP_ALLOC_STRING_VAL: (
+        "mr_alloc_string_val",
+        [_U, ctypes.c_char_p, _U, ctypes.c_uint8],
+        _H,
+    ),
+    OP_FREE_VALUE: ("mr_free_value", [_U, _H], None),
+    OP_EVAL: ("mr_eval", [_U, _H, _U], _U),
+    OP_CALL_FUNCTION: ("mr_call_function", [_U, _H, _H, _H, _U], _U),
+    OP_CANCEL_TASK: ("mr_cancel_task", [_U, _U], None),
+    OP_HEAP_STATS: ("mr_heap_stats", [_U, _U], _U),
+    OP_HEAP_SNAPSHOT: ("mr_heap_snapshot", [_U, _U], _U),
+    OP_MAKE_JS_CALLBACK: ("mr_make_js_callback", [_U, _U], _H),
+    OP_GET_IDENTITY_HASH: ("mr_get_identity_hash", [_U, _H], _H),
+    OP_GET_OWN_PROPERTY_NAMES: ("mr_get_own_property_names", [_U, _H], _H),
+    OP_GET_OBJECT_ITEM: ("mr_get_object_item", [_U, _H, _H], _H),
+    OP_SET_OBJECT_ITEM: ("mr_set_object_item", [_U, _H, _H, _H], _H),
+    OP_DEL_OBJECT_ITEM: ("mr_del_object_item", [_U, _H, _H], _H),
+    OP_SPLICE_ARRAY: (
+        "mr_splice_array",
+        [_U, _H, ctypes.c_int32, ctypes.c_int32, _H],
+        _H,
+    ),
+    OP_SET_HARD_MEMORY_LIMIT: ("mr_set_hard_memory_limit", [_U, ctypes.c_size_t], None),
+    OP_SET_SOFT_MEMORY_LIMIT: ("mr_set_soft_memory_limit", [_U, ctypes.c_size_t], None),
+    OP_HARD_MEMORY_LIMIT_REACHED: ("mr_hard_memory_limit_reached", [_U], ctypes.c_bool),
+    OP_SOFT_MEMORY_LIMIT_REACHED: ("mr_soft_memory_limit_reached", [_U], ctypes.c_bool),
+    OP_LOW_MEMORY_NOTIFICATION: ("mr_low_memory_notification", [_U], None),
+    OP_SET_SPIN_WAIT: ("mr_set_spin_wait", [_U, _U], None),
+    OP_SET_MICROTASK_POLICY: (
+        "mr_set_microtask_policy",
+        [_U, ctypes.c_uint8],
+        ctypes.c_bool,
+    ),
+    OP_CALL_JSON: ("mr_call_json", [_U, _H, _H, _U], _U),
+    OP_RUN_BATCH: (
+        "mr_run_batch",
+        [_U, ctypes.POINTER(_U), ctypes.c_size_t, ctypes.POINTER(_H), ctypes.c_size_t],
+        ctypes.c_size_t,
+    ),
+    OP_EXEC: ("mr_exec", [_U, _H, ctypes.c_bool, _U], _U),
+    OP_SET_TASK_WATCHDOG: ("mr_set_task_watchdog", [_U, _U], None),
+    OP_TASK_WATCHDOG_RECORDS: ("mr_task_watchdog_records", [_U], _H),
+    OP_HEAP_SUMMARY: ("mr_heap_summary", [_U, _U, _U], _U),
+    OP_SET_HEAP_GROWTH_BASELINE: ("mr_set_heap_growth_baseline", [_U, _U], _U),
+    OP_HEAP_GROWTH: ("mr_heap_growth", [_U, _U, _U], _U),
+    OP_VALUE_STATS: ("mr_value_stats", [_U], _H),
+    OP_INSTALL_CONSOLE: ("mr_install_console", [_U, _U], ctypes.c_bool),
+    OP_DRAIN_CONSOLE: ("mr_drain_console", [_U], _H),
+    OP_ALLOW_FILE_READS: (
+        "mr_allow_file_reads",
+        [_U, ctypes.c_char_p, _U],
+        ctypes.c_bool,
+    ),
+    OP_MAP_JSON: ("mr_map_json", [_U, _H, _H, _U], _U),
+    OP_PIN_ISOLATE_THREAD: (
+        "mr_pin_isolate_thread",
+        [_U, ctypes.c_char_p, _U, ctypes.c_int32],
+        ctypes.c_bool,
+    ),
+    OP_TRIM_MEMORY: ("mr_trim_memory", [_U], _U),
+    OP_SET_IDLE_TRIM: ("mr_set_idle_trim", [_U, _U], None),
+    OP_TRIM_STATS: ("mr_trim_stats", [_U], _H),
+}
+
+# Ops which start an async task, and thus return a task ID:
+TASK_OPS = {
+    OP_EVAL,
+    OP_CALL_FUNCTION,
+    OP_HEAP_STATS,
+    OP_HEAP_SNAPSHOT,
+    OP_CALL_JSON,
+    OP_EXEC,
+    OP_HEAP_SUMMARY,
+    OP_SET_HEAP_GROWTH_BASELINE,
+    OP_HEAP_GROWTH,
+    OP_MAP_JSON,
+}
+
+# Operand kinds of each batch opcode, mirroring MiniRacer::Context::DecodeBatch:
+# v for a value, i for an integer, and * for a count followed by that many values.
+BATCH_OPERANDS = {1: "vv", 2: "vvv", 3: "vv", 4: "vii*", 5: "vv*"}
+BATCH_RESULT_REF = 1 << 63
+
+REPLAY_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.c_uint64, ctypes.c_void_p)
+
+
+class TraceFormatError(RuntimeError):
+    pass
+
+
+class Record:
+    __slots__ = ("context_id", "duration_ns", "fields", "op", "start_ns")
+
+    def __init__(self, op, context_id, start_ns, duration_ns, fields):
+        self.op = op
+        self.context_id = context_id
+        self.start_ns = start_ns
+        self.duration_ns = duration_ns
+        self.fields = fields
+
+    def result(self):
+        for tag, v in self.fields:
+            if tag >= TAG_RESULT_U64:
+                return v
+        return None
+
+
+def _parse_fields(payload):
+    fields = []
+    pos = 0
+    while pos < len(payload):
+        tag = payload[pos]
+        pos += 1
+        if tag in (TAG_U64, TAG_HANDLE, TAG_RESULT_U64):
+            (v,) = _U64.unpack_from(payload, pos)
+            pos += _U64.size
+        elif tag == TAG_I64:
+            (v,) = _I64.unpack_from(payload, pos)
+            pos += _I64.size
+        elif tag == TAG_F64:
+            (v,) = _F64.unpack_from(payload, pos)
+            pos += _F64.size
+        elif tag == TAG_BYTES:
+            (n,) = _U32.unpack_from(payload, pos)
+            pos += _U32.size
+            v = bytes(payload[pos : pos + n])
+            pos += n
+        elif tag == TAG_RESULT_HANDLE:
+            # (address, type, len)
+            v = _RESULT_HANDLE.unpack_from(payload, pos)
+            pos += _RESULT_HANDLE.size
+        else:
+            msg = f"Unknown field tag {tag}"
+            raise TraceFormatError(msg)
+        fields.append((tag, v))
+    return fields
+
+
+def read_trace(path):
+    """Read a trace file, returning its records in call order."""
+
+    with open(path, "rb") as f:
+        data = memoryview(f.read())
+
+    if bytes(data[: len(TRACE_MAGIC)]) != TRACE_MAGIC:
+        msg = f"{path} is not a MiniRacer trace"
+        raise TraceFormatError(msg)
+
+    records = []
+    pos = len(TRACE_MAGIC)
+    while pos + _RECORD_HEADER.size <= len(data):
+        op, context_id, start_ns, duration_ns, payload_len = _RECORD_HEADER.unpack_from(
+            data, pos
+        )
+        pos += _RECORD_HEADER.size
+        payload = data[pos : pos + payload_len]
+        pos += payload_len
+        records.append(
+            Record(op, context_id, start_ns, duration_ns, _parse_fields(payload))
+        )
+
+    # Records are written upon call completion, so restore call order:
+    records.sort(key=lambda r: r.start_ns)
+    return records
+
+
+def _lib_filename():
+    if platform == "darwin":
+        return "libmini_racer.dylib"
+    if platform == "win32":
+        return "mini_racer.dll"
+    return "libmini_racer.so"
+
+
+def load_dll(lib_dir, flags):
+    dll = ctypes.CDLL(pathjoin(lib_dir, _lib_filename()))
+    dll.mr_init_v8.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p]
+    dll.mr_init_context.argtypes = [REPLAY_CALLBACK]
+    for name, argtypes, restype in OPS.values():
+        if argtypes is None:
+            continue
+        func = getattr(dll, name)
+        func.argtypes = argtypes
+        func.restype = restype
+
+    dll.mr_init_v8(
+        flags.encode("utf-8"),
+        pathjoin(lib_dir, "icudtl.dat").encode("utf-8"),
+        pathjoin(lib_dir, "snapshot_blob.bin").encode("utf-8"),
+    )
+    return dll
+
+
+class Stats:
+    def __init__(self):
+        self.count = 0
+        self.recorded_ns = 0
+        self.replayed_ns = 0
+
+    def add(self, recorded_ns, replayed_ns):
+        self.count += 1
+        self.recorded_ns += recorded_ns
+        self.replayed_ns += replayed_ns
+
+
+class Replayer:
+    """Re-executes trace records, mapping recorded IDs and handles to live ones."""
+
+    def __init__(self, dll, callback_timeout_sec):
+        self._dll = dll
+        self._callback_timeout_sec = callback_timeout_sec
+        self._contexts = {}
+        self._c_callbacks = {}
+        self._handles = {}
+        self._tasks = {}
+        self._callback_queues = {}
+        self._callback_queues_lock = Lock()
+        # Recorded and replayed start times of async tasks, by callback ID:
+        self._recorded_task_starts = {}
+        self._replayed_task_starts = {}
+        self.stats = defaultdict(Stats)
+        self.unmapped_handles = 0
+        self.missed_callbacks = 0
+
+    def _callback_queue(self, key):
+        with self._callback_queues_lock:
+            return self._callback_queues.setdefault(key, Queue())
+
+    def _make_callback(self, live_context_cell):
+        def on_callback(callback_id, handle):
+            self._callback_queue((live_context_cell[0], callback_id)).put(
+                (perf_counter_ns(), handle)
+            )
+
+        return REPLAY_CALLBACK(on_callback)
+
+    def _handle(self, context_id, addr):
+        if addr == 0:
+            return None
+        live = self._handles.get((context_id, addr))
+        if live is None:
+            self.unmapped_handles += 1
+        return live
+
+    def _remember(self, context_id, recorded, live):
+        addr = recorded[0]
+        if addr != 0 and live is not None:
+            self._handles[(context_id, addr)] = live
+
+    def replay(self, record):
+        name = OPS.get(record.op, (None,))[0]
+        if name is None:
+            msg = f"Unknown op {record.op}"
+            raise TraceFormatError(msg)
+
+        if record.op == OP_INIT_CONTEXT:
+            cell = [0]
+            c_callback = self._make_callback(cell)
+            start = perf_counter_ns()
+            live_id = self._dll.mr_init_context(c_callback)
+            self.stats[name].add(record.duration_ns, perf_counter_ns() - start)
+            cell[0] = live_id
+            self._contexts[record.context_id] = live_id
+            self._c_callbacks[record.context_id] = c_callback
+            return
+
+        live_context_id = self._contexts.get(record.context_id)
+        if live_context_id is None:
+            # The context was made before tracing started; we can't replay it.
+            return
+
+        if record.op == OP_CALLBACK:
+            self._await_callback(record, live_context_id)
+            return
+
+        if record.op == OP_RUN_BATCH:
+            self._replay_batch(record, live_context_id)
+            return
+
+        args = [live_context_id]
+        for tag, v in record.fields:
+            if tag == TAG_HANDLE:
+                args.append(self._handle(record.context_id, v))
+            elif tag == TAG_BYTES:
+                args.extend((v, len(v)))
+            elif record.op == OP_CANCEL_TASK:
+                args.append(self._tasks.get((record.context_id, v), 0))
+            elif tag < TAG_RESULT_U64:
+                args.append(v)
+
+        if record.op in TASK_OPS:
+            callback_id = args[-1]
+            self._recorded_task_starts[(record.context_id, callback_id)] = (
+                record.start_ns
+            )
+            self._replayed_task_starts[(live_context_id, callback_id)] = (
+                perf_counter_ns()
+            )
+
+        start = perf_counter_ns()
+        ret = getattr(self._dll, name)(*args)
+        self.stats[name].add(record.duration_ns, perf_counter_ns() - start)
+
+        result = record.result()
+        if record.op in TASK_OPS:
+            self._tasks[(record.context_id, result)] = ret
+        elif isinstance(result, tuple):
+            self._remember(record.context_id, result, ret)
+        elif record.op == OP_FREE_VALUE:
+            self._handles.pop((record.context_id, record.fields[0][1]), None)
+        elif record.op == OP_FREE_CONTEXT:
+            del self._contexts[record.context_id]
+            for key in [k for k in self._handles if k[0] == record.context_id]:
+                del self._handles[key]
+
+    def _map_batch_words(self, context_id, words):
+        """Map the value handles embedded in a batch to live ones."""
+
+        pos = 0
+
+        def map_value():
+            nonlocal pos
+            if pos < len(words) and not words[pos] & BATCH_RESULT_REF:
+                words[pos] = self._handle(context_id, words[pos]) or 0
+            pos += 1
+
+        while pos < len(words):
+            kinds = BATCH_OPERANDS.get(words[pos])
+            pos += 1
+            if kinds is None:
+                # A malformed batch. Replay it as is, and let the DLL reject it.
+                return words
+            for kind in kinds:
+                if kind == "v":
+                    map_value()
+                elif kind == "i":
+                    pos += 1
+                elif pos < len(words):
+                    count = words[pos]
+                    pos += 1
+                    for _ in range(count):
+                        map_value()
+        return words
+
+    def _replay_batch(self, record, live_context_id):
+        (_, words_bytes), (_, results_len) = record.fields[:2]
+        words = self._map_batch_words(
+            record.context_id, list(memoryview(words_bytes).cast("Q"))
+        )
+        words_array = (_U * len(words))(*words)
+        results_array = (_H * results_len)()
+
+        start = perf_counter_ns()
+        count = self._dll.mr_run_batch(
+            live_context_id, words_array, len(words), results_array, results_len
+        )
+        self.stats["mr_run_batch"].add(record.duration_ns, perf_counter_ns() - start)
+
+        recorded_results = [v for tag, v in record.fields if tag == TAG_RESULT_HANDLE]
+        for recorded, live in zip(recorded_results, results_array[:count]):
+            self._remember(record.context_id, recorded, live)
+
+    def _await_callback(self, record, live_context_id):
+        (_, callback_id), (_, result) = record.fields
+        try:
+            arrival_ns, live_handle = self._callback_queue(
+                (live_context_id, callback_id)
+            ).get(timeout=self._callback_timeout_sec)
+        except Empty:
+            self.missed_callbacks += 1
+            return
+
+        self._remember(record.context_id, result, live_handle)
+
+        # If this callback completes an async task, compare completion latency:
+        recorded_start = self._recorded_task_starts.pop(
+            (record.context_id, callback_id), None
+        )
+        replayed_start = self._replayed_task_starts.pop(
+            (live_context_id, callback_id), None
+        )
+        if recorded_start is not None and replayed_start is not None:
+            self.stats["(async task completion)"].add(
+                record.start_ns - recorded_start, arrival_ns - replayed_start
+            )
+
+    def close(self):
+        for live_id in self._contexts.values():
+            self._dll.mr_free_context(live_id)
+        self._contexts.clear()
+
+
+def report(stats, out):
+    out.write(
+        f"{'call':<32}{'count':>9}{'recorded us':>14}{'replayed us':>14}{'ratio':>8}\n"
+    )
+    for name, s in sorted(stats.items(), key=lambda kv: -kv[1].replayed_ns):
+        ratio = s.replayed_ns / s.recorded_ns if s.recorded_ns else float("nan")
+        out.write(
+            f"{name:<32}{s.count:>9}{s.recorded_ns / 1000:>14.0f}"
+            f"{s.replayed_ns / 1000:>14.0f}{ratio:>8.2f}\n"
+        )
+
+
+def replay_trace(path, lib_dir, flags, callback_timeout_sec, out=stdout):
+    records = read_trace(path)
+    dll = load_dll(lib_dir, flags)
+    replayer = Replayer(dll, callback_timeout_sec)
+
+    start = perf_counter_ns()
+    try:
+        for record in records:
+            replayer.replay(record)
+    finally:
+        replayer.close()
+    replayed_ns = perf_counter_ns() - start
+
+    recorded_ns = (
+        max(r.start_ns + r.duration_ns for r in records) - records[0].start_ns
+        if records
+        else 0
+    )
+
+    report(replayer.stats, out)
+    out.write(
+        f"\n{len(records)} records; recorded span {recorded_ns / 1e6:.1f} ms, "
+        f"replayed in {replayed_ns / 1e6:.1f} ms\n"
+    )
+    if replayer.unmapped_handles or replayer.missed_callbacks:
+        out.write(
+            f"warning: {replayer.unmapped_handles} unmapped handles, "
+            f"{replayer.missed_callbacks} missed callbacks (was the trace started "
+            "mid-session?)\n"
+        )
+    return replayer.stats
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument("trace", help="Trace file recorded by start_trace()")
+    parser.add_argument(
+        "--lib-dir",
+        default=pathjoin(ROOT_DIR, "..", "src", "py_mini_racer"),
+        help="Directory containing the MiniRacer DLL, icudtl.dat and snapshot_blob.bin",
+    )
+    parser.add_argument("--v8-flags", default="--single-threaded")
+    parser.add_argument(
+        "--callback-timeout",
+        type=float,
+        default=30.0,
+        help="Seconds to wait for each recorded callback before giving up on it",
+    )
+    args = parser.parse_args()
+    replay_trace(args.trace, args.lib_dir, args.v8_flags, args.callback_timeout)
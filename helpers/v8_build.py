@@ -1,6 +1,8 @@
+import json
 from argparse import ArgumentParser
 from errno import EEXIST
 from functools import lru_cache
+from glob import glob
 from logging import DEBUG, basicConfig, getLogger
 from os import environ, makedirs, pathsep, remove, symlink, unlink
 from os.path import abspath, dirname, exists, isdir, isfile
@@ -141,9 +143,10 @@ def unlink_if_exists(f):
         unlink(f)
 
 
-def run(*args, cwd, depot_tools_first=True):
+def run(*args, cwd, depot_tools_first=True, extra_env=None):
     LOGGER.debug("Calling: '%s' from working directory %s", shlexjoin(args), cwd)
     env = environ.copy()
+    env.update(extra_env or {})
 
     if depot_tools_first:
         env["PATH"] = pathsep.join([get_depot_tools_path(), environ["PATH"]])
@@ -268,7 +271,7 @@ def apply_patch(path, patch_filename):
         f.write(patch_filename + "\n")
 
 
-def run_build(build_dir):
+def run_build(build_dir, extra_opts=None, target=None):
     """Run the actual v8 build."""
 
     # As explained in the design principles in ARCHITECTURE.md, we want to reduce the
@@ -341,6 +344,8 @@ def run_build(build_dir):
     if sccache_path is not None:
         opts["cc_wrapper"] = f'"{sccache_path}"'
 
+    opts.update(extra_opts or {})
+
     makedirs(build_dir, exist_ok=True)
 
     with open(pathjoin(build_dir, "args.gn"), "w") as f:
@@ -381,7 +386,7 @@ def run_build(build_dir):
         # "-vv",  # this is so spammy GitHub Actions struggles to show all the output
         "-C",
         build_dir,
-        pathjoin("custom_deps", "mini_racer"),
+        target or pathjoin("custom_deps", "mini_racer"),
         cwd=get_v8_path(),
     )
 
@@ -404,6 +409,7 @@ def build_v8(
     revision=None,
     fetch_only=False,
     skip_fetch=False,
+    pgo=False,
 ):
     revision = revision or V8_VERSION
 
@@ -417,8 +423,15 @@ def build_v8(
 
     build_dir = pathjoin(get_v8_path(), "out.gn", "build")
 
+    if pgo:
+        return build_v8_pgo(build_dir, out_path)
+
     run_build(build_dir)
 
+    return copy_artifacts(build_dir, out_path)
+
+
+def copy_artifacts(build_dir, out_path):
     # Fish out the build artifacts:
     makedirs(out_path, exist_ok=True)
 
@@ -441,6 +454,158 @@ def build_v8(
     return artifacts
 
 
+def run_benchmark(out_path, results_file, extra_env=None):
+    """Run helpers/benchmark.py against the build artifacts in out_path.
+
+    out_path must be the py_mini_racer package directory (as it is by default).
+    """
+
+    run(
+        executable,
+        "-m",
+        "helpers.benchmark",
+        "--output",
+        results_file,
+        cwd=local_path(".."),
+        extra_env={"PYTHONPATH": dirname(abspath(out_path)), **(extra_env or {})},
+    )
+
+    with open(results_file) as f:
+        return json.load(f)
+
+
+def get_llvm_profdata():
+    exe = "llvm-profdata.exe" if is_win() else "llvm-profdata"
+
+    if (is_linux() and get_v8_target_cpu() == "arm64") or is_musl():
+        # We build with the system clang here (see run_build), so the profile format
+        # must match the system llvm-profdata:
+        return pathjoin("/usr", "bin", exe)
+
+    # The clang which V8 bundles doesn't include llvm-profdata by default, but
+    # it's available as an optional package:
+    run(
+        executable,
+        pathjoin(get_v8_path(), "tools", "clang", "scripts", "update.py"),
+        "--package=coverage_tools",
+        cwd=get_v8_path(),
+    )
+    return pathjoin(
+        get_v8_path(), "third_party", "llvm-build", "Release+Asserts", "bin", exe
+    )
+
+
+def build_v8_pgo(build_dir, out_path):
+    """Build V8 and v8_py_frontend with profile-guided optimization and ThinLTO.
+
+    This builds three times:
+
+    1. An ordinary build, to get baseline benchmark numbers.
+    2. An instrumented build, which we run helpers/benchmark.py against to gather
+       execution profiles.
+    3. A final build, optimized using those profiles, and linked with ThinLTO (which
+       lets the optimizer inline and lay out code across V8 and v8_py_frontend).
+
+    Before and after benchmark numbers are logged, and written to pgo-report.md and
+    pgo-report.json in the final build directory.
+    """
+
+    out_gn = dirname(build_dir)
+    instrumented_dir = pathjoin(out_gn, "pgo-instrumented")
+    profile_dir = pathjoin(out_gn, "pgo-profiles")
+    merged_profile = pathjoin(out_gn, "mini_racer.profdata")
+
+    # 1. Baseline:
+    run_build(build_dir)
+    copy_artifacts(build_dir, out_path)
+    before = run_benchmark(out_path, pathjoin(out_gn, "benchmark-before.json"))
+
+    # 2. Instrumented build and training run:
+    run_build(instrumented_dir, extra_opts={"chrome_pgo_phase": "1"})
+    copy_artifacts(instrumented_dir, out_path)
+    rmtree(profile_dir, ignore_errors=True)
+    makedirs(profile_dir)
+    run_benchmark(
+        out_path,
+        pathjoin(out_gn, "benchmark-instrumented.json"),
+        # %p gives each process its own file; %m merges within a process:
+        extra_env={
+            "LLVM_PROFILE_FILE": pathjoin(profile_dir, "mini_racer-%p-%m.profraw")
+        },
+    )
+
+    profiles = glob(pathjoin(profile_dir, "*.profraw"))
+    if not profiles:
+        msg = f"The instrumented build wrote no profiles to {profile_dir}"
+        raise RuntimeError(msg)
+
+    run(
+        get_llvm_profdata(),
+        "merge",
+        "-o",
+        merged_profile,
+        *profiles,
+        cwd=out_gn,
+    )
+
+    # 3. Optimized build:
+    run_build(
+        build_dir,
+        extra_opts={
+            "chrome_pgo_phase": "2",
+            "pgo_data_path": f'"{merged_profile}"',
+            "use_thin_lto": "true",
+            # By default Chromium only runs the (slow) cross-module ThinLTO
+            # optimizations in official builds:
+            "thin_lto_enable_optimizations": "true",
+        },
+    )
+    artifacts = copy_artifacts(build_dir, out_path)
+    after = run_benchmark(out_path, pathjoin(out_gn, "benchmark-after.json"))
+
+    # Local import, to avoid importing py_mini_racer for ordinary builds:
+    from helpers.benchmark import format_comparison
+
+    table = format_comparison(before, after)
+    LOGGER.info("PGO + ThinLTO benchmark results:\n%s", table)
+    with open(pathjoin(build_dir, "pgo-report.md"), "w") as f:
+        f.write("# PGO + ThinLTO benchmark results\n\n")
+        f.write(table)
+    with open(pathjoin(build_dir, "pgo-report.json"), "w") as f:
+        json.dump({"before": before, "after": after}, f, indent=2)
+
+    return artifacts
+
+
+def run_stress(sanitizer=None, stress_args=()):
+    """Build and run the mini_racer_stress concurrency test.
+
+    The stress test is most useful under a sanitizer; sanitizer may be "tsan" or
+    "asan" (or None for an uninstrumented build, e.g., to measure throughput).
+
+    This reuses the V8 checkout from an ordinary build.
+    """
+
+    build_dir = pathjoin(get_v8_path(), "out.gn", f"stress-{sanitizer or 'none'}")
+    extra_opts = {}
+    if sanitizer is not None:
+        extra_opts[f"is_{sanitizer}"] = "true"
+
+    run_build(build_dir, extra_opts=extra_opts, target="mini_racer_stress")
+
+    exe = "mini_racer_stress.exe" if is_win() else "mini_racer_stress"
+    run(
+        pathjoin(build_dir, exe),
+        *stress_args,
+        cwd=build_dir,
+        extra_env={
+            # Make sanitizer reports fail the run:
+            "TSAN_OPTIONS": "halt_on_error=1 second_deadlock_stack=1",
+            "ASAN_OPTIONS": "halt_on_error=1 detect_leaks=0",
+        },
+    )
+
+
 def clean_v8(out_path):
     for f in get_data_files_list():
         unlink_if_exists(pathjoin(out_path, f))
@@ -458,10 +623,31 @@ if __name__ == "__main__":
     parser.add_argument("--v8-revision", default=V8_VERSION)
     parser.add_argument("--fetch-only", action="store_true", help="Only fetch V8")
     parser.add_argument("--skip-fetch", action="store_true", help="Do not fetch V8")
-    args = parser.parse_args()
-    build_v8(
-        out_path=args.out_path,
-        revision=args.v8_revision,
-        fetch_only=args.fetch_only,
-        skip_fetch=args.skip_fetch,
+    parser.add_argument(
+        "--pgo",
+        action="store_true",
+        help="Build with profile-guided optimization and ThinLTO (3x build time)",
     )
+    parser.add_argument(
+        "--stress",
+        choices=("none", "tsan", "asan"),
+        help="Instead of building the library, build and run the concurrency stress "
+        "test with the given sanitizer",
+    )
+    parser.add_argument(
+        "--stress-seconds", type=int, default=60, help="Stress test duration"
+    )
+    args = parser.parse_args()
+    if args.stress:
+        run_stress(
+            sanitizer=None if args.stress == "none" else args.stress,
+            stress_args=("--seconds", str(args.stress_seconds)),
+        )
+    else:
+        build_v8(
+            out_path=args.out_path,
+            revision=args.v8_revision,
+            fetch_only=args.fetch_only,
+            skip_fetch=args.skip_fetch,
+            pgo=args.pgo,
+        )
@@ -1,10 +1,17 @@
+from py_mini_racer._batch import (
+    JSBatch,
+    JSBatchResult,
+)
 from py_mini_racer._context import (
     PyJsFunctionType,
+    start_trace,
+    stop_trace,
 )
 from py_mini_racer._dll import (
     DEFAULT_V8_FLAGS,
     LibAlreadyInitializedError,
     LibNotFoundError,
+    PlatformConfig,
     init_mini_racer,
 )
 from py_mini_racer._mini_racer import (
@@ -25,6 +32,7 @@ from py_mini_racer._types import (
     JSTimeoutException,
     JSUndefined,
     JSUndefinedType,
+    MicrotaskPolicy,
     PythonJSConvertedTypes,
 )
 from py_mini_racer._value_handle import (
@@ -42,7 +50,12 @@ __all__ = [
     "JSValueError",
     "LibAlreadyInitializedError",
     "LibNotFoundError",
+    "PlatformConfig",
     "init_mini_racer",
+    "JSBatch",
+    "JSBatchResult",
+    "start_trace",
+    "stop_trace",
     "MiniRacer",
     "StrictMiniRacer",
     "JSArray",
@@ -56,6 +69,7 @@ __all__ = [
     "JSTimeoutException",
     "JSUndefined",
     "JSUndefinedType",
+    "MicrotaskPolicy",
     "PythonJSConvertedTypes",
     "PyJsFunctionType",
     "AsyncCleanupType",
@@ -121,6 +121,10 @@ class AbstractContext(ABC):
     def free(self, val_handle: AbstractValueHandle) -> None:
         pass
 
+    @abstractmethod
+    def interned_str(self, address: int, length: int) -> str:
+        pass
+
     @abstractmethod
     def evaluate(
         self,
@@ -0,0 +1,174 @@
+from __future__ import annotations
+
+import ctypes
+from typing import TYPE_CHECKING, Union, cast
+
+from py_mini_racer._types import (
+    JSObject,
+    JSUndefined,
+    JSUndefinedType,
+    PythonJSConvertedTypes,
+)
+from py_mini_racer._value_handle import python_to_value_handle
+
+if TYPE_CHECKING:
+    from py_mini_racer._abstract_context import AbstractValueHandle
+    from py_mini_racer._context import Context
+    from py_mini_racer._value_handle import RawValueHandleType
+
+
+# These mirror MiniRacer::BatchOpCode on the C++ side:
+_OP_GET = 1
+_OP_SET = 2
+_OP_DEL = 3
+_OP_SPLICE = 4
+_OP_CALL = 5
+
+# Operand words with this bit set refer to the result of an earlier operation in
+# the batch, by index:
+_RESULT_REF = 1 << 63
+
+_WORD_MASK = (1 << 64) - 1
+
+
+class JSBatchResult:
+    """A placeholder for the result of an operation in a JSBatch.
+
+    Pass it as an operand to later operations in the same batch, to use the result
+    without first bringing it back to Python."""
+
+    def __init__(self, batch: JSBatch, generation: int, index: int):
+        self._batch = batch
+        self._generation = generation
+        self.index = index
+
+    def _belongs_to(self, batch: JSBatch, generation: int) -> bool:
+        return self._batch is batch and self._generation == generation
+
+
+JSBatchOperand = Union[PythonJSConvertedTypes, JSBatchResult]
+
+
+class JSBatch:
+    """Records operations on JavaScript objects, to run them all at once.
+
+    Each individual operation on a JSObject (e.g., `obj["key"]`) is a separate round
+    trip to the thread which runs JavaScript. A batch runs any number of operations
+    in a single round trip. For example:
+
+        batch = mr.batch()
+        inner = batch.get(obj, "inner")
+        batch.set(inner, "x", 42)
+        batch.call(func, inner, 1, 2)
+        inner_val, _, func_result = batch.run()
+
+    Operations run in order, and stop at the first one which raises an exception
+    (which run() then re-raises).
+    """
+
+    def __init__(self, ctx: Context):
+        self._ctx = ctx
+        self._words: list[int] = []
+        # We keep the handles for our operands open until we run the batch:
+        self._handles: list[AbstractValueHandle] = []
+        self._op_count = 0
+        # Incremented on every run(), to catch stale JSBatchResults:
+        self._generation = 0
+
+    def __len__(self) -> int:
+        return self._op_count
+
+    def get(self, obj: JSBatchOperand, key: JSBatchOperand) -> JSBatchResult:
+        """Record `obj[key]`."""
+
+        return self._add(_OP_GET, [self._value(obj), self._value(key)])
+
+    def set(
+        self, obj: JSBatchOperand, key: JSBatchOperand, val: JSBatchOperand
+    ) -> JSBatchResult:
+        """Record `obj[key] = val`. The result is always True."""
+
+        return self._add(
+            _OP_SET, [self._value(obj), self._value(key), self._value(val)]
+        )
+
+    def delete(self, obj: JSBatchOperand, key: JSBatchOperand) -> JSBatchResult:
+        """Record `delete obj[key]`. Like `del obj[key]` on a JSObject, this raises
+        JSKeyError if the key isn't present."""
+
+        return self._add(_OP_DEL, [self._value(obj), self._value(key)])
+
+    def splice(
+        self,
+        arr: JSBatchOperand,
+        start: int,
+        delete_count: int,
+        *items: JSBatchOperand,
+    ) -> JSBatchResult:
+        """Record `arr.splice(start, delete_count, ...items)`. The result is the
+        array of deleted items."""
+
+        return self._add(
+            _OP_SPLICE,
+            [
+                self._value(arr),
+                start & _WORD_MASK,
+                delete_count & _WORD_MASK,
+                len(items),
+                *(self._value(item) for item in items),
+            ],
+        )
+
+    def call(
+        self,
+        func: JSBatchOperand,
+        *args: JSBatchOperand,
+        this: JSObject | JSUndefinedType | JSBatchResult = JSUndefined,
+    ) -> JSBatchResult:
+        """Record `func.call(this, ...args)`.
+
+        Unlike JSFunction calls, this waits for the function to return, with no
+        timeout."""
+
+        return self._add(
+            _OP_CALL,
+            [
+                self._value(func),
+                self._value(this),
+                len(args),
+                *(self._value(arg) for arg in args),
+            ],
+        )
+
+    def run(self) -> list[PythonJSConvertedTypes]:
+        """Run all recorded operations, and return their results in order.
+
+        This empties the batch, so it can be reused."""
+
+        try:
+            return self._ctx.run_batch(self._words, self._op_count)
+        finally:
+            self._words, self._handles, self._op_count = [], [], 0
+            self._generation += 1
+
+    def _add(self, code: int, operands: list[int]) -> JSBatchResult:
+        self._words.append(code)
+        self._words.extend(operands)
+        result = JSBatchResult(self, self._generation, self._op_count)
+        self._op_count += 1
+        return result
+
+    def _value(self, operand: JSBatchOperand) -> int:
+        if isinstance(operand, JSBatchResult):
+            if not operand._belongs_to(self, self._generation):
+                msg = "JSBatchResult is not from this batch"
+                raise ValueError(msg)
+            return _RESULT_REF | operand.index
+
+        handle = python_to_value_handle(self._ctx, operand)
+        self._handles.append(handle)
+        raw = cast("RawValueHandleType", handle.raw)
+        address = ctypes.cast(raw, ctypes.c_void_p).value
+        if address is None:
+            raise ValueError
+        return address
@@ -1,5 +1,7 @@
 from __future__ import annotations
 
+import atexit
+import ctypes
 from asyncio import (
     FIRST_COMPLETED,
     Task,
@@ -7,8 +9,10 @@ from asyncio import (
     get_running_loop,
     wait,
 )
-from contextlib import asynccontextmanager, contextmanager, suppress
+from collections import deque
+from contextlib import ExitStack, asynccontextmanager, contextmanager, suppress
 from itertools import count
+from threading import RLock
 from traceback import format_exc
 from typing import (
     TYPE_CHECKING,
@@ -16,6 +20,7 @@ from typing import (
     AsyncIterator,
     Awaitable,
     Callable,
+    Iterable,
     Iterator,
     cast,
 )
@@ -36,21 +41,34 @@ from py_mini_racer._types import (
     JSObject,
     JSUndefined,
     JSUndefinedType,
+    MiniRacerBaseException,
     PythonJSConvertedTypes,
 )
 from py_mini_racer._value_handle import (
+    RawValueHandle,
     ValueHandle,
     python_to_value_handle,
 )
 
 if TYPE_CHECKING:
-    import ctypes
     from asyncio import Future
 
     from py_mini_racer._abstract_context import AbstractValueHandle
     from py_mini_racer._numeric import Numeric
+    from py_mini_racer._types import MicrotaskPolicy
     from py_mini_racer._value_handle import RawValueHandleType
 
+# These mirror the layout of mr_platform_stats:
+_PLATFORM_PRIORITIES = ("best_effort", "user_visible", "user_blocking")
+_PLATFORM_PRIORITY_COUNTERS = (
+    "posted",
+    "executed",
+    "queued",
+    "running",
+    "peak_running",
+)
+_PLATFORM_STATS_WORDS = 2 + len(_PLATFORM_PRIORITIES) * len(_PLATFORM_PRIORITY_COUNTERS)
+
 PyJsFunctionType = Callable[..., Awaitable[PythonJSConvertedTypes]]
 AsyncCleanupType = Callable[[], Awaitable[None]]
 
@@ -62,6 +80,39 @@ def context_count() -> int:
     return int(dll.mr_context_count())
 
 
+def start_trace(path: str) -> None:
+    """Start recording all calls into the MiniRacer DLL into a binary trace file.
+
+    The trace captures the sequence, timing, and arguments of calls made by all
+    MiniRacer instances in this process, including all evaluated code and all strings
+    passed into JavaScript. It can be re-executed against another build of the DLL
+    using helpers/trace_replay.py, to measure performance work against a real workload.
+
+    The trace is flushed and closed by stop_trace(), or at interpreter exit.
+    """
+
+    dll = init_mini_racer(ignore_duplicate_init=True)
+    if not dll.mr_start_trace(path.encode("utf-8")):
+        msg = f"Could not start trace at {path} (is a trace already running?)"
+        raise RuntimeError(msg)
+    atexit.register(stop_trace)
+
+
+def stop_trace() -> None:
+    """Stop recording calls into the MiniRacer DLL, and close the trace file."""
+
+    dll = init_mini_racer(ignore_duplicate_init=True)
+    dll.mr_stop_trace()
+    atexit.unregister(stop_trace)
+
+
+def _stop_standby_contexts() -> None:
+    # The DLL's standby fill thread may be building an isolate, so we stop it before
+    # the process (and V8) goes away:
+    dll = init_mini_racer(ignore_duplicate_init=True)
+    dll.mr_set_standby_contexts(0)
+
+
 class _CallbackRegistry:
     def __init__(
         self, raw_handle_wrapper: Callable[[RawValueHandleType], AbstractValueHandle]
@@ -100,11 +151,31 @@ class Context(AbstractContext):
     def __init__(
         self,
         dll: ctypes.CDLL,
+        *,
+        standby: bool = False,
     ) -> None:
+        # Pinned calls in progress; see _call_pinned. (This is reentrant because the
+        # garbage collector can free values, through the pin, while we hold it.)
+        self._pin_lock = RLock()
+        self._pin_calls = 0
         self._dll: ctypes.CDLL | None = dll
 
         self._callback_registry = _CallbackRegistry(self._wrap_raw_handle)
-        self._ctx = dll.mr_init_context(self._callback_registry.mr_callback)
+        init_context = dll.mr_init_standby_context if standby else dll.mr_init_context
+        self._ctx = init_context(self._callback_registry.mr_callback)
+        # Frequent calls go through a pin, which skips the DLL's context lookup:
+        self._pin = dll.mr_context_pin(self._ctx)
+        if not self._pin:
+            msg = "Could not create a MiniRacer context"
+            raise MiniRacerBaseException(msg)
+
+        # Decoded strings from the C++ context's string interning table, keyed by
+        # their (stable) address in that table:
+        self._interned_strs: dict[int, str] = {}
+
+        # Errors from scripts run with exec_script(wait=False):
+        self._deferred_errors: list[JSEvalException] = []
+        self._deferred_errors_callback_id: int | None = None
 
     def _get_dll(self) -> ctypes.CDLL:
         if self._dll is None:
@@ -121,6 +192,26 @@ class Context(AbstractContext):
 
         return bool(self._get_dll().mr_v8_is_using_sandbox())
 
+    def platform_stats(self) -> dict[str, Any]:
+        words = (ctypes.c_uint64 * _PLATFORM_STATS_WORDS)()
+        count = self._get_dll().mr_platform_stats(words, _PLATFORM_STATS_WORDS)
+        values = iter(words[:count])
+        stats: dict[str, Any] = {
+            "worker_threads": next(values, 0),
+            "delayed": next(values, 0),
+        }
+        for priority in _PLATFORM_PRIORITIES:
+            stats[priority] = {
+                counter: next(values, 0) for counter in _PLATFORM_PRIORITY_COUNTERS
+            }
+        return stats
+
+    def set_standby_contexts(self, count: int) -> None:
+        self._get_dll().mr_set_standby_contexts(count)
+        atexit.unregister(_stop_standby_contexts)
+        if count > 0:
+            atexit.register(_stop_standby_contexts)
+
     def evaluate(
         self,
         code: str,
@@ -129,18 +220,63 @@ class Context(AbstractContext):
         code_handle = python_to_value_handle(self, code)
 
         with self._run_mr_task(
-            self._get_dll().mr_eval, self._ctx, code_handle.raw
+            self._call_pinned, "mr_pinned_eval", code_handle.raw
         ) as future:
             return future.get(timeout=timeout_sec)
 
+    def exec_script(
+        self,
+        code: str,
+        timeout_sec: Numeric | None = None,
+    ) -> None:
+        code_handle = python_to_value_handle(self, code)
+
+        with self._run_mr_task(
+            self._call_pinned, "mr_pinned_exec", code_handle.raw, True
+        ) as future:
+            future.get(timeout=timeout_sec)
+
+    def exec_script_nowait(self, code: str) -> None:
+        code_handle = python_to_value_handle(self, code)
+
+        if self._deferred_errors_callback_id is None:
+            # All such scripts share one callback, which only gets called upon
+            # errors (and which we thus never clean up until close):
+            def on_error(value: PythonJSConvertedTypes | JSEvalException) -> None:
+                if isinstance(value, JSEvalException):
+                    self._deferred_errors.append(value)
+
+            self._deferred_errors_callback_id = self._callback_registry.register(
+                on_error
+            )
+
+        # We don't wait for the script. (It's fine to free our code handle
+        # meanwhile; the task holds its own reference.)
+        if not self._call_pinned(
+            "mr_pinned_exec",
+            code_handle.raw,
+            False,
+            self._deferred_errors_callback_id,
+        ):
+            msg = "Could not start script"
+            raise MiniRacerBaseException(msg)
+
+    def raise_deferred_error(self) -> None:
+        """Raise the first error from any exec_script_nowait scripts which have
+        completed since the last call, and forget the rest."""
+
+        if self._deferred_errors:
+            errors, self._deferred_errors = self._deferred_errors, []
+            raise errors[0]
+
     def promise_then(
         self, promise: JSPromise, on_resolved: JSFunction, on_rejected: JSFunction
     ) -> None:
         promise_handle = python_to_value_handle(self, promise)
         then_name_handle = python_to_value_handle(self, "then")
         then_func = self._wrap_raw_handle(
-            self._get_dll().mr_get_object_item(
-                self._ctx,
+            self._call_pinned(
+                "mr_pinned_get_object_item",
                 promise_handle.raw,
                 then_name_handle.raw,
             )
@@ -176,8 +312,8 @@ class Context(AbstractContext):
         key_handle = python_to_value_handle(self, key)
 
         return self._wrap_raw_handle(
-            self._get_dll().mr_get_object_item(
-                self._ctx,
+            self._call_pinned(
+                "mr_pinned_get_object_item",
                 obj_handle.raw,
                 key_handle.raw,
             )
@@ -192,8 +328,8 @@ class Context(AbstractContext):
 
         # Convert the value just to convert any exceptions (and GC the result)
         self._wrap_raw_handle(
-            self._get_dll().mr_set_object_item(
-                self._ctx,
+            self._call_pinned(
+                "mr_pinned_set_object_item",
                 obj_handle.raw,
                 key_handle.raw,
                 val_handle.raw,
@@ -206,8 +342,8 @@ class Context(AbstractContext):
 
         # Convert the value just to convert any exceptions (and GC the result)
         self._wrap_raw_handle(
-            self._get_dll().mr_del_object_item(
-                self._ctx,
+            self._call_pinned(
+                "mr_pinned_del_object_item",
                 obj_handle.raw,
                 key_handle.raw,
             )
@@ -254,14 +390,107 @@ class Context(AbstractContext):
         argv_handle = python_to_value_handle(self, argv)
 
         with self._run_mr_task(
-            self._get_dll().mr_call_function,
-            self._ctx,
+            self._call_pinned,
+            "mr_pinned_call_function",
             func_handle.raw,
             this_handle.raw,
             argv_handle.raw,
         ) as future:
             return future.get(timeout=timeout_sec)
 
+    def call_json(
+        self,
+        expr: str,
+        args_json: str,
+        timeout_sec: Numeric | None = None,
+    ) -> PythonJSConvertedTypes:
+        expr_handle = python_to_value_handle(self, expr)
+        args_json_handle = python_to_value_handle(self, args_json)
+
+        with self._run_mr_task(
+            self._call_pinned,
+            "mr_pinned_call_json",
+            expr_handle.raw,
+            args_json_handle.raw,
+        ) as future:
+            return future.get(timeout=timeout_sec)
+
+    def map_json(
+        self,
+        expr: str,
+        batches_json: Iterable[str],
+        max_in_flight: int,
+        timeout_sec: Numeric | None = None,
+    ) -> Iterator[str]:
+        """Yields the JSON results of mr_map_json for each batch, in order.
+
+        We start up to max_in_flight batches before waiting on the oldest one, so
+        that the isolate thread can work on one batch while we produce the next (or
+        our caller consumes the last)."""
+
+        if max_in_flight < 1:
+            msg = "max_in_flight must be at least 1"
+            raise ValueError(msg)
+
+        expr_handle = python_to_value_handle(self, expr)
+
+        # For each in-flight batch, we hold the task (which the ExitStack cancels,
+        # if we exit early) and the input handle:
+        in_flight: deque[tuple[ExitStack, SyncFuture, AbstractValueHandle]] = deque()
+
+        def finish_oldest() -> str:
+            task_stack, future, _ = in_flight.popleft()
+            with task_stack:
+                return cast(str, future.get(timeout=timeout_sec))
+
+        try:
+            for batch_json in batches_json:
+                if len(in_flight) >= max_in_flight:
+                    yield finish_oldest()
+
+                batch_handle = python_to_value_handle(self, batch_json)
+                task_stack = ExitStack()
+                future = task_stack.enter_context(
+                    self._run_mr_task(
+                        self._get_dll().mr_map_json,
+                        self._ctx,
+                        expr_handle.raw,
+                        batch_handle.raw,
+                    )
+                )
+                in_flight.append((task_stack, future, batch_handle))
+
+            while in_flight:
+                yield finish_oldest()
+        finally:
+            while in_flight:
+                in_flight.popleft()[0].close()
+
+    def run_batch(
+        self, words: list[int], op_count: int
+    ) -> list[PythonJSConvertedTypes]:
+        if op_count == 0:
+            return []
+
+        words_array = (ctypes.c_uint64 * len(words))(*words)
+        results_array = (RawValueHandle * op_count)()
+        result_count = self._get_dll().mr_run_batch(
+            self._ctx, words_array, len(words), results_array, op_count
+        )
+
+        # Wrap everything we got back first, so all handles get freed even if we
+        # raise:
+        results = [
+            self._wrap_raw_handle(results_array[i]).to_python()
+            for i in range(result_count)
+        ]
+        values: list[PythonJSConvertedTypes] = []
+        for result in results:
+            if isinstance(result, JSEvalException):
+                raise result
+            values.append(result)
+        return values
+
     def set_hard_memory_limit(self, limit: int) -> None:
         self._get_dll().mr_set_hard_memory_limit(self._ctx, limit)
 
@@ -277,6 +506,60 @@ class Context(AbstractContext):
     def low_memory_notification(self) -> None:
         self._get_dll().mr_low_memory_notification(self._ctx)
 
+    def trim_memory(self) -> int:
+        return int(self._get_dll().mr_trim_memory(self._ctx))
+
+    def set_idle_trim(self, idle_ms: int) -> None:
+        self._get_dll().mr_set_idle_trim(self._ctx, idle_ms)
+
+    def trim_stats(self) -> str:
+        ret = self._wrap_raw_handle(
+            self._get_dll().mr_trim_stats(self._ctx)
+        ).to_python_or_raise()
+        return cast(str, ret)
+
+    def set_spin_wait(self, microseconds: int) -> None:
+        self._get_dll().mr_set_spin_wait(self._ctx, microseconds)
+
+    def set_microtask_policy(self, policy: MicrotaskPolicy) -> None:
+        if not self._get_dll().mr_set_microtask_policy(self._ctx, int(policy)):
+            msg = f"Invalid microtask policy {policy!r}"
+            raise ValueError(msg)
+
+    def set_task_watchdog(self, threshold_ms: int) -> None:
+        self._get_dll().mr_set_task_watchdog(self._ctx, threshold_ms)
+
+    def task_watchdog_records(self) -> str:
+        ret = self._wrap_raw_handle(
+            self._get_dll().mr_task_watchdog_records(self._ctx)
+        ).to_python_or_raise()
+        return cast(str, ret)
+
+    def install_console(self, capacity: int) -> None:
+        if not self._get_dll().mr_install_console(self._ctx, capacity):
+            msg = f"Invalid console buffer capacity {capacity!r}"
+            raise ValueError(msg)
+
+    def drain_console(self) -> str:
+        ret = self._wrap_raw_handle(
+            self._get_dll().mr_drain_console(self._ctx)
+        ).to_python_or_raise()
+        return cast(str, ret)
+
+    def allow_file_reads(self, directory: str) -> None:
+        b = directory.encode("utf-8")
+        if not self._get_dll().mr_allow_file_reads(self._ctx, b, len(b)):
+            msg = f"Cannot allow file reads from {directory!r}"
+            raise ValueError(msg)
+
+    def pin_isolate_thread(self, cpus: str, numa_node: int) -> None:
+        b = cpus.encode("utf-8")
+        if not self._get_dll().mr_pin_isolate_thread(self._ctx, b, len(b), numa_node):
+            msg = (
+                f"Cannot pin the isolate thread to CPUs {cpus!r}, NUMA node {numa_node}"
+            )
+            raise ValueError(msg)
+
     def heap_stats(self) -> str:
         with self._run_mr_task(self._get_dll().mr_heap_stats, self._ctx) as future:
             return cast(str, future.get())
@@ -287,11 +570,35 @@ class Context(AbstractContext):
         with self._run_mr_task(self._get_dll().mr_heap_snapshot, self._ctx) as future:
             return cast(str, future.get())
 
+    def heap_summary(self, top_n: int) -> str:
+        with self._run_mr_task(
+            self._get_dll().mr_heap_summary, self._ctx, top_n
+        ) as future:
+            return cast(str, future.get())
+
+    def set_heap_growth_baseline(self) -> int:
+        with self._run_mr_task(
+            self._get_dll().mr_set_heap_growth_baseline, self._ctx
+        ) as future:
+            return cast(int, future.get())
+
+    def heap_growth(self, top_n: int) -> str:
+        with self._run_mr_task(
+            self._get_dll().mr_heap_growth, self._ctx, top_n
+        ) as future:
+            return cast(str, future.get())
+
     def value_count(self) -> int:
         """For tests only: how many value handles are still allocated?"""
 
         return int(self._get_dll().mr_value_count(self._ctx))
 
+    def value_stats(self) -> str:
+        ret = self._wrap_raw_handle(
+            self._get_dll().mr_value_stats(self._ctx)
+        ).to_python_or_raise()
+        return cast(str, ret)
+
     @contextmanager
     def js_callback(
         self, func: Callable[[PythonJSConvertedTypes | JSEvalException], None]
@@ -320,8 +627,8 @@ class Context(AbstractContext):
 
     def create_intish_val(self, val: int, typ: int) -> AbstractValueHandle:
         return self._wrap_raw_handle(
-            self._get_dll().mr_alloc_int_val(
-                self._ctx,
+            self._call_pinned(
+                "mr_pinned_alloc_int_val",
                 val,
                 typ,
             )
@@ -329,8 +636,8 @@ class Context(AbstractContext):
 
     def create_doublish_val(self, val: float, typ: int) -> AbstractValueHandle:
         return self._wrap_raw_handle(
-            self._get_dll().mr_alloc_double_val(
-                self._ctx,
+            self._call_pinned(
+                "mr_pinned_alloc_double_val",
                 val,
                 typ,
             )
@@ -339,8 +646,8 @@ class Context(AbstractContext):
     def create_string_val(self, val: str, typ: int) -> AbstractValueHandle:
         b = val.encode("utf-8")
         return self._wrap_raw_handle(
-            self._get_dll().mr_alloc_string_val(
-                self._ctx,
+            self._call_pinned(
+                "mr_pinned_alloc_string_val",
                 b,
                 len(b),
                 typ,
@@ -348,9 +655,52 @@ class Context(AbstractContext):
         )
 
     def free(self, val_handle: AbstractValueHandle) -> None:
-        dll = self._dll
+        # This runs from the garbage collector, possibly after close() (which frees
+        # all the context's values anyway):
+        dll = self._enter_pin()
         if dll is not None:
-            dll.mr_free_value(self._ctx, val_handle.raw)
+            try:
+                dll.mr_pinned_free_value(self._pin, val_handle.raw)
+            finally:
+                self._exit_pin(dll)
+
+    def _enter_pin(self) -> ctypes.CDLL | None:
+        with self._pin_lock:
+            if self._dll is not None:
+                self._pin_calls += 1
+            return self._dll
+
+    def _exit_pin(self, dll: ctypes.CDLL) -> None:
+        with self._pin_lock:
+            self._pin_calls -= 1
+            unpin = self._dll is None and self._pin_calls == 0
+        if unpin:
+            dll.mr_context_unpin(self._pin)
+
+    def _call_pinned(self, name: str, *args: Any) -> Any:
+        """Calls the given mr_pinned_* DLL function with our pin.
+
+        The DLL deletes a pin as soon as it's unpinned, so it must not be used after
+        that. Thus we count pinned calls in progress, and if close() runs (on another
+        thread) meanwhile, we leave unpinning to the last of those calls to finish.
+        Calls which start after close() raise, just as for unpinned calls.
+        """
+
+        dll = self._enter_pin()
+        if dll is None:
+            msg = "Operation on closed Context"
+            raise ValueError(msg)
+        try:
+            return getattr(dll, name)(self._pin, *args)
+        finally:
+            self._exit_pin(dll)
+
+    def interned_str(self, address: int, length: int) -> str:
+        s = self._interned_strs.get(address)
+        if s is None:
+            s = ctypes.string_at(address, length).decode("utf-8")
+            self._interned_strs[address] = s
+        return s
 
     @contextmanager
     def _run_mr_task(self, dll_method: Any, *args: Any) -> Iterator[SyncFuture]:
@@ -465,8 +815,13 @@ callback => {
             await pending_awaiter
 
     def close(self) -> None:
-        dll, self._dll = self._dll, None
+        with self._pin_lock:
+            dll, self._dll = self._dll, None
+            # Otherwise, the last pinned call in progress unpins:
+            unpin = self._pin_calls == 0
         if dll:
+            if unpin:
+                dll.mr_context_unpin(self._pin)
             dll.mr_free_context(self._ctx)
 
     def __del__(self) -> None:
@@ -11,6 +11,7 @@ from threading import Lock
 from typing import (
     Iterable,
     Iterator,
+    NamedTuple,
 )
 
 from py_mini_racer._types import (
@@ -41,9 +42,28 @@ def _build_dll_handle(dll_path: str) -> ctypes.CDLL:
 
     handle.mr_init_v8.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p]
 
+    handle.mr_configure_platform.argtypes = [
+        ctypes.c_uint32,
+        ctypes.c_uint32,
+        ctypes.c_uint32,
+        ctypes.c_bool,
+    ]
+    handle.mr_configure_platform.restype = ctypes.c_bool
+
+    handle.mr_platform_stats.argtypes = [
+        ctypes.POINTER(ctypes.c_uint64),
+        ctypes.c_size_t,
+    ]
+    handle.mr_platform_stats.restype = ctypes.c_size_t
+
+    handle.mr_set_standby_contexts.argtypes = [ctypes.c_uint64]
+
     handle.mr_init_context.argtypes = [MR_CALLBACK]
     handle.mr_init_context.restype = ctypes.c_uint64
 
+    handle.mr_init_standby_context.argtypes = [MR_CALLBACK]
+    handle.mr_init_standby_context.restype = ctypes.c_uint64
+
     handle.mr_eval.argtypes = [
         ctypes.c_uint64,
         RawValueHandle,
@@ -51,6 +71,14 @@ def _build_dll_handle(dll_path: str) -> ctypes.CDLL:
     ]
     handle.mr_eval.restype = ctypes.c_uint64
 
+    handle.mr_exec.argtypes = [
+        ctypes.c_uint64,
+        RawValueHandle,
+        ctypes.c_bool,
+        ctypes.c_uint64,
+    ]
+    handle.mr_exec.restype = ctypes.c_uint64
+
     handle.mr_free_value.argtypes = [ctypes.c_uint64, RawValueHandle]
 
     handle.mr_alloc_int_val.argtypes = [ctypes.c_uint64, ctypes.c_int64, ctypes.c_uint8]
@@ -76,6 +104,11 @@ def _build_dll_handle(dll_path: str) -> ctypes.CDLL:
     handle.mr_context_count.argtypes = []
     handle.mr_context_count.restype = ctypes.c_size_t
 
+    handle.mr_context_pin.argtypes = [ctypes.c_uint64]
+    handle.mr_context_pin.restype = ctypes.c_void_p
+
+    handle.mr_context_unpin.argtypes = [ctypes.c_void_p]
+
     handle.mr_cancel_task.argtypes = [ctypes.c_uint64, ctypes.c_uint64]
 
     handle.mr_heap_stats.argtypes = [
@@ -86,6 +119,45 @@ def _build_dll_handle(dll_path: str) -> ctypes.CDLL:
 
     handle.mr_low_memory_notification.argtypes = [ctypes.c_uint64]
 
+    handle.mr_trim_memory.argtypes = [ctypes.c_uint64]
+    handle.mr_trim_memory.restype = ctypes.c_uint64
+
+    handle.mr_set_idle_trim.argtypes = [ctypes.c_uint64, ctypes.c_uint64]
+
+    handle.mr_trim_stats.argtypes = [ctypes.c_uint64]
+    handle.mr_trim_stats.restype = RawValueHandle
+
+    handle.mr_set_spin_wait.argtypes = [ctypes.c_uint64, ctypes.c_uint64]
+
+    handle.mr_set_microtask_policy.argtypes = [ctypes.c_uint64, ctypes.c_uint8]
+    handle.mr_set_microtask_policy.restype = ctypes.c_bool
+
+    handle.mr_set_task_watchdog.argtypes = [ctypes.c_uint64, ctypes.c_uint64]
+
+    handle.mr_task_watchdog_records.argtypes = [ctypes.c_uint64]
+    handle.mr_task_watchdog_records.restype = RawValueHandle
+
+    handle.mr_install_console.argtypes = [ctypes.c_uint64, ctypes.c_uint64]
+    handle.mr_install_console.restype = ctypes.c_bool
+
+    handle.mr_drain_console.argtypes = [ctypes.c_uint64]
+    handle.mr_drain_console.restype = RawValueHandle
+
+    handle.mr_allow_file_reads.argtypes = [
+        ctypes.c_uint64,
+        ctypes.c_char_p,
+        ctypes.c_uint64,
+    ]
+    handle.mr_allow_file_reads.restype = ctypes.c_bool
+
+    handle.mr_pin_isolate_thread.argtypes = [
+        ctypes.c_uint64,
+        ctypes.c_char_p,
+        ctypes.c_uint64,
+        ctypes.c_int32,
+    ]
+    handle.mr_pin_isolate_thread.restype = ctypes.c_bool
+
     handle.mr_make_js_callback.argtypes = [
         ctypes.c_uint64,
         ctypes.c_uint64,
@@ -98,6 +170,26 @@ def _build_dll_handle(dll_path: str) -> ctypes.CDLL:
     ]
     handle.mr_heap_snapshot.restype = ctypes.c_uint64
 
+    handle.mr_heap_summary.argtypes = [
+        ctypes.c_uint64,
+        ctypes.c_uint64,
+        ctypes.c_uint64,
+    ]
+    handle.mr_heap_summary.restype = ctypes.c_uint64
+
+    handle.mr_set_heap_growth_baseline.argtypes = [
+        ctypes.c_uint64,
+        ctypes.c_uint64,
+    ]
+    handle.mr_set_heap_growth_baseline.restype = ctypes.c_uint64
+
+    handle.mr_heap_growth.argtypes = [
+        ctypes.c_uint64,
+        ctypes.c_uint64,
+        ctypes.c_uint64,
+    ]
+    handle.mr_heap_growth.restype = ctypes.c_uint64
+
     handle.mr_get_identity_hash.argtypes = [
         ctypes.c_uint64,
         RawValueHandle,
@@ -150,6 +242,51 @@ def _build_dll_handle(dll_path: str) -> ctypes.CDLL:
     ]
     handle.mr_call_function.restype = ctypes.c_uint64
 
+    handle.mr_call_json.argtypes = [
+        ctypes.c_uint64,
+        RawValueHandle,
+        RawValueHandle,
+        ctypes.c_uint64,
+    ]
+    handle.mr_call_json.restype = ctypes.c_uint64
+
+    handle.mr_map_json.argtypes = [
+        ctypes.c_uint64,
+        RawValueHandle,
+        RawValueHandle,
+        ctypes.c_uint64,
+    ]
+    handle.mr_map_json.restype = ctypes.c_uint64
+
+    handle.mr_run_batch.argtypes = [
+        ctypes.c_uint64,
+        ctypes.POINTER(ctypes.c_uint64),
+        ctypes.c_size_t,
+        ctypes.POINTER(RawValueHandle),
+        ctypes.c_size_t,
+    ]
+    handle.mr_run_batch.restype = ctypes.c_size_t
+
+    # The mr_pinned_* functions mirror their unpinned equivalents, but take a pin
+    # from mr_context_pin instead of a context ID:
+    for name in (
+        "mr_eval",
+        "mr_exec",
+        "mr_free_value",
+        "mr_alloc_int_val",
+        "mr_alloc_double_val",
+        "mr_alloc_string_val",
+        "mr_get_object_item",
+        "mr_set_object_item",
+        "mr_del_object_item",
+        "mr_call_function",
+        "mr_call_json",
+    ):
+        unpinned = getattr(handle, name)
+        pinned = getattr(handle, name.replace("mr_", "mr_pinned_", 1))
+        pinned.argtypes = [ctypes.c_void_p, *unpinned.argtypes[1:]]
+        pinned.restype = unpinned.restype
+
     handle.mr_set_hard_memory_limit.argtypes = [ctypes.c_uint64, ctypes.c_size_t]
 
     handle.mr_set_soft_memory_limit.argtypes = [ctypes.c_uint64, ctypes.c_size_t]
@@ -170,6 +307,14 @@ def _build_dll_handle(dll_path: str) -> ctypes.CDLL:
     handle.mr_value_count.argtypes = [ctypes.c_uint64]
     handle.mr_value_count.restype = ctypes.c_size_t
 
+    handle.mr_value_stats.argtypes = [ctypes.c_uint64]
+    handle.mr_value_stats.restype = RawValueHandle
+
+    handle.mr_start_trace.argtypes = [ctypes.c_char_p]
+    handle.mr_start_trace.restype = ctypes.c_bool
+
+    handle.mr_stop_trace.argtypes = []
+
     return handle
 
 
@@ -183,6 +328,34 @@ _SNAPSHOT_FILENAME = "snapshot_blob.bin"
 DEFAULT_V8_FLAGS = ("--single-threaded",)
 
 
+class PlatformConfig(NamedTuple):
+    """Settings for how V8 runs background tasks and allocates memory.
+
+    The worker pool settings only apply when V8 runs multi-threaded, i.e., without
+    the --single-threaded flag (which is in DEFAULT_V8_FLAGS). Zero means the default
+    for each: a pool of one fewer thread than cores (up to 16), with no caps short of
+    the pool size.
+
+    Attributes:
+        worker_threads: how many worker threads to run.
+        max_user_visible_workers: how many workers may run user-visible priority
+            tasks at once. V8 uses this priority for most concurrent GC work and
+            optimizing compiles.
+        max_best_effort_workers: how many workers may run best-effort priority tasks
+            at once. V8 uses this priority for, e.g., sweeping and lazy compiles.
+        huge_pages: whether to ask the kernel to back large regions V8 allocates, and
+            large ArrayBuffers, with transparent huge pages, to cut TLB misses on
+            large heaps. This only has an effect on Linux. (In builds with the V8
+            sandbox, V8 allocates most of its heap without going through us, so it
+            mostly affects ArrayBuffers there.)
+    """
+
+    worker_threads: int = 0
+    max_user_visible_workers: int = 0
+    max_best_effort_workers: int = 0
+    huge_pages: bool = False
+
+
 class LibNotFoundError(MiniRacerBaseException):
     """MiniRacer-wrapped V8 build not found."""
 
@@ -218,7 +391,9 @@ def _check_path(path: str) -> None:
 
 
 @contextmanager
-def _open_dll(flags: Iterable[str]) -> Iterator[ctypes.CDLL]:
+def _open_dll(
+    flags: Iterable[str], platform_config: PlatformConfig
+) -> Iterator[ctypes.CDLL]:
     dll_filename = _get_lib_filename("mini_racer")
 
     with ExitStack() as exit_stack:
@@ -240,6 +415,7 @@ def _open_dll(flags: Iterable[str]) -> Iterator[ctypes.CDLL]:
 
         handle = _build_dll_handle(dll_path)
 
+        handle.mr_configure_platform(*platform_config)
         handle.mr_init_v8(
             " ".join(flags).encode("utf-8"),
             icu_data_path.encode("utf-8"),
@@ -255,13 +431,17 @@ _dll_handle = None
 
 
 def init_mini_racer(
-    *, flags: Iterable[str] = DEFAULT_V8_FLAGS, ignore_duplicate_init: bool = False
+    *,
+    flags: Iterable[str] = DEFAULT_V8_FLAGS,
+    ignore_duplicate_init: bool = False,
+    platform_config: PlatformConfig | None = None,
 ) -> ctypes.CDLL:
     """Initialize py_mini_racer (and V8).
 
-    This function can optionally be used to set V8 flags. This function can be called
-    at most once, before any instances of MiniRacer are initialized. Instances of
-    MiniRacer will automatically call this function to initialize MiniRacer and V8.
+    This function can optionally be used to set V8 flags, and to size V8's background
+    worker pool (see PlatformConfig). This function can be called at most once, before
+    any instances of MiniRacer are initialized. Instances of MiniRacer will
+    automatically call this function to initialize MiniRacer and V8.
     """
 
     global _dll_handle_context_manager  # noqa: PLW0603
@@ -269,7 +449,9 @@ def init_mini_racer(
 
     with _init_lock:
         if _dll_handle is None:
-            _dll_handle_context_manager = _open_dll(flags)
+            _dll_handle_context_manager = _open_dll(
+                flags, platform_config or PlatformConfig()
+            )
             _dll_handle = _dll_handle_context_manager.__enter__()
             # Note: we never call _dll_handle_context_manager.__exit__() because it's
             # designed as a singleton. But we could if we wanted to!
@@ -1,20 +1,29 @@
 from __future__ import annotations
 
 import json
+from contextlib import contextmanager
+from itertools import islice
 from json import JSONEncoder
+from os import fspath
 from typing import (
     TYPE_CHECKING,
     Any,
+    Callable,
     ClassVar,
+    Iterable,
+    Iterator,
 )
 
+from py_mini_racer._batch import JSBatch
 from py_mini_racer._context import Context
 from py_mini_racer._dll import init_mini_racer
 from py_mini_racer._set_timeout import INSTALL_SET_TIMEOUT
 from py_mini_racer._types import MiniRacerBaseException
+from py_mini_racer._value_handle import JSOOMException, JSTerminatedException
 
 if TYPE_CHECKING:
     from contextlib import AbstractAsyncContextManager
+    from os import PathLike
     from types import TracebackType
 
     from typing_extensions import Self
@@ -22,7 +31,7 @@ if TYPE_CHECKING:
     from py_mini_racer._context import PyJsFunctionType
     from py_mini_racer._numeric import Numeric
     from py_mini_racer._objects import JSFunction
-    from py_mini_racer._types import PythonJSConvertedTypes
+    from py_mini_racer._types import MicrotaskPolicy, PythonJSConvertedTypes
 
 
 class WrongReturnTypeException(MiniRacerBaseException):
@@ -53,9 +62,14 @@ class MiniRacer:
     json_impl: ClassVar[Any] = json
 
     def __init__(self) -> None:
-        dll = init_mini_racer(ignore_duplicate_init=True)
+        self._dll = init_mini_racer(ignore_duplicate_init=True)
 
-        self._ctx = Context(dll)
+        self._ctx = Context(self._dll)
+        # Setter calls, by setting, to replay on recycled contexts:
+        self._settings: dict[Any, Callable[[Context], None]] = {}
+        self._auto_recycle = False
+        self._on_recycle: Callable[[MiniRacer], None] | None = None
+        self._recycle_count = 0
 
         self.eval(INSTALL_SET_TIMEOUT)
 
@@ -125,7 +139,54 @@ class MiniRacer:
             # Système international d'unités use seconds.
             timeout_sec = timeout / 1000
 
-        return self._ctx.evaluate(code=code, timeout_sec=timeout_sec)
+        with self._recycle_if_poisoned():
+            return self._ctx.evaluate(code=code, timeout_sec=timeout_sec)
+
+    def run_script(
+        self,
+        code: str,
+        *,
+        wait: bool = True,
+        timeout_sec: Numeric | None = None,
+        max_memory: int | None = None,
+    ) -> None:
+        """Run JavaScript code for its side effects only, discarding its result.
+
+        This is cheaper than eval() for setup code (e.g., function definitions and
+        library loading), because it skips converting the value of the last
+        expression in `code` back to Python.
+
+        With wait=False, this only queues up the code to run, and returns
+        immediately. Queued scripts still run in order, before anything evaluated
+        later. Exceptions from queued scripts are raised not here, but by the next
+        call to run_script with wait=True (which thus also waits for all previously
+        queued scripts to finish). That call raises only the first such exception.
+
+        Args:
+            code: JavaScript code
+            wait: whether to wait for the code to finish running
+            timeout_sec: number of seconds after which the execution is interrupted
+                (only when waiting)
+            max_memory: hard memory limit, in bytes, after which the execution is
+                interrupted.
+        """
+
+        if max_memory is not None:
+            self.set_hard_memory_limit(max_memory)
+
+        if not wait:
+            if timeout_sec is not None:
+                msg = "timeout_sec requires wait=True"
+                raise ValueError(msg)
+            self._ctx.exec_script_nowait(code)
+            return
+
+        try:
+            with self._recycle_if_poisoned():
+                self._ctx.exec_script(code, timeout_sec=timeout_sec)
+        finally:
+            # Errors from earlier scripts take precedence:
+            self._ctx.raise_deferred_error()
 
     def execute(
         self,
@@ -177,6 +238,10 @@ class MiniRacer:
         Returned value is serialized to JSON inside the V8 isolate and deserialized
         using `json_impl`.
 
+        `expr` is compiled only once (and re-evaluated, cheaply, on each call), so
+        calling the same `expr` repeatedly with different arguments does not
+        re-parse any JavaScript.
+
         Args:
             expr: JavaScript expression referring to a function
             encoder: Custom JSON encoder
@@ -192,9 +257,63 @@ class MiniRacer:
             # Système international d'unités use seconds.
             timeout_sec = timeout / 1000
 
+        if max_memory is not None:
+            self.set_hard_memory_limit(max_memory)
+
         json_args = self.json_impl.dumps(args, separators=(",", ":"), cls=encoder)
-        js = f"{expr}.apply(this, {json_args})"
-        return self.execute(js, timeout_sec=timeout_sec, max_memory=max_memory)
+        with self._recycle_if_poisoned():
+            ret = self._ctx.call_json(expr, json_args, timeout_sec=timeout_sec)
+        if not isinstance(ret, str):
+            raise WrongReturnTypeException(type(ret))
+        return self.json_impl.loads(ret)
+
+    def map(
+        self,
+        expr: str,
+        records: Iterable[Any],
+        batch_size: int = 1000,
+        max_in_flight: int = 2,
+        encoder: JSONEncoder | None = None,
+        timeout_sec: Numeric | None = None,
+    ) -> Iterator[Any]:
+        """Apply a JavaScript function to each of a stream of records.
+
+        This is the streaming equivalent of calling `call(expr, record)` for each
+        record. Records are serialized using `json_impl` in batches of `batch_size`,
+        and up to `max_in_flight` batches are queued up for V8 at once, so that
+        serializing the next batch (and deserializing the results of the previous
+        one) overlaps with running the function on the current one.
+
+        Results are yielded lazily, in the same order as the records. Results which
+        have no JSON representation (e.g., undefined) come back as None.
+
+        If the function raises for any record, iteration stops with that
+        exception, and any batches still queued up are canceled.
+
+        Args:
+            expr: JavaScript expression referring to a function
+            records: iterable of records to pass to the function, one at a time
+            batch_size: number of records to send to V8 at once
+            max_in_flight: maximum number of batches queued up for V8 at once
+            encoder: Custom JSON encoder
+            timeout_sec: number of seconds to wait for each batch, after which the
+                execution is interrupted.
+        """
+
+        if batch_size < 1:
+            msg = "batch_size must be at least 1"
+            raise ValueError(msg)
+
+        def batches_json() -> Iterator[str]:
+            records_iter = iter(records)
+            while batch := list(islice(records_iter, batch_size)):
+                yield self.json_impl.dumps(batch, separators=(",", ":"), cls=encoder)
+
+        with self._recycle_if_poisoned():
+            for ret in self._ctx.map_json(
+                expr, batches_json(), max_in_flight, timeout_sec=timeout_sec
+            ):
+                yield from self.json_impl.loads(ret)
 
     def wrap_py_function(
         self,
@@ -227,7 +346,7 @@ class MiniRacer:
 
         :param int limit: memory limit in bytes or 0 to reset the limit
         """
-        self._ctx.set_hard_memory_limit(limit)
+        self._apply("hard_memory_limit", lambda ctx: ctx.set_hard_memory_limit(limit))
 
     def set_soft_memory_limit(self, limit: int) -> None:
         """Set a soft memory limit on this V8 isolate.
@@ -237,7 +356,7 @@ class MiniRacer:
 
         :param int limit: memory limit in bytes or 0 to reset the limit
         """
-        self._ctx.set_soft_memory_limit(limit)
+        self._apply("soft_memory_limit", lambda ctx: ctx.set_soft_memory_limit(limit))
 
     def was_hard_memory_limit_reached(self) -> bool:
         """Return true if the hard memory limit was reached on the V8 isolate."""
@@ -247,15 +366,335 @@ class MiniRacer:
         """Return true if the soft memory limit was reached on the V8 isolate."""
         return self._ctx.was_soft_memory_limit_reached()
 
+    def recycle(self) -> None:
+        """Replace the V8 isolate behind this MiniRacer with a fresh one.
+
+        The new isolate starts from the same startup snapshot, with the same
+        settings (memory limits, console buffer, file read directories, and so on),
+        but none of the JavaScript state of the old one. JS objects returned from the
+        old isolate can no longer be used. The old isolate is torn down right away.
+
+        If on_recycle was passed to enable_auto_recycle, it is called afterwards (with
+        this MiniRacer), and can be used to set up the new isolate (e.g., by loading
+        libraries again).
+        """
+
+        new_ctx = Context(self._dll, standby=self._auto_recycle)
+        old_ctx, self._ctx = self._ctx, new_ctx
+        old_ctx.close()
+
+        self.eval(INSTALL_SET_TIMEOUT)
+        for setting in self._settings.values():
+            setting(self._ctx)
+
+        self._recycle_count += 1
+        if self._on_recycle is not None:
+            self._on_recycle(self)
+
+    def enable_auto_recycle(
+        self,
+        standby: int = 1,
+        on_recycle: Callable[[MiniRacer], None] | None = None,
+    ) -> None:
+        """Recycle this MiniRacer (see recycle()) whenever JavaScript hits the hard
+        memory limit, or is otherwise terminated.
+
+        A V8 isolate which ran into the hard memory limit is usually full of live
+        objects, and so tends to hit the limit again on the next request. Likewise,
+        JavaScript which was terminated midway may have left its global state half
+        updated. With auto recycling, the request which fails still raises
+        JSOOMException (or JSTerminatedException), but the next one runs on a fresh
+        isolate.
+
+        To make recycling quick, the MiniRacer DLL keeps `standby` pre-warmed
+        isolates ready to go, rebuilding them in the background as they're used up.
+        The standby isolates are shared by all MiniRacer instances which enable auto
+        recycling (which also set how many to keep, with the last call winning),
+        and are only used to recycle such instances.
+
+        Args:
+            standby: number of pre-warmed isolates to keep ready
+            on_recycle: function to call, with this MiniRacer, after each recycle
+        """
+
+        self._ctx.set_standby_contexts(standby)
+        self._auto_recycle = True
+        self._on_recycle = on_recycle
+
+    @property
+    def recycle_count(self) -> int:
+        """Return how many times this MiniRacer's isolate was recycled."""
+        return self._recycle_count
+
+    def _apply(self, key: Any, setting: Callable[[Context], None]) -> None:
+        setting(self._ctx)
+        self._settings[key] = setting
+
+    @contextmanager
+    def _recycle_if_poisoned(self) -> Iterator[None]:
+        try:
+            yield
+        except (JSOOMException, JSTerminatedException):
+            if self._auto_recycle:
+                self.recycle()
+            raise
+
     def low_memory_notification(self) -> None:
         """Ask the V8 isolate to collect memory more aggressively."""
         self._ctx.low_memory_notification()
 
+    def trim_memory(self) -> int:
+        """Shrink the V8 isolate's memory footprint, e.g., before it sits idle.
+
+        This runs memory-reducing garbage collections, which compact the heap, shrink
+        its young generation, drop the compilation cache, and return freed pages to
+        the OS. They also age the bytecode of functions which haven't run lately, so
+        that V8 eventually drops it (along with any optimized code compiled from it)
+        and recompiles such functions if they're called again.
+
+        This waits for any running JavaScript to finish first, and takes a while on
+        large heaps, so it isn't meant for busy isolates.
+
+        Returns:
+            The number of bytes of heap and malloced memory reclaimed.
+        """
+        return self._ctx.trim_memory()
+
+    def set_idle_trim(self, idle_sec: float | None) -> None:
+        """Trim memory (see trim_memory()) automatically once this MiniRacer has
+        been idle for the given time.
+
+        The isolate counts as idle once it has started no work (eval() calls,
+        function calls, property accesses, timers, and so on) for idle_sec. It is
+        trimmed once per such idle spell. This lets a process hold many mostly idle
+        MiniRacer instances without each one staying at its peak memory usage.
+
+        :param float idle_sec: the idle time in seconds, or None to disable idle
+            trimming
+        """
+        idle_ms = 0 if idle_sec is None else max(1, int(idle_sec * 1000))
+        self._apply("idle_trim", lambda ctx: ctx.set_idle_trim(idle_ms))
+
+    def trim_stats(self) -> Any:
+        """Return memory trim counters.
+
+        This is a dict with keys "trims" (the number of trims, including idle ones),
+        "idle_trims" (the number of idle trims), and "bytes_reclaimed" (the total
+        across all trims).
+        """
+        return self.json_impl.loads(self._ctx.trim_stats())
+
+    def set_spin_wait(self, microseconds: int) -> None:
+        """Trade CPU time for lower latency on small, frequent calls.
+
+        By default, the threads which run JavaScript and which wait for its
+        results block (sleep) as soon as they have nothing to do, and are woken
+        up by the operating system. Each such wakeup costs several microseconds,
+        which dominates simple operations like reading a property of a JSObject
+        in a tight loop. With a nonzero spin wait, those threads instead poll
+        for up to this long before blocking. The poll time adapts to how often
+        it succeeds, so a long-idle MiniRacer will not keep burning CPU.
+
+        :param int microseconds: maximum spin time, or 0 to always block
+        """
+        self._apply("spin_wait", lambda ctx: ctx.set_spin_wait(microseconds))
+
+    def set_microtask_policy(self, policy: MicrotaskPolicy) -> None:
+        """Control when JavaScript microtasks (e.g., Promise reactions) run.
+
+        The default, MicrotaskPolicy.PER_TASK, checks for microtasks after every
+        internal task, including housekeeping which cannot create microtasks.
+        MicrotaskPolicy.AFTER_JAVASCRIPT and MicrotaskPolicy.SCOPED skip that
+        overhead. Promise semantics are the same under all policies.
+
+        :param MicrotaskPolicy policy: the new policy
+        """
+        self._apply("microtask_policy", lambda ctx: ctx.set_microtask_policy(policy))
+
+    def set_task_watchdog(self, threshold_sec: float | None) -> None:
+        """Record tasks which run longer than the given threshold.
+
+        This helps find scripts which stall the context. When a task (like an
+        eval() or function call) runs past the threshold, the context records it,
+        along with the JavaScript stack as of that moment. Read the last 64 records
+        with task_watchdog_records().
+
+        :param float threshold_sec: the threshold in seconds, or None to disable the
+            watchdog
+        """
+        threshold_ms = 0 if threshold_sec is None else max(1, int(threshold_sec * 1000))
+        self._apply("task_watchdog", lambda ctx: ctx.set_task_watchdog(threshold_ms))
+
+    def task_watchdog_records(self) -> Any:
+        """Return the tasks recorded by the task watchdog, oldest first.
+
+        Each record is a dict with keys "id" (which increases with each record),
+        "task_kind" ("javascript" or "no_javascript"), "elapsed_ms" (how long the
+        task had run when recorded), and "stack" (the JavaScript stack, innermost
+        frame first, as a list of dicts with keys "function", "script", "line", and
+        "column").
+        """
+        return self.json_impl.loads(self._ctx.task_watchdog_records())
+
+    def enable_console_buffer(self, capacity: int = 1000) -> None:
+        """Capture console.log, console.info, console.warn, console.error, and
+        console.debug output in a buffer, for drain_console() to collect.
+
+        The console is implemented natively, so logging from a hot loop is cheap.
+        Arguments are formatted much as browsers do, including format specifiers
+        like "%s" and "%d" in the first argument. When the buffer is full, the
+        oldest lines are dropped (and counted).
+
+        :param int capacity: the most lines to hold between drains
+        """
+        self._apply("console", lambda ctx: ctx.install_console(capacity))
+
+    def drain_console(self) -> Any:
+        """Collect and clear the output buffered since enable_console_buffer() (or
+        the last drain).
+
+        The result is a dict with keys "dropped" (how many lines were dropped since
+        the last drain because the buffer was full) and "lines" (a list, oldest
+        first, of [level, text] pairs, where level is "log", "info", "warn",
+        "error", or "debug").
+        """
+        return self.json_impl.loads(self._ctx.drain_console())
+
+    def allow_file_reads(self, directory: str | PathLike[str]) -> None:
+        """Let JavaScript read files from within the given directory.
+
+        The first call installs a global readFileSync(path) function, which
+        returns the contents of the given file as an ArrayBuffer. The file must be
+        within (a subdirectory of) an allowed directory, after resolving symlinks.
+
+        Files are mapped into memory rather than read, so large files cost nothing
+        until JavaScript touches their contents. Writes to the ArrayBuffer do not
+        change the file. Files must not be truncated while mapped.
+
+        File reads are currently only supported on POSIX platforms (i.e., not on
+        Windows).
+
+        :param directory: the directory to allow
+        """
+        path = fspath(directory)
+        self._apply(("allow_file_reads", path), lambda ctx: ctx.allow_file_reads(path))
+
+    def pin_isolate_thread(
+        self, cpus: Iterable[int] | None = None, numa_node: int | None = None
+    ) -> None:
+        """Pin the thread which runs this MiniRacer's JavaScript to given CPUs,
+        and/or NUMA node.
+
+        Given a NUMA node, the thread also prefers that node for its future memory
+        allocations (which include most of the V8 heap), so that JavaScript runs
+        close to its memory. Without CPUs, the thread is pinned to all CPUs of the
+        NUMA node. Memory already allocated is not moved, so it's best to pin a
+        MiniRacer right after creating it.
+
+        This is only supported on Linux.
+
+        :param cpus: the CPUs to run on
+        :param int numa_node: the NUMA node to run on, and allocate memory from
+        """
+
+        cpu_list = "" if cpus is None else ",".join(str(int(cpu)) for cpu in cpus)
+        if not cpu_list and numa_node is None:
+            msg = "Pass cpus, numa_node, or both"
+            raise ValueError(msg)
+        node = -1 if numa_node is None else numa_node
+        self._apply(
+            "pin_isolate_thread", lambda ctx: ctx.pin_isolate_thread(cpu_list, node)
+        )
+
+    def batch(self) -> JSBatch:
+        """Start a batch of object operations, to run in one round trip.
+
+        Reading and writing JSObjects one operation at a time costs a round trip to
+        the JavaScript thread per operation. Operations recorded in a JSBatch run
+        together, and can use each other's results without converting them to
+        Python. See JSBatch for details.
+        """
+        return JSBatch(self._ctx)
+
     def heap_stats(self) -> Any:
         """Return the V8 isolate heap statistics."""
 
         return self.json_impl.loads(self._ctx.heap_stats())
 
+    def heap_summary(self, top_n: int = 20) -> Any:
+        """Summarize the V8 isolate heap by constructor.
+
+        This is a compact alternative to a full heap snapshot, for leak triage.
+        The result is a dict with keys "node_count" and "total_size" (for the whole
+        heap), "columns" (["name", "count", "shallow_size", "retained_size"]), and
+        "rows": one list of those columns per constructor (or other kind of heap
+        object, like "(string)"), largest retained size first.
+
+        A constructor's retained size counts the memory which would be freed if all
+        its objects were.
+
+        :param int top_n: how many rows to return, or 0 for all of them
+        """
+
+        return self.json_impl.loads(self._ctx.heap_summary(top_n))
+
+    def value_stats(self) -> Any:
+        """Break down the values this MiniRacer has handed to Python and not yet
+        freed.
+
+        Python keeps a JavaScript value (and anything it references) alive for as
+        long as it holds a JSObject, JSFunction, etc. wrapping it, so this helps find
+        Python code which leaks them. The result is a dict with keys:
+
+        - "total": the count of all live values,
+        - "strings", "arrays", "objects", "functions", "buffers", "promises",
+          "exceptions", and "other": counts by type,
+        - "string_bytes" and "buffer_bytes": the bytes of string and buffer data
+          held,
+        - "persistents": how many values keep a JavaScript object alive, and
+        - "collector_backlog": how many already-freed V8 objects await deletion.
+        """
+
+        return self.json_impl.loads(self._ctx.value_stats())
+
+    def platform_stats(self) -> Any:
+        """Return counters for the worker pool which runs V8's background tasks
+        (e.g., concurrent GC and compiles).
+
+        The pool is shared by all MiniRacer instances in the process, and only
+        exists when V8 runs multi-threaded (see PlatformConfig); otherwise all
+        counters are zero. The result is a dict with keys "worker_threads",
+        "delayed" (the count of delayed tasks not yet due), and "best_effort",
+        "user_visible", and "user_blocking": one dict per task priority, with keys
+        "posted", "executed", "queued", "running", and "peak_running" (the most
+        tasks of that priority which ever ran at once).
+        """
+
+        return self._ctx.platform_stats()
+
+    def set_heap_growth_baseline(self) -> None:
+        """Record which objects are on the V8 isolate heap now, for heap_growth().
+
+        Calling this again moves the baseline.
+        """
+
+        self._ctx.set_heap_growth_baseline()
+
+    def heap_growth(self, top_n: int = 20) -> Any:
+        """Summarize the objects allocated since set_heap_growth_baseline() which
+        are still alive, by constructor.
+
+        This helps find scripts which leak memory in long-lived contexts. The result
+        is a dict with keys "baseline_object_id", "object_count" and "total_size"
+        (for all the new objects), "columns" (["name", "count", "size"]), and
+        "rows": one list of those columns per constructor, largest size first.
+
+        :param int top_n: how many rows to return, or 0 for all of them
+        :raises JSValueError: if set_heap_growth_baseline() was never called
+        """
+
+        return self.json_impl.loads(self._ctx.heap_growth(top_n))
+
 
 # Compatibility with versions 0.4 & 0.5
 StrictMiniRacer = MiniRacer
@@ -3,6 +3,7 @@
 from __future__ import annotations
 
 from datetime import datetime
+from enum import IntEnum
 from typing import (
     Union,
 )
@@ -28,6 +29,22 @@ class JSObject:
     pass
 
 
+class MicrotaskPolicy(IntEnum):
+    """When to run JavaScript microtasks (e.g., Promise reactions).
+
+    MiniRacer runs JavaScript, Python callbacks, and its own housekeeping as a series
+    of tasks on one thread per isolate. This controls which of those tasks are
+    followed by a microtask checkpoint."""
+
+    # After every task (the default):
+    PER_TASK = 0
+    # After every task which might run JavaScript. Skips checkpoints after internal
+    # tasks like garbage collection of JavaScript object handles held by Python:
+    AFTER_JAVASCRIPT = 1
+    # As each task leaves JavaScript, using V8's scoped microtask policy:
+    SCOPED = 2
+
+
 PythonJSConvertedTypes = Union[
     None,
     JSUndefinedType,
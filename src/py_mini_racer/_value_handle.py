@@ -101,6 +101,7 @@ class MiniRacerTypes:
     symbol = 9
     object = 10
     undefined = 11
+    interned_str_utf8 = 12
 
     function = 100
     shared_array_buffer = 101
@@ -179,11 +180,31 @@ class ValueHandle(AbstractValueHandle):
         # to free up memory, but the C++ side will eventually free it on context
         # teardown either way.
 
-        typ = self._raw.contents.type
-        val = self._raw.contents.value
-        length = self._raw.contents.len
+        # Each access to .contents builds a new ctypes object, so we do it once:
+        contents = self._raw.contents
+        typ = contents.type
+        val = contents.value
+        length = contents.len
 
-        error_info = _ERRORS.get(self._raw.contents.type)
+        # Strings and numbers are by far the most common results, so we check for
+        # them first. (ctypes already converts c_int64 and c_double fields to
+        # Python ints and floats.)
+        if typ == MiniRacerTypes.str_utf8:
+            return val.bytes_val[0:length].decode("utf-8")
+        if typ == MiniRacerTypes.interned_str_utf8:
+            return self.ctx.interned_str(val.value_ptr, length)
+        if typ == MiniRacerTypes.integer:
+            return val.int_val
+        if typ == MiniRacerTypes.double:
+            return val.double_val
+        if typ == MiniRacerTypes.bool:
+            return val.int_val == 1
+        if typ == MiniRacerTypes.null:
+            return None
+        if typ == MiniRacerTypes.undefined:
+            return JSUndefined
+
+        error_info = _ERRORS.get(typ)
         if error_info:
             klass, generic_msg = error_info
 
@@ -192,18 +213,6 @@ class ValueHandle(AbstractValueHandle):
 
             return klass(msg)
 
-        if typ == MiniRacerTypes.null:
-            return None
-        if typ == MiniRacerTypes.undefined:
-            return JSUndefined
-        if typ == MiniRacerTypes.bool:
-            return bool(val.int_val == 1)
-        if typ == MiniRacerTypes.integer:
-            return int(val.int_val)
-        if typ == MiniRacerTypes.double:
-            return float(val.double_val)
-        if typ == MiniRacerTypes.str_utf8:
-            return str(val.bytes_val[0:length].decode("utf-8"))
         if typ == MiniRacerTypes.function:
             return JSFunction(self.ctx, self)
         if typ == MiniRacerTypes.date:
@@ -0,0 +1,102 @@
+#ifndef INCLUDE_MINI_RACER_ADAPTIVE_SPINNER_H
+#define INCLUDE_MINI_RACER_ADAPTIVE_SPINNER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace MiniRacer {
+
+/** Tells the CPU we're in a spin-wait loop (which saves power, and on
+ * hyperthreaded cores, frees up resources for the other thread). */
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield");
+#elif defined(_M_X64) || defined(_M_IX86)
+  _mm_pause();
+#elif defined(_M_ARM64)
+  __yield();
+#else
+  std::this_thread::yield();
+#endif
+}
+
+/** Polls for a condition for a short, self-adjusting time before the caller
+ * gives up and blocks.
+ *
+ * Blocking on a condition variable and being woken up costs a futex syscall
+ * and a context switch on each side, which dominates the round trip time of
+ * small, frequent cross-thread calls. If the condition usually comes true
+ * within a few microseconds, spinning first avoids that cost.
+ *
+ * The spin budget adapts: it shrinks when spins fail (so that an idle thread
+ * quickly stops burning CPU) and grows back when they succeed, up to the
+ * configured maximum. A maximum of zero (the default) disables spinning.
+ */
+class AdaptiveSpinner {
+ public:
+  void SetMaxSpin(std::chrono::nanoseconds max_spin);
+
+  /** Calls poll() until it returns true (and then returns true), or until the
+   * spin budget runs out (and then returns false). */
+  template <typename Poll>
+  auto Spin(Poll poll) -> bool;
+
+ private:
+  // Once the budget shrinks below this, we just stop spinning until the
+  // next success resets it. This keeps an idle thread from waking up every few
+  // nanoseconds forever:
+  static constexpr int64_t kMinSpinNs = 250;
+
+  // Budget updates are racy by design (relaxed loads and stores, no
+  // read-modify-write): this is a heuristic, and several threads may share
+  // one spinner.
+  std::atomic<int64_t> max_spin_ns_{0};
+  std::atomic<int64_t> spin_ns_{0};
+};
+
+inline void AdaptiveSpinner::SetMaxSpin(std::chrono::nanoseconds max_spin) {
+  const int64_t max_spin_ns = std::max<int64_t>(0, max_spin.count());
+  max_spin_ns_.store(max_spin_ns, std::memory_order_relaxed);
+  spin_ns_.store(max_spin_ns, std::memory_order_relaxed);
+}
+
+template <typename Poll>
+inline auto AdaptiveSpinner::Spin(Poll poll) -> bool {
+  const int64_t max_spin_ns = max_spin_ns_.load(std::memory_order_relaxed);
+  if (max_spin_ns == 0) {
+    return poll();
+  }
+
+  const int64_t spin_ns = spin_ns_.load(std::memory_order_relaxed);
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + std::chrono::nanoseconds(spin_ns);
+  do {
+    if (poll()) {
+      if (spin_ns < max_spin_ns) {
+        // Spinning is working. Let the budget grow back toward the maximum.
+        spin_ns_.store(std::min(max_spin_ns, std::max(spin_ns, kMinSpinNs) * 2),
+                       std::memory_order_relaxed);
+      }
+      return true;
+    }
+    CpuRelax();
+  } while (std::chrono::steady_clock::now() < deadline);
+
+  // Spinning didn't pay off, so spin less next time:
+  spin_ns_.store(spin_ns < kMinSpinNs ? 0 : spin_ns / 2,
+                 std::memory_order_relaxed);
+  return false;
+}
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_ADAPTIVE_SPINNER_H
@@ -8,6 +8,7 @@
 #include <v8-primitive.h>
 #include <v8-value.h>
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <ios>
@@ -18,6 +19,7 @@
 #include <string_view>
 #include <utility>
 #include "isolate_object_collector.h"
+#include "string_interner.h"
 
 namespace MiniRacer {
 
@@ -25,7 +27,8 @@ namespace MiniRacer {
 
 BinaryValue::BinaryValue(IsolateObjectDeleter isolate_object_deleter,
                          v8::Local<v8::Context> context,
-                         v8::Local<v8::Value> value)
+                         v8::Local<v8::Value> value,
+                         StringInterner* string_interner)
     : isolate_object_deleter_(isolate_object_deleter) {
   if (value->IsNull()) {
     handle_.type = type_null;
@@ -58,16 +61,8 @@ BinaryValue::BinaryValue(IsolateObjectDeleter isolate_object_deleter,
     const double timestamp = date->ValueOf();
     handle_.double_val = timestamp;
   } else if (value->IsString()) {
-    const v8::Local<v8::String> rstr =
-        value->ToString(context).ToLocalChecked();
-
-    handle_.type = type_str_utf8;
-    handle_.len = static_cast<size_t>(
-        rstr->Utf8Length(context->GetIsolate()));  // in bytes
-    const size_t capacity = handle_.len + 1;
-    msg_.resize(capacity);
-    rstr->WriteUtf8(context->GetIsolate(), msg_.data());
-    handle_.bytes = msg_.data();
+    SaveString(context->GetIsolate(),
+               value->ToString(context).ToLocalChecked(), string_interner);
   } else if (value->IsSharedArrayBuffer() || value->IsArrayBuffer() ||
              value->IsArrayBufferView()) {
     CreateBackingStoreRef(value);
@@ -232,7 +227,8 @@ auto BinaryValue::ToValue(v8::Local<v8::Context> context)
     return v8::Date::New(context, handle_.double_val).ToLocalChecked();
   }
 
-  if (handle_.type == type_str_utf8) {
+  if (handle_.type == type_str_utf8 ||
+      handle_.type == type_interned_str_utf8) {
     return v8::String::NewFromUtf8(isolate, handle_.bytes,
                                    v8::NewStringType::kNormal,
                                    static_cast<int>(handle_.len))
@@ -253,6 +249,33 @@ void BinaryValue::SavePersistentHandle(v8::Isolate* isolate,
                         isolate_object_deleter_};
 }
 
+void BinaryValue::SaveString(v8::Isolate* isolate,
+                             v8::Local<v8::String> str,
+                             StringInterner* string_interner) {
+  handle_.len = static_cast<size_t>(str->Utf8Length(isolate));  // in bytes
+
+  if (string_interner != nullptr && handle_.len <= StringInterner::kMaxLength) {
+    // Short strings fit on the stack, so looking them up costs no allocation:
+    std::array<char, StringInterner::kMaxLength + 1> buf{};
+    str->WriteUtf8(isolate, buf.data(), static_cast<int>(buf.size()));
+    const std::string* interned =
+        string_interner->Intern(std::string_view(buf.data(), handle_.len));
+    if (interned != nullptr) {
+      handle_.type = type_interned_str_utf8;
+      // The Python side only reads through this pointer:
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+      handle_.bytes = const_cast<char*>(interned->data());
+      return;
+    }
+  }
+
+  handle_.type = type_str_utf8;
+  const size_t capacity = handle_.len + 1;
+  msg_.resize(capacity);
+  str->WriteUtf8(isolate, msg_.data());
+  handle_.bytes = msg_.data();
+}
+
 void BinaryValue::CreateBackingStoreRef(v8::Local<v8::Value> value) {
   // For ArrayBuffer and friends, we store a reference to the ArrayBuffer
   // shared_ptr in this BinaryValue instance, and return a pointer
@@ -298,6 +321,14 @@ BinaryValueFactory::BinaryValueFactory(
     IsolateObjectCollector* isolate_object_collector)
     : isolate_object_collector_(isolate_object_collector) {}
 
+auto BinaryValueFactory::NewInterned(v8::Local<v8::Context> context,
+                                     v8::Local<v8::Value> value)
+    -> BinaryValue::Ptr {
+  return std::make_shared<BinaryValue>(
+      IsolateObjectDeleter(isolate_object_collector_), context, value,
+      &string_interner_);
+}
+
 auto BinaryValueRegistry::Remember(BinaryValue::Ptr ptr) -> BinaryValueHandle* {
   const std::lock_guard<std::mutex> lock(mutex_);
   BinaryValueHandle* handle = ptr->GetHandle();
@@ -327,4 +358,55 @@ auto BinaryValueRegistry::Count() -> size_t {
   return values_.size();
 }
 
+auto BinaryValueRegistry::Stats() -> BinaryValueStats {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  BinaryValueStats stats{};
+  stats.total = values_.size();
+  for (const auto& [handle, value] : values_) {
+    if (value->persistent_handle_) {
+      stats.persistents++;
+    }
+    switch (handle->type) {
+      case type_str_utf8:
+        stats.strings++;
+        stats.string_bytes += handle->len;
+        break;
+      case type_interned_str_utf8:
+        // The payload belongs to the StringInterner:
+        stats.strings++;
+        break;
+      case type_array:
+        stats.arrays++;
+        break;
+      case type_object:
+        stats.objects++;
+        break;
+      case type_function:
+        stats.functions++;
+        break;
+      case type_array_buffer:
+      case type_shared_array_buffer:
+        stats.buffers++;
+        stats.buffer_bytes += handle->len;
+        break;
+      case type_promise:
+        stats.promises++;
+        break;
+      case type_execute_exception:
+      case type_parse_exception:
+      case type_oom_exception:
+      case type_timeout_exception:
+      case type_terminated_exception:
+      case type_value_exception:
+      case type_key_exception:
+        stats.exceptions++;
+        stats.string_bytes += handle->len;
+        break;
+      default:
+        stats.other++;
+    }
+  }
+  return stats;
+}
+
 }  // namespace MiniRacer
@@ -6,6 +6,7 @@
 #include <v8-local-handle.h>
 #include <v8-message.h>
 #include <v8-persistent-handle.h>
+#include <v8-primitive.h>
 #include <v8-value.h>
 #include <cstddef>
 #include <cstdint>
@@ -15,6 +16,7 @@
 #include <unordered_map>
 #include <vector>
 #include "isolate_object_collector.h"
+#include "string_interner.h"
 
 namespace MiniRacer {
 
@@ -31,6 +33,9 @@ enum BinaryTypes : uint8_t {
   type_symbol = 9,
   type_object = 10,
   type_undefined = 11,
+  // A string from the context's StringInterner. The bytes pointer doubles as a
+  // stable ID for the string, for as long as the context lives:
+  type_interned_str_utf8 = 12,
 
   type_function = 100,
   type_shared_array_buffer = 101,
@@ -82,7 +87,8 @@ class BinaryValue {
               BinaryTypes result_type);
   BinaryValue(IsolateObjectDeleter isolate_object_deleter,
               v8::Local<v8::Context> context,
-              v8::Local<v8::Value> value);
+              v8::Local<v8::Value> value,
+              StringInterner* string_interner = nullptr);
   BinaryValue(IsolateObjectDeleter isolate_object_deleter,
               v8::Local<v8::Context> context,
               v8::Local<v8::Message> message,
@@ -98,6 +104,9 @@ class BinaryValue {
  private:
   auto GetHandle() -> BinaryValueHandle*;
   void SavePersistentHandle(v8::Isolate* isolate, v8::Local<v8::Value> value);
+  void SaveString(v8::Isolate* isolate,
+                  v8::Local<v8::String> str,
+                  StringInterner* string_interner);
   void CreateBackingStoreRef(v8::Local<v8::Value> value);
 
   IsolateObjectDeleter isolate_object_deleter_;
@@ -116,8 +125,35 @@ class BinaryValueFactory {
   template <typename... Params>
   auto New(Params&&... params) -> BinaryValue::Ptr;
 
+  /** Like New(context, value), but interns short strings (see
+   * StringInterner). Only call this from the isolate's message pump thread. */
+  auto NewInterned(v8::Local<v8::Context> context, v8::Local<v8::Value> value)
+      -> BinaryValue::Ptr;
+
  private:
   IsolateObjectCollector* isolate_object_collector_;
+  StringInterner string_interner_;
+};
+
+/** Counts of remembered values by type, and what they hold onto. */
+struct BinaryValueStats {
+  size_t total;
+  size_t strings;
+  size_t arrays;
+  size_t objects;
+  size_t functions;
+  // ArrayBuffers, SharedArrayBuffers, and views thereof:
+  size_t buffers;
+  size_t promises;
+  size_t exceptions;
+  // Numbers, booleans, dates, symbols, null, and undefined:
+  size_t other;
+  // UTF-8 payload bytes of strings and exceptions:
+  size_t string_bytes;
+  // Bytes of buffer data exposed through buffers:
+  size_t buffer_bytes;
+  // Values which hold a v8::Persistent handle:
+  size_t persistents;
 };
 
 /** We return handles to BinaryValues to the MiniRacer user side (i.e.,
@@ -144,6 +180,10 @@ class BinaryValueRegistry {
   /** Count the total number of remembered values, for test purposes. */
   auto Count() -> size_t;
 
+  /** Break down the remembered values by type. This is O(n) in the number of
+   * values, but doesn't touch the isolate. */
+  auto Stats() -> BinaryValueStats;
+
  private:
   std::mutex mutex_;
   std::unordered_map<BinaryValueHandle*, std::shared_ptr<BinaryValue>> values_;
@@ -0,0 +1,175 @@
+#include "call_tracer.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string_view>
+#include "binary_value.h"
+
+namespace MiniRacer {
+
+namespace {
+
+constexpr std::string_view kTraceMagic = "MRTRACE1";
+
+// Large enough that most records are coalesced into a few big writes:
+constexpr size_t kTraceFileBufferSize = 1 << 20;
+
+auto SteadyNowNs() -> int64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // end anonymous namespace
+
+auto CallTracer::Get() -> CallTracer* {
+  // We intentionally leak this object, so that API calls racing with process
+  // teardown never touch a destroyed tracer:
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  static auto* tracer = new CallTracer();
+  return tracer;
+}
+
+auto CallTracer::Start(const std::filesystem::path& path) -> bool {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ != nullptr) {
+    return false;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  file_ = std::fopen(path.string().c_str(), "wb");
+  if (file_ == nullptr) {
+    return false;
+  }
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  std::setvbuf(file_, nullptr, _IOFBF, kTraceFileBufferSize);
+  std::fwrite(kTraceMagic.data(), 1, kTraceMagic.size(), file_);
+
+  epoch_ns_.store(SteadyNowNs(), std::memory_order_relaxed);
+  generation_.store(++last_generation_, std::memory_order_release);
+  return true;
+}
+
+void CallTracer::Stop() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  generation_.store(0, std::memory_order_release);
+  if (file_ == nullptr) {
+    return;
+  }
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  std::fclose(file_);
+  file_ = nullptr;
+}
+
+auto CallTracer::Generation() const -> uint64_t {
+  return generation_.load(std::memory_order_relaxed);
+}
+
+auto CallTracer::Now() const -> uint64_t {
+  return static_cast<uint64_t>(SteadyNowNs() -
+                               epoch_ns_.load(std::memory_order_relaxed));
+}
+
+void CallTracer::Write(uint64_t generation, std::string_view record) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  // Drop records for calls which started in an earlier trace:
+  if (file_ == nullptr ||
+      generation != generation_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::fwrite(record.data(), 1, record.size(), file_);
+}
+
+TracedCall::TracedCall(TraceOp op, uint64_t context_id)
+    : generation_(CallTracer::Get()->Generation()),
+      op_(op),
+      context_id_(context_id) {
+  if (generation_ != 0) {
+    start_ns_ = CallTracer::Get()->Now();
+  }
+}
+
+TracedCall::~TracedCall() {
+  if (generation_ == 0) {
+    return;
+  }
+
+  auto* tracer = CallTracer::Get();
+  const uint64_t duration_ns = tracer->Now() - start_ns_;
+
+  std::string record;
+  record.reserve(sizeof(op_) + (sizeof(uint64_t) * 3) + sizeof(uint32_t) +
+                 payload_.size());
+  const auto append = [&record](auto val) {
+    record.append(reinterpret_cast<const char*>(&val), sizeof(val));
+  };
+  append(op_);
+  append(context_id_);
+  append(start_ns_);
+  append(duration_ns);
+  append(static_cast<uint32_t>(payload_.size()));
+  record.append(payload_);
+
+  tracer->Write(generation_, record);
+}
+
+void TracedCall::SetContextId(uint64_t context_id) {
+  context_id_ = context_id;
+}
+
+auto TracedCall::U64(uint64_t val) -> TracedCall& {
+  if (generation_ != 0) {
+    Append(TraceTag::kU64);
+    Append(val);
+  }
+  return *this;
+}
+
+auto TracedCall::I64(int64_t val) -> TracedCall& {
+  if (generation_ != 0) {
+    Append(TraceTag::kI64);
+    Append(val);
+  }
+  return *this;
+}
+
+auto TracedCall::F64(double val) -> TracedCall& {
+  if (generation_ != 0) {
+    Append(TraceTag::kF64);
+    Append(val);
+  }
+  return *this;
+}
+
+auto TracedCall::Handle(const BinaryValueHandle* handle) -> TracedCall& {
+  if (generation_ != 0) {
+    // We only record the address here: argument handles come from the caller
+    // and may be invalid, so we don't dereference them.
+    Append(TraceTag::kHandle);
+    Append(reinterpret_cast<uint64_t>(handle));
+  }
+  return *this;
+}
+
+auto TracedCall::Bytes(std::string_view val) -> TracedCall& {
+  if (generation_ != 0) {
+    Append(TraceTag::kBytes);
+    Append(static_cast<uint32_t>(val.size()));
+    payload_.append(val);
+  }
+  return *this;
+}
+
+auto TracedCall::ResultHandle(const BinaryValueHandle* handle) -> TracedCall& {
+  if (generation_ != 0) {
+    Append(TraceTag::kResultHandle);
+    Append(reinterpret_cast<uint64_t>(handle));
+    Append(handle == nullptr ? type_invalid : handle->type);
+    Append(static_cast<uint64_t>(handle == nullptr ? 0 : handle->len));
+  }
+  return *this;
+}
+
+}  // end namespace MiniRacer
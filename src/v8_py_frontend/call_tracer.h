@@ -0,0 +1,186 @@
+#ifndef INCLUDE_MINI_RACER_CALL_TRACER_H
+#define INCLUDE_MINI_RACER_CALL_TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "binary_value.h"
+
+namespace MiniRacer {
+
+/** Identifies which exported API function a trace record describes. */
+enum class TraceOp : uint8_t {
+  kInitContext = 1,
+  kFreeContext = 2,
+  kCallback = 3,
+  kAllocIntVal = 4,
+  kAllocDoubleVal = 5,
+  kAllocStringVal = 6,
+  kFreeValue = 7,
+  kEval = 8,
+  kCallFunction = 9,
+  kCancelTask = 10,
+  kHeapStats = 11,
+  kHeapSnapshot = 12,
+  kMakeJSCallback = 13,
+  kGetIdentityHash = 14,
+  kGetOwnPropertyNames = 15,
+  kGetObjectItem = 16,
+  kSetObjectItem = 17,
+  kDelObjectItem = 18,
+  kSpliceArray = 19,
+  kSetHardMemoryLimit = 20,
+  kSetSoftMemoryLimit = 21,
+  kHardMemoryLimitReached = 22,
+  kSoftMemoryLimitReached = 23,
+  kLowMemoryNotification = 24,
+  kSetSpinWait = 25,
+  kSetMicrotaskPolicy = 26,
+  kCallJSON = 27,
+  kRunBatch = 28,
+  kExec = 29,
+  kSetTaskWatchdog = 30,
+  kTaskWatchdogRecords = 31,
+  kHeapSummary = 32,
+  kSetHeapGrowthBaseline = 33,
+  kHeapGrowth = 34,
+  kValueStats = 35,
+  kInstallConsole = 36,
+  kDrainConsole = 37,
+  kAllowFileReads = 38,
+  kMapJSON = 39,
+  kPinIsolateThread = 40,
+  kTrimMemory = 41,
+  kSetIdleTrim = 42,
+  kTrimStats = 43,
+};
+
+/** Identifies one field within the payload of a trace record. */
+enum class TraceTag : uint8_t {
+  // A uint64_t argument.
+  kU64 = 1,
+  // An int64_t argument.
+  kI64 = 2,
+  // A double argument.
+  kF64 = 3,
+  // A BinaryValueHandle* argument, as a uint64_t address (0 for nullptr).
+  kHandle = 4,
+  // A uint32_t length, followed by that many bytes of argument data.
+  kBytes = 5,
+  // A uint64_t (or bool, or size_t) return value.
+  kResultU64 = 6,
+  // A returned (or called-back) BinaryValueHandle*, as a uint64_t address,
+  // followed by the uint8_t value type and uint64_t value length.
+  kResultHandle = 7,
+};
+
+/** Records calls made through the exported C API into a compact binary file,
+ * so that real workloads can be re-executed later against another build of
+ * this library (see helpers/trace_replay.py).
+ *
+ * A trace file starts with the 8-byte magic "MRTRACE1", followed by records:
+ *
+ *   uint8_t op             (a TraceOp)
+ *   uint64_t context_id
+ *   uint64_t start_ns      (relative to the call to Start())
+ *   uint64_t duration_ns
+ *   uint32_t payload_len
+ *   payload_len bytes of fields, each a TraceTag followed by its data.
+ *
+ * Integers are written in host byte order. Records are written when calls
+ * complete, so readers should sort them by start_ns.
+ *
+ * Handles are recorded by address. Handle addresses are unique among living
+ * handles within the process, which is enough for a replayer to map recorded
+ * handles to the handles it gets back from its own calls.
+ *
+ * Tracing is process-wide and off by default. When off, the cost to each API
+ * call is one relaxed atomic load.
+ */
+class CallTracer {
+ public:
+  static auto Get() -> CallTracer*;
+
+  auto Start(const std::filesystem::path& path) -> bool;
+  void Stop();
+
+  /** Returns the current trace generation, or 0 if not tracing. */
+  [[nodiscard]] auto Generation() const -> uint64_t;
+
+  /** Returns nanoseconds elapsed since the call to Start(). */
+  [[nodiscard]] auto Now() const -> uint64_t;
+
+  void Write(uint64_t generation, std::string_view record);
+
+ private:
+  std::mutex mutex_;
+  std::atomic<uint64_t> generation_{0};
+  std::atomic<int64_t> epoch_ns_{0};
+  uint64_t last_generation_{0};
+  std::FILE* file_{nullptr};
+};
+
+/** Builds, and upon destruction writes, one trace record. Does nothing if
+ * tracing was off when it was constructed. */
+class TracedCall {
+ public:
+  TracedCall(TraceOp op, uint64_t context_id);
+  ~TracedCall();
+
+  TracedCall(const TracedCall&) = delete;
+  auto operator=(const TracedCall&) -> TracedCall& = delete;
+  TracedCall(TracedCall&&) = delete;
+  auto operator=(TracedCall&& other) -> TracedCall& = delete;
+
+  void SetContextId(uint64_t context_id);
+
+  auto U64(uint64_t val) -> TracedCall&;
+  auto I64(int64_t val) -> TracedCall&;
+  auto F64(double val) -> TracedCall&;
+  auto Handle(const BinaryValueHandle* handle) -> TracedCall&;
+  auto Bytes(std::string_view val) -> TracedCall&;
+  auto ResultHandle(const BinaryValueHandle* handle) -> TracedCall&;
+
+  /** Records a return value and passes it through. */
+  template <typename T>
+  auto Result(T val) -> T;
+  auto Result(BinaryValueHandle* handle) -> BinaryValueHandle*;
+
+ private:
+  template <typename T>
+  void Append(T val);
+
+  uint64_t generation_;
+  TraceOp op_;
+  uint64_t context_id_;
+  uint64_t start_ns_{0};
+  std::string payload_;
+};
+
+template <typename T>
+inline void TracedCall::Append(T val) {
+  payload_.append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+template <typename T>
+inline auto TracedCall::Result(T val) -> T {
+  if (generation_ != 0) {
+    Append(TraceTag::kResultU64);
+    Append(static_cast<uint64_t>(val));
+  }
+  return val;
+}
+
+inline auto TracedCall::Result(BinaryValueHandle* handle)
+    -> BinaryValueHandle* {
+  ResultHandle(handle);
+  return handle;
+}
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_CALL_TRACER_H
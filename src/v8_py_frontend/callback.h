@@ -9,6 +9,8 @@ namespace MiniRacer {
 
 using Callback = void (*)(uint64_t, BinaryValueHandle*);
 
+using CallbackFn = std::function<void(uint64_t, BinaryValueHandle*)>;
+
 using RememberValueAndCallback =
     std::function<void(uint64_t, BinaryValue::Ptr)>;
 
@@ -58,11 +58,14 @@ class CancelableTaskManager {
    * We split up these into separate functors to discourage side-channel passing
    * of result data; the caller should follow the CancelableTaskManager's view
    * regarding whether the task was completed or canceled.
+   *
+   * kind is passed along to IsolateManager::Run.
    */
   template <typename Runnable, typename OnCompleted, typename OnCanceled>
   auto Schedule(Runnable runnable,
                 OnCompleted on_completed,
-                OnCanceled on_canceled) -> uint64_t;
+                OnCanceled on_canceled,
+                TaskKind kind = TaskKind::kJavaScript) -> uint64_t;
 
   void Cancel(uint64_t task_id);
 
@@ -98,8 +101,8 @@ class CancelableTask : public CancelableTaskBase {
 template <typename Runnable, typename OnCompleted, typename OnCanceled>
 inline auto CancelableTaskManager::Schedule(Runnable runnable,
                                             OnCompleted on_completed,
-                                            OnCanceled on_canceled)
-    -> uint64_t {
+                                            OnCanceled on_canceled,
+                                            TaskKind kind) -> uint64_t {
   auto task =
       std::make_shared<CancelableTask<Runnable, OnCompleted, OnCanceled>>(
           std::move(runnable), std::move(on_completed), std::move(on_canceled));
@@ -111,7 +114,8 @@ inline auto CancelableTaskManager::Schedule(Runnable runnable,
   std::future<void> fut = isolate_manager_->Run(
       [holder = std::move(task_id_holder), task](v8::Isolate* isolate) mutable {
         task->Run(isolate);
-      });
+      },
+      kind);
 
   task->SetFuture(std::move(fut));
 
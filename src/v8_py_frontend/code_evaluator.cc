@@ -24,6 +24,17 @@ CodeEvaluator::CodeEvaluator(ContextHolder* context,
 
 auto CodeEvaluator::Eval(v8::Isolate* isolate,
                          BinaryValue* code_ptr) -> BinaryValue::Ptr {
+  return Run(isolate, code_ptr, /*discard_result=*/false);
+}
+
+auto CodeEvaluator::Exec(v8::Isolate* isolate,
+                         BinaryValue* code_ptr) -> BinaryValue::Ptr {
+  return Run(isolate, code_ptr, /*discard_result=*/true);
+}
+
+auto CodeEvaluator::Run(v8::Isolate* isolate,
+                        BinaryValue* code_ptr,
+                        bool discard_result) -> BinaryValue::Ptr {
   const v8::Isolate::Scope isolate_scope(isolate);
   const v8::HandleScope handle_scope(isolate);
   const v8::Local<v8::Context> context = context_->Get()->Get(isolate);
@@ -53,6 +64,9 @@ auto CodeEvaluator::Eval(v8::Isolate* isolate,
 
   v8::MaybeLocal<v8::Value> maybe_value = script->Run(context);
   if (!maybe_value.IsEmpty()) {
+    if (discard_result) {
+      return {};
+    }
     return bv_factory_->New(context, maybe_value.ToLocalChecked());
   }
 
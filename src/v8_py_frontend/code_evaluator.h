@@ -20,7 +20,15 @@ class CodeEvaluator {
 
   auto Eval(v8::Isolate* isolate, BinaryValue* code_ptr) -> BinaryValue::Ptr;
 
+  /** Like Eval, but discards the completion value (thus skipping its
+   * conversion into a BinaryValue). Returns an error value, or nullptr on
+   * success. */
+  auto Exec(v8::Isolate* isolate, BinaryValue* code_ptr) -> BinaryValue::Ptr;
+
  private:
+  auto Run(v8::Isolate* isolate, BinaryValue* code_ptr, bool discard_result)
+      -> BinaryValue::Ptr;
+
   ContextHolder* context_;
   BinaryValueFactory* bv_factory_;
   IsolateMemoryMonitor* memory_monitor_;
@@ -4,10 +4,15 @@
 #include <v8-locker.h>
 #include <v8-persistent-handle.h>
 #include <v8-platform.h>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <span>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 #include "binary_value.h"
 #include "callback.h"
 #include "cancelable_task_runner.h"
@@ -17,23 +22,34 @@
 #include "isolate_manager.h"
 #include "isolate_memory_monitor.h"
 #include "js_callback_maker.h"
+#include "json_caller.h"
 #include "object_manipulator.h"
+#include "thread_affinity.h"
 
 namespace MiniRacer {
 
-Context::Context(v8::Platform* platform, Callback callback)
+Context::Context(v8::Platform* platform, CallbackFn callback)
     : isolate_manager_(platform),
       isolate_object_collector_(&isolate_manager_),
       isolate_memory_monitor_(&isolate_manager_),
       bv_factory_(&isolate_object_collector_),
-      callback_([this, callback](uint64_t callback_id, BinaryValue::Ptr val) {
-        callback(callback_id, bv_registry_.Remember(std::move(val)));
+      callback_fn_(std::move(callback)),
+      callback_([this](uint64_t callback_id, BinaryValue::Ptr val) {
+        callback_fn_(callback_id, bv_registry_.Remember(std::move(val)));
       }),
       context_holder_(&isolate_manager_),
       js_callback_maker_(&context_holder_, &bv_factory_, callback_),
       code_evaluator_(&context_holder_, &bv_factory_, &isolate_memory_monitor_),
+      json_caller_(&context_holder_,
+                   &bv_factory_,
+                   &isolate_memory_monitor_,
+                   &isolate_object_collector_),
       heap_reporter_(&bv_factory_),
       object_manipulator_(&context_holder_, &bv_factory_),
+      task_watchdog_(&isolate_manager_),
+      memory_trimmer_(&isolate_manager_),
+      native_console_(&context_holder_),
+      file_reader_(&context_holder_),
       cancelable_task_manager_(&isolate_manager_) {}
 
 Context::~Context() {
@@ -45,14 +61,17 @@ Context::~Context() {
 auto Context::MakeJSCallback(uint64_t callback_id) -> BinaryValueHandle* {
   return bv_registry_.Remember(
       isolate_manager_
-          .Run([this, callback_id](v8::Isolate* isolate) {
-            return js_callback_maker_.MakeJSCallback(isolate, callback_id);
-          })
-          .get());
+          .RunAndAwait(
+              [this, callback_id](v8::Isolate* isolate) {
+                return js_callback_maker_.MakeJSCallback(isolate, callback_id);
+              },
+              TaskKind::kNoJavaScript));
 }
 
 template <typename Runnable>
-auto Context::RunTask(Runnable runnable, uint64_t callback_id) -> uint64_t {
+auto Context::RunTask(Runnable runnable,
+                      uint64_t callback_id,
+                      TaskKind kind) -> uint64_t {
   // Start an async task!
 
   return cancelable_task_manager_.Schedule(
@@ -67,7 +86,8 @@ auto Context::RunTask(Runnable runnable, uint64_t callback_id) -> uint64_t {
         auto err =
             bv_factory_.New("execution terminated", type_terminated_exception);
         callback_(callback_id, err);
-      });
+      },
+      kind);
 }
 
 auto Context::MakeHandleConverter(BinaryValueHandle* handle,
@@ -111,7 +131,7 @@ auto Context::Eval(BinaryValueHandle* code_handle,
   if (!code_hc) {
     return RunTask(
         [err = code_hc.GetErrorPtr()](v8::Isolate* /*isolate*/) { return err; },
-        callback_id);
+        callback_id, TaskKind::kNoJavaScript);
   }
 
   return RunTask(
@@ -121,6 +141,38 @@ auto Context::Eval(BinaryValueHandle* code_handle,
       callback_id);
 }
 
+auto Context::Exec(BinaryValueHandle* code_handle,
+                   bool report_success,
+                   uint64_t callback_id) -> uint64_t {
+  auto code_hc = MakeHandleConverter(code_handle, "Bad handle: code");
+  if (!code_hc) {
+    return RunTask(
+        [err = code_hc.GetErrorPtr()](v8::Isolate* /*isolate*/) { return err; },
+        callback_id, TaskKind::kNoJavaScript);
+  }
+
+  // This is RunTask, except that we only call back on success if asked to:
+  return cancelable_task_manager_.Schedule(
+      /*runnable=*/
+      [code_ptr = code_hc.GetPtr(), this](v8::Isolate* isolate) {
+        return code_evaluator_.Exec(isolate, code_ptr.get());
+      },
+      /*on_completed=*/
+      [this, callback_id, report_success](const BinaryValue::Ptr& err) {
+        if (err) {
+          callback_(callback_id, err);
+        } else if (report_success) {
+          callback_(callback_id, bv_factory_.New(int64_t{0}, type_undefined));
+        }
+      },
+      /*on_canceled=*/
+      [this, callback_id](const BinaryValue::Ptr& /*val*/) {
+        auto err =
+            bv_factory_.New("execution terminated", type_terminated_exception);
+        callback_(callback_id, err);
+      });
+}
+
 void Context::CancelTask(uint64_t task_id) {
   cancelable_task_manager_.Cancel(task_id);
 }
@@ -130,7 +182,31 @@ auto Context::HeapSnapshot(uint64_t callback_id) -> uint64_t {
       [this](v8::Isolate* isolate) {
         return heap_reporter_.HeapSnapshot(isolate);
       },
-      callback_id);
+      callback_id, TaskKind::kNoJavaScript);
+}
+
+auto Context::HeapSummary(uint64_t top_n, uint64_t callback_id) -> uint64_t {
+  return RunTask(
+      [this, top_n](v8::Isolate* isolate) {
+        return heap_reporter_.HeapSummary(isolate, top_n);
+      },
+      callback_id, TaskKind::kNoJavaScript);
+}
+
+auto Context::SetHeapGrowthBaseline(uint64_t callback_id) -> uint64_t {
+  return RunTask(
+      [this](v8::Isolate* isolate) {
+        return heap_reporter_.SetHeapGrowthBaseline(isolate);
+      },
+      callback_id, TaskKind::kNoJavaScript);
+}
+
+auto Context::HeapGrowth(uint64_t top_n, uint64_t callback_id) -> uint64_t {
+  return RunTask(
+      [this, top_n](v8::Isolate* isolate) {
+        return heap_reporter_.HeapGrowth(isolate, top_n);
+      },
+      callback_id, TaskKind::kNoJavaScript);
 }
 
 auto Context::HeapStats(uint64_t callback_id) -> uint64_t {
@@ -138,7 +214,7 @@ auto Context::HeapStats(uint64_t callback_id) -> uint64_t {
       [this](v8::Isolate* isolate) {
         return heap_reporter_.HeapStats(isolate);
       },
-      callback_id);
+      callback_id, TaskKind::kNoJavaScript);
 }
 
 auto Context::GetIdentityHash(BinaryValueHandle* obj_handle)
@@ -150,10 +226,12 @@ auto Context::GetIdentityHash(BinaryValueHandle* obj_handle)
 
   return bv_registry_.Remember(
       isolate_manager_
-          .Run([this, obj_ptr = obj_hc.GetPtr()](v8::Isolate* isolate) {
-            return object_manipulator_.GetIdentityHash(isolate, obj_ptr.get());
-          })
-          .get());
+          .RunAndAwait(
+              [this, obj_ptr = obj_hc.GetPtr()](v8::Isolate* isolate) {
+                return object_manipulator_.GetIdentityHash(isolate,
+                                                           obj_ptr.get());
+              },
+              TaskKind::kNoJavaScript));
 }
 
 auto Context::GetOwnPropertyNames(BinaryValueHandle* obj_handle)
@@ -165,11 +243,11 @@ auto Context::GetOwnPropertyNames(BinaryValueHandle* obj_handle)
 
   return bv_registry_.Remember(
       isolate_manager_
-          .Run([this, obj_ptr = obj_hc.GetPtr()](v8::Isolate* isolate) {
-            return object_manipulator_.GetOwnPropertyNames(isolate,
-                                                           obj_ptr.get());
-          })
-          .get());
+          .RunAndAwait(
+              [this, obj_ptr = obj_hc.GetPtr()](v8::Isolate* isolate) {
+                return object_manipulator_.GetOwnPropertyNames(isolate,
+                                                               obj_ptr.get());
+              }));
 }
 
 auto Context::GetObjectItem(BinaryValueHandle* obj_handle,
@@ -187,12 +265,12 @@ auto Context::GetObjectItem(BinaryValueHandle* obj_handle,
 
   return bv_registry_.Remember(
       isolate_manager_
-          .Run([this, obj_ptr = obj_hc.GetPtr(),
-                key_ptr = key_hc.GetPtr()](v8::Isolate* isolate) mutable {
-            return object_manipulator_.Get(isolate, obj_ptr.get(),
-                                           key_ptr.get());
-          })
-          .get());
+          .RunAndAwait(
+              [this, obj_ptr = obj_hc.GetPtr(),
+               key_ptr = key_hc.GetPtr()](v8::Isolate* isolate) mutable {
+                return object_manipulator_.Get(isolate, obj_ptr.get(),
+                                               key_ptr.get());
+              }));
 }
 
 auto Context::SetObjectItem(BinaryValueHandle* obj_handle,
@@ -216,12 +294,12 @@ auto Context::SetObjectItem(BinaryValueHandle* obj_handle,
 
   return bv_registry_.Remember(
       isolate_manager_
-          .Run([this, obj_ptr = obj_hc.GetPtr(), key_ptr = key_hc.GetPtr(),
-                val_ptr = val_hc.GetPtr()](v8::Isolate* isolate) mutable {
-            return object_manipulator_.Set(isolate, obj_ptr.get(),
-                                           key_ptr.get(), val_ptr.get());
-          })
-          .get());
+          .RunAndAwait(
+              [this, obj_ptr = obj_hc.GetPtr(), key_ptr = key_hc.GetPtr(),
+               val_ptr = val_hc.GetPtr()](v8::Isolate* isolate) mutable {
+                return object_manipulator_.Set(isolate, obj_ptr.get(),
+                                               key_ptr.get(), val_ptr.get());
+              }));
 }
 
 auto Context::DelObjectItem(BinaryValueHandle* obj_handle,
@@ -239,12 +317,12 @@ auto Context::DelObjectItem(BinaryValueHandle* obj_handle,
 
   return bv_registry_.Remember(
       isolate_manager_
-          .Run([this, obj_ptr = obj_hc.GetPtr(),
-                key_ptr = key_hc.GetPtr()](v8::Isolate* isolate) mutable {
-            return object_manipulator_.Del(isolate, obj_ptr.get(),
-                                           key_ptr.get());
-          })
-          .get());
+          .RunAndAwait(
+              [this, obj_ptr = obj_hc.GetPtr(),
+               key_ptr = key_hc.GetPtr()](v8::Isolate* isolate) mutable {
+                return object_manipulator_.Del(isolate, obj_ptr.get(),
+                                               key_ptr.get());
+              }));
 }
 
 auto Context::SpliceArray(BinaryValueHandle* obj_handle,
@@ -269,12 +347,11 @@ auto Context::SpliceArray(BinaryValueHandle* obj_handle,
 
   return bv_registry_.Remember(
       isolate_manager_
-          .Run([this, obj_ptr = obj_hc.GetPtr(), start, delete_count,
-                new_val_ptr](v8::Isolate* isolate) {
+          .RunAndAwait([this, obj_ptr = obj_hc.GetPtr(), start, delete_count,
+                        new_val_ptr](v8::Isolate* isolate) {
             return object_manipulator_.Splice(isolate, obj_ptr.get(), start,
                                               delete_count, new_val_ptr.get());
-          })
-          .get());
+          }));
 }
 
 void Context::FreeBinaryValue(BinaryValueHandle* val) {
@@ -289,21 +366,21 @@ auto Context::CallFunction(BinaryValueHandle* func_handle,
   if (!func_hc) {
     return RunTask(
         [err = func_hc.GetErrorPtr()](v8::Isolate* /*isolate*/) { return err; },
-        callback_id);
+        callback_id, TaskKind::kNoJavaScript);
   }
 
   auto this_hc = MakeHandleConverter(this_handle, "Bad handle: this");
   if (!this_hc) {
     return RunTask(
         [err = this_hc.GetErrorPtr()](v8::Isolate* /*isolate*/) { return err; },
-        callback_id);
+        callback_id, TaskKind::kNoJavaScript);
   }
 
   auto argv_hc = MakeHandleConverter(argv_handle, "Bad handle: argv");
   if (!argv_hc) {
     return RunTask(
         [err = argv_hc.GetErrorPtr()](v8::Isolate* /*isolate*/) { return err; },
-        callback_id);
+        callback_id, TaskKind::kNoJavaScript);
   }
 
   return RunTask(
@@ -315,8 +392,277 @@ auto Context::CallFunction(BinaryValueHandle* func_handle,
       callback_id);
 }
 
+auto Context::RunBatch(const uint64_t* words,
+                       size_t words_len,
+                       BinaryValueHandle** results,
+                       size_t results_len) -> size_t {
+  const std::span<BinaryValueHandle*> results_span(results, results_len);
+  if (results_span.empty()) {
+    return 0;
+  }
+
+  std::vector<BatchOp> ops;
+  BinaryValue::Ptr err = DecodeBatch(words, words_len, &ops);
+  if (!err && ops.size() > results_span.size()) {
+    err = bv_factory_.New("batch results array is too small",
+                          type_value_exception);
+  }
+  if (err) {
+    results_span[0] = bv_registry_.Remember(err);
+    return 1;
+  }
+
+  const std::vector<BinaryValue::Ptr> values =
+      isolate_manager_.RunAndAwait([this, &ops](v8::Isolate* isolate) {
+        return object_manipulator_.RunBatch(isolate, ops);
+      });
+
+  for (size_t i = 0; i < values.size(); i++) {
+    results_span[i] = bv_registry_.Remember(values[i]);
+  }
+  return values.size();
+}
+
+auto Context::DecodeBatch(const uint64_t* words,
+                          size_t words_len,
+                          std::vector<BatchOp>* ops) -> BinaryValue::Ptr {
+  // Value operands with this bit set refer to the result of an earlier
+  // operation in the batch, by index:
+  constexpr uint64_t kResultRef = uint64_t{1} << 63U;
+
+  const std::span<const uint64_t> batch(words, words_len);
+  size_t pos = 0;
+
+  auto truncated = [this]() {
+    return bv_factory_.New("truncated batch", type_value_exception);
+  };
+
+  auto decode_value = [&](BatchOperand* operand) -> BinaryValue::Ptr {
+    if (pos >= batch.size()) {
+      return truncated();
+    }
+    const uint64_t word = batch[pos++];
+
+    if ((word & kResultRef) != 0) {
+      const uint64_t idx = word & ~kResultRef;
+      if (idx >= ops->size()) {
+        return bv_factory_.New("bad result reference in batch",
+                               type_value_exception);
+      }
+      operand->result_index = idx;
+      return {};
+    }
+
+    // NOLINTNEXTLINE(performance-no-int-to-ptr)
+    auto* handle = reinterpret_cast<BinaryValueHandle*>(word);
+    auto handle_hc = MakeHandleConverter(handle, "Bad handle in batch");
+    if (!handle_hc) {
+      return handle_hc.GetErrorPtr();
+    }
+    operand->value = handle_hc.GetPtr();
+    return {};
+  };
+
+  auto decode_int = [&](BatchOperand* operand) -> BinaryValue::Ptr {
+    if (pos >= batch.size()) {
+      return truncated();
+    }
+    operand->int_val = static_cast<int64_t>(batch[pos++]);
+    return {};
+  };
+
+  while (pos < batch.size()) {
+    // Check the whole word, so that (say) 257 doesn't pass as kGet:
+    const uint64_t code = batch[pos++];
+    if (code > static_cast<uint64_t>(BatchOpCode::kCall)) {
+      return bv_factory_.New("bad batch opcode", type_value_exception);
+    }
+    BatchOp op{static_cast<BatchOpCode>(code), {}};
+
+    // Operand kinds: v for a value, and i for an integer. Splice and call
+    // operations end with a variable number of values, preceded by their
+    // count.
+    std::string_view kinds;
+    bool variadic = false;
+    switch (op.code) {
+      case BatchOpCode::kGet:
+      case BatchOpCode::kDel:
+        kinds = "vv";
+        break;
+      case BatchOpCode::kSet:
+        kinds = "vvv";
+        break;
+      case BatchOpCode::kSplice:
+        kinds = "vii";
+        variadic = true;
+        break;
+      case BatchOpCode::kCall:
+        kinds = "vv";
+        variadic = true;
+        break;
+      default:
+        return bv_factory_.New("bad batch opcode", type_value_exception);
+    }
+
+    for (const char kind : kinds) {
+      BatchOperand& operand = op.operands.emplace_back();
+      BinaryValue::Ptr err =
+          (kind == 'i') ? decode_int(&operand) : decode_value(&operand);
+      if (err) {
+        return err;
+      }
+    }
+
+    if (variadic) {
+      if (pos >= batch.size()) {
+        return truncated();
+      }
+      const uint64_t count = batch[pos++];
+      if (count > batch.size() - pos) {
+        return truncated();
+      }
+      for (uint64_t i = 0; i < count; i++) {
+        BinaryValue::Ptr err = decode_value(&op.operands.emplace_back());
+        if (err) {
+          return err;
+        }
+      }
+    }
+
+    ops->push_back(std::move(op));
+  }
+
+  return {};
+}
+
+auto Context::CallJSON(BinaryValueHandle* expr_handle,
+                       BinaryValueHandle* args_json_handle,
+                       uint64_t callback_id) -> uint64_t {
+  auto expr_hc = MakeHandleConverter(expr_handle, "Bad handle: expr");
+  if (!expr_hc) {
+    return RunTask(
+        [err = expr_hc.GetErrorPtr()](v8::Isolate* /*isolate*/) { return err; },
+        callback_id, TaskKind::kNoJavaScript);
+  }
+
+  auto args_json_hc =
+      MakeHandleConverter(args_json_handle, "Bad handle: args_json");
+  if (!args_json_hc) {
+    return RunTask([err = args_json_hc.GetErrorPtr()](
+                       v8::Isolate* /*isolate*/) { return err; },
+                   callback_id, TaskKind::kNoJavaScript);
+  }
+
+  return RunTask(
+      [this, expr_ptr = expr_hc.GetPtr(),
+       args_json_ptr = args_json_hc.GetPtr()](v8::Isolate* isolate) {
+        return json_caller_.Call(isolate, expr_ptr.get(), args_json_ptr.get());
+      },
+      callback_id);
+}
+
+auto Context::MapJSON(BinaryValueHandle* expr_handle,
+                      BinaryValueHandle* records_json_handle,
+                      uint64_t callback_id) -> uint64_t {
+  auto expr_hc = MakeHandleConverter(expr_handle, "Bad handle: expr");
+  if (!expr_hc) {
+    return RunTask(
+        [err = expr_hc.GetErrorPtr()](v8::Isolate* /*isolate*/) { return err; },
+        callback_id, TaskKind::kNoJavaScript);
+  }
+
+  auto records_json_hc =
+      MakeHandleConverter(records_json_handle, "Bad handle: records_json");
+  if (!records_json_hc) {
+    return RunTask([err = records_json_hc.GetErrorPtr()](
+                       v8::Isolate* /*isolate*/) { return err; },
+                   callback_id, TaskKind::kNoJavaScript);
+  }
+
+  return RunTask(
+      [this, expr_ptr = expr_hc.GetPtr(),
+       records_json_ptr = records_json_hc.GetPtr()](v8::Isolate* isolate) {
+        return json_caller_.Map(isolate, expr_ptr.get(),
+                                records_json_ptr.get());
+      },
+      callback_id);
+}
+
+auto Context::TaskWatchdogRecords() -> BinaryValueHandle* {
+  return bv_registry_.Remember(
+      bv_factory_.New(task_watchdog_.GetRecordsJSON(), type_str_utf8));
+}
+
+auto Context::TrimStats() -> BinaryValueHandle* {
+  return bv_registry_.Remember(
+      bv_factory_.New(memory_trimmer_.GetStatsJSON(), type_str_utf8));
+}
+
+auto Context::InstallConsole(size_t capacity) -> bool {
+  if (capacity == 0) {
+    return false;
+  }
+  return isolate_manager_.RunAndAwait(
+      [this, capacity](v8::Isolate* isolate) {
+        native_console_.Install(isolate, capacity);
+        return true;
+      },
+      TaskKind::kNoJavaScript);
+}
+
+auto Context::DrainConsole() -> BinaryValueHandle* {
+  return bv_registry_.Remember(
+      bv_factory_.New(native_console_.Drain(), type_str_utf8));
+}
+
+auto Context::AllowFileReads(std::string_view dir) -> bool {
+  return isolate_manager_.RunAndAwait(
+      [this, dir](v8::Isolate* isolate) {
+        return file_reader_.AllowDirectory(isolate, dir);
+      },
+      TaskKind::kNoJavaScript);
+}
+
+auto Context::PinIsolateThread(std::string_view cpus, int32_t numa_node)
+    -> bool {
+  return isolate_manager_.RunAndAwait(
+      [cpus, numa_node](v8::Isolate* /*isolate*/) {
+        return PinCurrentThread(cpus, numa_node);
+      },
+      TaskKind::kNoJavaScript);
+}
+
 auto Context::BinaryValueCount() -> size_t {
   return bv_registry_.Count();
 }
 
+auto Context::ValueStats() -> BinaryValueHandle* {
+  const BinaryValueStats stats = bv_registry_.Stats();
+  const std::array<std::pair<const char*, size_t>, 13> fields{{
+      {"total", stats.total},
+      {"strings", stats.strings},
+      {"arrays", stats.arrays},
+      {"objects", stats.objects},
+      {"functions", stats.functions},
+      {"buffers", stats.buffers},
+      {"promises", stats.promises},
+      {"exceptions", stats.exceptions},
+      {"other", stats.other},
+      {"string_bytes", stats.string_bytes},
+      {"buffer_bytes", stats.buffer_bytes},
+      {"persistents", stats.persistents},
+      {"collector_backlog", isolate_object_collector_.Backlog()},
+  }};
+
+  std::string json = "{";
+  for (const auto& [name, val] : fields) {
+    if (json.size() > 1) {
+      json.push_back(',');
+    }
+    json.append("\"").append(name).append("\":").append(std::to_string(val));
+  }
+  json.push_back('}');
+  return bv_registry_.Remember(bv_factory_.New(json, type_str_utf8));
+}
+
 }  // end namespace MiniRacer
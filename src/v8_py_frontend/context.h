@@ -2,19 +2,28 @@
 #define INCLUDE_MINI_RACER_CONTEXT_H
 
 #include <v8-platform.h>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
 #include "binary_value.h"
 #include "callback.h"
 #include "cancelable_task_runner.h"
 #include "code_evaluator.h"
 #include "context_holder.h"
+#include "file_reader.h"
 #include "heap_reporter.h"
 #include "isolate_manager.h"
 #include "isolate_memory_monitor.h"
 #include "isolate_object_collector.h"
 #include "js_callback_maker.h"
+#include "json_caller.h"
+#include "memory_trimmer.h"
+#include "native_console.h"
 #include "object_manipulator.h"
+#include "task_watchdog.h"
 
 namespace MiniRacer {
 
@@ -22,7 +31,7 @@ class ValueHandleConverter;
 
 class Context {
  public:
-  explicit Context(v8::Platform* platform, Callback callback);
+  explicit Context(v8::Platform* platform, CallbackFn callback);
   ~Context();
 
   Context(const Context&) = delete;
@@ -30,12 +39,28 @@ class Context {
   Context(Context&&) = delete;
   auto operator=(Context&& other) -> Context& = delete;
 
+  /** Replaces the callback given to the constructor. This is only safe before
+   * the context has run anything, e.g., when handing out a standby context
+   * (see ContextFactory::SetStandbyContexts). */
+  void SetCallback(CallbackFn callback);
+
   void SetHardMemoryLimit(size_t limit);
   void SetSoftMemoryLimit(size_t limit);
 
   [[nodiscard]] auto IsSoftMemoryLimitReached() const -> bool;
   [[nodiscard]] auto IsHardMemoryLimitReached() const -> bool;
   void ApplyLowMemoryNotification();
+  auto TrimMemory() -> uint64_t;
+  void SetIdleTrim(uint64_t idle_ms);
+  auto TrimStats() -> BinaryValueHandle*;
+  void SetSpinWait(uint64_t microseconds);
+  void SetMicrotaskPolicy(MicrotaskPolicy policy);
+  void SetTaskWatchdog(uint64_t threshold_ms);
+  auto TaskWatchdogRecords() -> BinaryValueHandle*;
+  auto InstallConsole(size_t capacity) -> bool;
+  auto DrainConsole() -> BinaryValueHandle*;
+  auto AllowFileReads(std::string_view dir) -> bool;
+  auto PinIsolateThread(std::string_view cpus, int32_t numa_node) -> bool;
 
   void FreeBinaryValue(BinaryValueHandle* val);
   template <typename... Params>
@@ -43,8 +68,14 @@ class Context {
   void CancelTask(uint64_t task_id);
   auto HeapSnapshot(uint64_t callback_id) -> uint64_t;
   auto HeapStats(uint64_t callback_id) -> uint64_t;
+  auto HeapSummary(uint64_t top_n, uint64_t callback_id) -> uint64_t;
+  auto SetHeapGrowthBaseline(uint64_t callback_id) -> uint64_t;
+  auto HeapGrowth(uint64_t top_n, uint64_t callback_id) -> uint64_t;
   auto Eval(BinaryValueHandle* code_handle,
 
+            uint64_t callback_id) -> uint64_t;
+  auto Exec(BinaryValueHandle* code_handle,
+            bool report_success,
             uint64_t callback_id) -> uint64_t;
   auto MakeJSCallback(uint64_t callback_id) -> BinaryValueHandle*;
   auto GetIdentityHash(BinaryValueHandle* obj_handle) -> BinaryValueHandle*;
@@ -65,26 +96,51 @@ class Context {
                     BinaryValueHandle* argv_handle,
 
                     uint64_t callback_id) -> uint64_t;
+  auto RunBatch(const uint64_t* words,
+                size_t words_len,
+                BinaryValueHandle** results,
+                size_t results_len) -> size_t;
+  auto CallJSON(BinaryValueHandle* expr_handle,
+                BinaryValueHandle* args_json_handle,
+                uint64_t callback_id) -> uint64_t;
+  auto MapJSON(BinaryValueHandle* expr_handle,
+               BinaryValueHandle* records_json_handle,
+               uint64_t callback_id) -> uint64_t;
   auto BinaryValueCount() -> size_t;
+  auto ValueStats() -> BinaryValueHandle*;
 
  private:
   template <typename Runnable>
-  auto RunTask(Runnable runnable, uint64_t callback_id) -> uint64_t;
+  auto RunTask(Runnable runnable,
+               uint64_t callback_id,
+               TaskKind kind = TaskKind::kJavaScript) -> uint64_t;
 
   auto MakeHandleConverter(BinaryValueHandle* handle,
                            const char* err_msg) -> ValueHandleConverter;
 
+  /** Decodes a batch (see mr_run_batch). Returns an error value, or nullptr on
+   * success. */
+  auto DecodeBatch(const uint64_t* words,
+                   size_t words_len,
+                   std::vector<BatchOp>* ops) -> BinaryValue::Ptr;
+
   IsolateManager isolate_manager_;
   IsolateObjectCollector isolate_object_collector_;
   IsolateMemoryMonitor isolate_memory_monitor_;
   BinaryValueFactory bv_factory_;
   BinaryValueRegistry bv_registry_;
+  CallbackFn callback_fn_;
   RememberValueAndCallback callback_;
   ContextHolder context_holder_;
   JSCallbackMaker js_callback_maker_;
   CodeEvaluator code_evaluator_;
+  JSONCaller json_caller_;
   HeapReporter heap_reporter_;
   ObjectManipulator object_manipulator_;
+  TaskWatchdog task_watchdog_;
+  MemoryTrimmer memory_trimmer_;
+  NativeConsole native_console_;
+  FileReader file_reader_;
   CancelableTaskManager cancelable_task_manager_;
 };
 
@@ -107,6 +163,10 @@ class ValueHandleConverter {
   BinaryValue::Ptr err_;
 };
 
+inline void Context::SetCallback(CallbackFn callback) {
+  callback_fn_ = std::move(callback);
+}
+
 inline void Context::SetHardMemoryLimit(size_t limit) {
   isolate_memory_monitor_.SetHardMemoryLimit(limit);
 }
@@ -127,6 +187,26 @@ inline void Context::ApplyLowMemoryNotification() {
   isolate_memory_monitor_.ApplyLowMemoryNotification();
 }
 
+inline auto Context::TrimMemory() -> uint64_t {
+  return memory_trimmer_.Trim();
+}
+
+inline void Context::SetIdleTrim(uint64_t idle_ms) {
+  memory_trimmer_.SetIdleThreshold(std::chrono::milliseconds(idle_ms));
+}
+
+inline void Context::SetSpinWait(uint64_t microseconds) {
+  isolate_manager_.SetSpinWait(std::chrono::microseconds(microseconds));
+}
+
+inline void Context::SetMicrotaskPolicy(MicrotaskPolicy policy) {
+  isolate_manager_.SetMicrotaskPolicy(policy);
+}
+
+inline void Context::SetTaskWatchdog(uint64_t threshold_ms) {
+  task_watchdog_.SetThreshold(std::chrono::milliseconds(threshold_ms));
+}
+
 template <typename... Params>
 inline auto Context::AllocBinaryValue(Params&&... params)
     -> BinaryValueHandle* {
@@ -1,42 +1,138 @@
 #include "context_factory.h"
 #include <libplatform/libplatform.h>
 #include <v8-initialization.h>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include "callback.h"
 #include "context.h"
 #include "gsl_stub.h"
+#include "huge_pages.h"
+#include "worker_pool_platform.h"
 
 namespace MiniRacer {
 
 gsl::owner<ContextFactory*> ContextFactory::singleton_ = nullptr;
 std::once_flag ContextFactory::init_flag_;
+std::mutex ContextFactory::platform_config_mutex_;
+PlatformConfig ContextFactory::platform_config_{};
+bool ContextFactory::platform_configurable_ = true;
 
 void ContextFactory::Init(const std::string& v8_flags,
                           const std::filesystem::path& icu_path,
                           const std::filesystem::path& snapshot_path) {
   std::call_once(init_flag_, [v8_flags, icu_path, snapshot_path] {
-    singleton_ = new ContextFactory(v8_flags, icu_path, snapshot_path);
+    PlatformConfig platform_config{};
+    {
+      const std::lock_guard<std::mutex> lock(platform_config_mutex_);
+      platform_config = platform_config_;
+      platform_configurable_ = false;
+    }
+    singleton_ = new ContextFactory(v8_flags, icu_path, snapshot_path,
+                                    platform_config);
   });
 }
 
+auto ContextFactory::ConfigurePlatform(const PlatformConfig& config) -> bool {
+  const std::lock_guard<std::mutex> lock(platform_config_mutex_);
+  if (!platform_configurable_) {
+    return false;
+  }
+  platform_config_ = config;
+  return true;
+}
+
 auto ContextFactory::Get() -> ContextFactory* {
   // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
   return singleton_;
 }
 
-auto ContextFactory::MakeContext(Callback callback) -> uint64_t {
-  // Actually create the context before we get the lock, in case the program is
-  // making Contexts in other threads:
-  auto context = std::make_shared<Context>(current_platform_.get(), callback);
+auto ContextFactory::MakeContext(CallbackFn callback, bool use_standby)
+    -> uint64_t {
+  std::shared_ptr<Context> context;
+  if (use_standby) {
+    const std::lock_guard<std::mutex> lock(standby_mutex_);
+    if (!standby_.empty()) {
+      context = std::move(standby_.back());
+      standby_.pop_back();
+      standby_cv_.notify_one();
+    }
+  }
+
+  if (context) {
+    context->SetCallback(std::move(callback));
+  } else {
+    // Actually create the context before we get the lock, in case the program
+    // is making Contexts in other threads:
+    context = std::make_shared<Context>(message_loop_platform_,
+                                        std::move(callback));
+  }
 
   return contexts_.MakeId(context);
 }
 
+void ContextFactory::SetStandbyContexts(size_t count) {
+  const std::lock_guard<std::mutex> thread_lock(standby_thread_mutex_);
+  std::vector<std::shared_ptr<Context>> excess;
+  bool stop_thread = false;
+  {
+    const std::lock_guard<std::mutex> lock(standby_mutex_);
+    standby_target_ = count;
+    while (standby_.size() > count) {
+      excess.push_back(std::move(standby_.back()));
+      standby_.pop_back();
+    }
+    if (count == 0) {
+      stop_thread = standby_thread_.joinable();
+      standby_stop_ = stop_thread;
+    } else if (!standby_thread_.joinable()) {
+      standby_stop_ = false;
+      standby_thread_ = std::thread(&ContextFactory::FillStandby, this);
+    }
+  }
+  standby_cv_.notify_all();
+
+  // Tearing down a context joins its message loop thread, which can take a
+  // while, so we do it (and wait for the fill thread, which may be building a
+  // context) outside the mutex:
+  if (stop_thread) {
+    standby_thread_.join();
+  }
+  excess.clear();
+}
+
+void ContextFactory::FillStandby() {
+  std::unique_lock<std::mutex> lock(standby_mutex_);
+  while (true) {
+    standby_cv_.wait(lock, [this] {
+      return standby_stop_ || standby_.size() < standby_target_;
+    });
+    if (standby_stop_) {
+      return;
+    }
+    lock.unlock();
+    // The callback is filled in by MakeContext:
+    auto context = std::make_shared<Context>(message_loop_platform_,
+                                             CallbackFn());
+    lock.lock();
+    if (!standby_stop_ && standby_.size() < standby_target_) {
+      standby_.push_back(std::move(context));
+    } else {
+      // The target went down while we were building this one:
+      lock.unlock();
+      context.reset();
+      lock.lock();
+    }
+  }
+}
+
 void ContextFactory::FreeContext(uint64_t context_id) {
   contexts_.EraseId(context_id);
 }
@@ -50,19 +146,41 @@ auto ContextFactory::Count() -> size_t {
   return contexts_.CountIds();
 }
 
+auto ContextFactory::GetPlatformStats() -> PlatformStats {
+  if (worker_pool_platform_ == nullptr) {
+    return {};
+  }
+  return worker_pool_platform_->GetStats();
+}
+
 ContextFactory::ContextFactory(const std::string& v8_flags,
                                const std::filesystem::path& icu_path,
-                               const std::filesystem::path& snapshot_path) {
+                               const std::filesystem::path& snapshot_path,
+                               const PlatformConfig& platform_config) {
   v8::V8::InitializeICU(icu_path.string().c_str());
   v8::V8::InitializeExternalStartupDataFromFile(snapshot_path.string().c_str());
 
   if (!v8_flags.empty()) {
     v8::V8::SetFlagsFromString(v8_flags.c_str());
   }
-  if (v8_flags.find("--single-threaded") != std::string::npos) {
+  SetHugePagesEnabled(platform_config.huge_pages);
+
+  const bool single_threaded =
+      v8_flags.find("--single-threaded") != std::string::npos;
+  if (single_threaded && !platform_config.huge_pages) {
     current_platform_ = v8::platform::NewSingleThreadedDefaultPlatform();
+    message_loop_platform_ = current_platform_.get();
   } else {
-    current_platform_ = v8::platform::NewDefaultPlatform();
+    // When multi-threaded, we give the default platform a single worker
+    // thread, which stays idle: V8 posts all background work to the
+    // WorkerPoolPlatform instead.
+    auto worker_pool_platform = std::make_unique<WorkerPoolPlatform>(
+        single_threaded ? v8::platform::NewSingleThreadedDefaultPlatform()
+                        : v8::platform::NewDefaultPlatform(1),
+        platform_config, single_threaded);
+    message_loop_platform_ = worker_pool_platform->GetDefaultPlatform();
+    worker_pool_platform_ = worker_pool_platform.get();
+    current_platform_ = std::move(worker_pool_platform);
   }
   v8::V8::InitializePlatform(current_platform_.get());
   v8::V8::Initialize();
@@ -2,16 +2,20 @@
 #define INCLUDE_MINI_RACER_CONTEXT_FACTORY_H
 
 #include <v8-platform.h>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 #include "callback.h"
 #include "context.h"
 #include "gsl_stub.h"
 #include "id_maker.h"
+#include "worker_pool_platform.h"
 
 namespace MiniRacer {
 
@@ -21,21 +25,63 @@ class ContextFactory {
                    const std::filesystem::path& icu_path,
                    const std::filesystem::path& snapshot_path);
 
+  /** Sets up the platform which Init will create. Returns false if V8 is
+   * already initialized. */
+  static auto ConfigurePlatform(const PlatformConfig& config) -> bool;
+
   static auto Get() -> ContextFactory*;
-  auto MakeContext(Callback callback) -> uint64_t;
+  /** Makes a new context. With use_standby, this hands out a standby context
+   * (see SetStandbyContexts), if there is one, instead of building a new
+   * context from scratch. */
+  auto MakeContext(CallbackFn callback, bool use_standby = false) -> uint64_t;
   auto GetContext(uint64_t context_id) -> std::shared_ptr<Context>;
   void FreeContext(uint64_t context_id);
   auto Count() -> size_t;
+  /** Returns stats for the background worker pool (all zero when V8 runs
+   * single-threaded). */
+  auto GetPlatformStats() -> PlatformStats;
+  /** Keeps count pre-warmed contexts (each with its isolate created and its
+   * v8::Context set up) on standby, for MakeContext calls which ask for them.
+   * We rebuild standby contexts on a background thread as they're used up.
+   * Zero discards the standby contexts, and stops and joins that thread (which
+   * may first have to finish building a context). The factory itself is never
+   * destroyed, so this is the only way to stop the thread before exit. */
+  void SetStandbyContexts(size_t count);
+
+  ContextFactory(const ContextFactory&) = delete;
+  auto operator=(const ContextFactory&) -> ContextFactory& = delete;
+  ContextFactory(ContextFactory&&) = delete;
+  auto operator=(ContextFactory&& other) -> ContextFactory& = delete;
 
  private:
   ContextFactory(const std::string& v8_flags,
                  const std::filesystem::path& icu_path,
-                 const std::filesystem::path& snapshot_path);
+                 const std::filesystem::path& snapshot_path,
+                 const PlatformConfig& platform_config);
 
   static std::once_flag init_flag_;
   static gsl::owner<ContextFactory*> singleton_;
+  static std::mutex platform_config_mutex_;
+  static PlatformConfig platform_config_;
+  static bool platform_configurable_;
   std::unique_ptr<v8::Platform> current_platform_;
+  // The libplatform default platform, which runs our message loops. This is
+  // current_platform_ itself, or the platform it wraps:
+  v8::Platform* message_loop_platform_{nullptr};
+  WorkerPoolPlatform* worker_pool_platform_{nullptr};
   IdMaker<Context> contexts_;
+  std::mutex standby_mutex_;
+  std::condition_variable standby_cv_;
+  size_t standby_target_{0};
+  std::vector<std::shared_ptr<Context>> standby_;
+  bool standby_stop_{false};
+  // Serializes starting and stopping standby_thread_, so that we can join it
+  // without holding standby_mutex_:
+  std::mutex standby_thread_mutex_;
+  // Started by SetStandbyContexts with a nonzero count, and stopped with zero:
+  std::thread standby_thread_;
+
+  void FillStandby();
 };
 
 }  // namespace MiniRacer
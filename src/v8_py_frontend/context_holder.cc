@@ -7,24 +7,32 @@
 #include <memory>
 #include <utility>
 #include "isolate_manager.h"
+#include "web_builtins.h"
 
 namespace MiniRacer {
 
 ContextHolder::ContextHolder(IsolateManager* isolate_manager)
     : isolate_manager_(isolate_manager),
       context_(isolate_manager_
-                   ->Run([](v8::Isolate* isolate) {
-                     const v8::Isolate::Scope isolate_scope(isolate);
-                     const v8::HandleScope handle_scope(isolate);
+                   ->Run(
+                       [](v8::Isolate* isolate) {
+                         const v8::Isolate::Scope isolate_scope(isolate);
+                         const v8::HandleScope handle_scope(isolate);
 
-                     return std::make_unique<v8::Persistent<v8::Context>>(
-                         isolate, v8::Context::New(isolate));
-                   })
+                         const v8::Local<v8::Context> context =
+                             v8::Context::New(isolate);
+                         WebBuiltins::Install(isolate, context);
+                         return std::make_unique<v8::Persistent<v8::Context>>(
+                             isolate, context);
+                       },
+                       TaskKind::kNoJavaScript)
                    .get()) {}
 
 ContextHolder::~ContextHolder() {
   isolate_manager_
-      ->Run([context = std::move(context_)](v8::Isolate*) { context->Reset(); })
+      ->Run([context = std::move(context_)](
+                v8::Isolate* /*isolate*/) { context->Reset(); },
+            TaskKind::kNoJavaScript)
       .get();
 }
 
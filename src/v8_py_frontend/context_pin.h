@@ -0,0 +1,97 @@
+#ifndef INCLUDE_MINI_RACER_CONTEXT_PIN_H
+#define INCLUDE_MINI_RACER_CONTEXT_PIN_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace MiniRacer {
+
+class Context;
+
+/** A direct reference to a Context, which lets hot API calls skip the
+ * ContextFactory lookup (a process-wide mutex, a hash map probe, and a
+ * std::shared_ptr copy) on every call.
+ *
+ * A pin is reference counted. The pin itself holds one reference, which Unpin
+ * releases, and each call made through the pin holds another for its duration
+ * (see PinnedCall). Whichever release comes last deletes the pin, along with
+ * its reference to the Context. So freeing the context ID (or unpinning)
+ * while other threads are mid-call through the pin is safe, but, just as with
+ * a BinaryValueHandle, the caller must not start new calls through a pin after
+ * unpinning it. */
+class ContextPin {
+ public:
+  ContextPin(uint64_t context_id, std::shared_ptr<Context> context);
+
+  [[nodiscard]] auto GetContextId() const -> uint64_t;
+  [[nodiscard]] auto GetContext() const -> Context*;
+
+  void Ref();
+  void Unref();
+
+ private:
+  // Only Unref deletes pins:
+  ~ContextPin() = default;
+
+  uint64_t context_id_;
+  std::shared_ptr<Context> context_;
+  std::atomic<uint64_t> refs_{1};
+};
+
+/** Holds a reference on a ContextPin for the duration of one API call. */
+class PinnedCall {
+ public:
+  explicit PinnedCall(ContextPin* pin);
+  ~PinnedCall();
+
+  PinnedCall(const PinnedCall&) = delete;
+  auto operator=(const PinnedCall&) -> PinnedCall& = delete;
+  PinnedCall(PinnedCall&&) = delete;
+  auto operator=(PinnedCall&&) -> PinnedCall& = delete;
+
+  auto operator->() const -> Context*;
+
+ private:
+  ContextPin* pin_;
+};
+
+inline ContextPin::ContextPin(uint64_t context_id,
+                              std::shared_ptr<Context> context)
+    : context_id_(context_id), context_(std::move(context)) {}
+
+inline auto ContextPin::GetContextId() const -> uint64_t {
+  return context_id_;
+}
+
+inline auto ContextPin::GetContext() const -> Context* {
+  return context_.get();
+}
+
+inline void ContextPin::Ref() {
+  refs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void ContextPin::Unref() {
+  if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+    delete this;
+  }
+}
+
+inline PinnedCall::PinnedCall(ContextPin* pin) : pin_(pin) {
+  pin_->Ref();
+}
+
+inline PinnedCall::~PinnedCall() {
+  pin_->Unref();
+}
+
+inline auto PinnedCall::operator->() const -> Context* {
+  return pin_->GetContext();
+}
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_CONTEXT_PIN_H
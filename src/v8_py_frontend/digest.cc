@@ -0,0 +1,397 @@
+#include "digest.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace MiniRacer {
+
+namespace {
+
+constexpr std::array<uint32_t, 5> kSha1Init = {
+    0x67452301U, 0xefcdab89U, 0x98badcfeU, 0x10325476U, 0xc3d2e1f0U,
+};
+
+constexpr std::array<uint32_t, 8> kSha256Init = {
+    0x6a09e667U, 0xbb67ae85U, 0x3c6ef372U, 0xa54ff53aU,
+    0x510e527fU, 0x9b05688cU, 0x1f83d9abU, 0x5be0cd19U,
+};
+
+constexpr std::array<uint32_t, 64> kSha256K = {
+    0x428a2f98U, 0x71374491U, 0xb5c0fbcfU, 0xe9b5dba5U,
+    0x3956c25bU, 0x59f111f1U, 0x923f82a4U, 0xab1c5ed5U,
+    0xd807aa98U, 0x12835b01U, 0x243185beU, 0x550c7dc3U,
+    0x72be5d74U, 0x80deb1feU, 0x9bdc06a7U, 0xc19bf174U,
+    0xe49b69c1U, 0xefbe4786U, 0x0fc19dc6U, 0x240ca1ccU,
+    0x2de92c6fU, 0x4a7484aaU, 0x5cb0a9dcU, 0x76f988daU,
+    0x983e5152U, 0xa831c66dU, 0xb00327c8U, 0xbf597fc7U,
+    0xc6e00bf3U, 0xd5a79147U, 0x06ca6351U, 0x14292967U,
+    0x27b70a85U, 0x2e1b2138U, 0x4d2c6dfcU, 0x53380d13U,
+    0x650a7354U, 0x766a0abbU, 0x81c2c92eU, 0x92722c85U,
+    0xa2bfe8a1U, 0xa81a664bU, 0xc24b8b70U, 0xc76c51a3U,
+    0xd192e819U, 0xd6990624U, 0xf40e3585U, 0x106aa070U,
+    0x19a4c116U, 0x1e376c08U, 0x2748774cU, 0x34b0bcb5U,
+    0x391c0cb3U, 0x4ed8aa4aU, 0x5b9cca4fU, 0x682e6ff3U,
+    0x748f82eeU, 0x78a5636fU, 0x84c87814U, 0x8cc70208U,
+    0x90befffaU, 0xa4506cebU, 0xbef9a3f7U, 0xc67178f2U,
+};
+
+constexpr std::array<uint64_t, 8> kSha384Init = {
+    0xcbbb9d5dc1059ed8ULL, 0x629a292a367cd507ULL,
+    0x9159015a3070dd17ULL, 0x152fecd8f70e5939ULL,
+    0x67332667ffc00b31ULL, 0x8eb44a8768581511ULL,
+    0xdb0c2e0d64f98fa7ULL, 0x47b5481dbefa4fa4ULL,
+};
+
+constexpr std::array<uint64_t, 8> kSha512Init = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+    0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL,
+};
+
+constexpr std::array<uint64_t, 80> kSha512K = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL,
+    0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+    0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL,
+    0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL,
+    0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+    0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL,
+    0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL,
+    0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+    0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL,
+    0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL,
+    0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+    0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL,
+    0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL,
+    0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+    0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL,
+    0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL,
+    0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+    0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL,
+    0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL,
+    0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+    0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL,
+};
+
+constexpr uint64_t kXxPrime1 = 0x9e3779b185ebca87ULL;
+constexpr uint64_t kXxPrime2 = 0xc2b2ae3d27d4eb4fULL;
+constexpr uint64_t kXxPrime3 = 0x165667b19e3779f9ULL;
+constexpr uint64_t kXxPrime4 = 0x85ebca77c2b2ae63ULL;
+constexpr uint64_t kXxPrime5 = 0x27d4eb2f165667c5ULL;
+
+// We assemble words byte by byte, which compilers turn into single (possibly
+// byte-swapped) loads, regardless of the host's endianness.
+
+auto LoadBE32(const uint8_t* ptr) -> uint32_t {
+  return (static_cast<uint32_t>(ptr[0]) << 24U) |
+         (static_cast<uint32_t>(ptr[1]) << 16U) |
+         (static_cast<uint32_t>(ptr[2]) << 8U) | static_cast<uint32_t>(ptr[3]);
+}
+
+auto LoadBE64(const uint8_t* ptr) -> uint64_t {
+  return (static_cast<uint64_t>(LoadBE32(ptr)) << 32U) | LoadBE32(ptr + 4);
+}
+
+auto LoadLE32(const uint8_t* ptr) -> uint32_t {
+  return static_cast<uint32_t>(ptr[0]) |
+         (static_cast<uint32_t>(ptr[1]) << 8U) |
+         (static_cast<uint32_t>(ptr[2]) << 16U) |
+         (static_cast<uint32_t>(ptr[3]) << 24U);
+}
+
+auto LoadLE64(const uint8_t* ptr) -> uint64_t {
+  return static_cast<uint64_t>(LoadLE32(ptr)) |
+         (static_cast<uint64_t>(LoadLE32(ptr + 4)) << 32U);
+}
+
+template <typename Word>
+void StoreBE(Word word, uint8_t* ptr) {
+  for (size_t i = 0; i < sizeof(Word); i++) {
+    ptr[i] = static_cast<uint8_t>(word >> (8 * (sizeof(Word) - 1 - i)));
+  }
+}
+
+template <typename Word>
+auto Rotl(Word word, unsigned bits) -> Word {
+  return (word << bits) | (word >> ((sizeof(Word) * 8) - bits));
+}
+
+template <typename Word>
+auto Rotr(Word word, unsigned bits) -> Word {
+  return (word >> bits) | (word << ((sizeof(Word) * 8) - bits));
+}
+
+void Sha1Compress(std::array<uint32_t, 5>* state, const uint8_t* block) {
+  std::array<uint32_t, 80> sched{};
+  for (size_t t = 0; t < 16; t++) {
+    sched[t] = LoadBE32(block + (4 * t));
+  }
+  for (size_t t = 16; t < 80; t++) {
+    sched[t] = Rotl(sched[t - 3] ^ sched[t - 8] ^ sched[t - 14] ^ sched[t - 16],
+                    1);
+  }
+
+  auto [a, b, c, d, e] = *state;
+  for (size_t t = 0; t < 80; t++) {
+    uint32_t f = 0;
+    uint32_t k = 0;
+    if (t < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5a827999U;
+    } else if (t < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ed9eba1U;
+    } else if (t < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8f1bbcdcU;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xca62c1d6U;
+    }
+    const uint32_t temp = Rotl(a, 5) + f + e + k + sched[t];
+    e = d;
+    d = c;
+    c = Rotl(b, 30);
+    b = a;
+    a = temp;
+  }
+
+  (*state)[0] += a;
+  (*state)[1] += b;
+  (*state)[2] += c;
+  (*state)[3] += d;
+  (*state)[4] += e;
+}
+
+/** The SHA-2 compression function, which SHA-256 runs on 32-bit words and
+ * SHA-384 and SHA-512 run on 64-bit words, with different rotations. */
+template <typename Word, size_t kRounds>
+void Sha2Compress(std::array<Word, 8>* state,
+                  const std::array<Word, kRounds>& round_constants,
+                  const uint8_t* block) {
+  constexpr bool kWide = sizeof(Word) == 8;
+  auto load = [](const uint8_t* ptr) -> Word {
+    if constexpr (kWide) {
+      return LoadBE64(ptr);
+    } else {
+      return LoadBE32(ptr);
+    }
+  };
+  auto sum0 = [](Word x) -> Word {
+    return kWide ? Rotr(x, 28) ^ Rotr(x, 34) ^ Rotr(x, 39)
+                 : Rotr(x, 2) ^ Rotr(x, 13) ^ Rotr(x, 22);
+  };
+  auto sum1 = [](Word x) -> Word {
+    return kWide ? Rotr(x, 14) ^ Rotr(x, 18) ^ Rotr(x, 41)
+                 : Rotr(x, 6) ^ Rotr(x, 11) ^ Rotr(x, 25);
+  };
+  auto sigma0 = [](Word x) -> Word {
+    return kWide ? Rotr(x, 1) ^ Rotr(x, 8) ^ (x >> 7U)
+                 : Rotr(x, 7) ^ Rotr(x, 18) ^ (x >> 3U);
+  };
+  auto sigma1 = [](Word x) -> Word {
+    return kWide ? Rotr(x, 19) ^ Rotr(x, 61) ^ (x >> 6U)
+                 : Rotr(x, 17) ^ Rotr(x, 19) ^ (x >> 10U);
+  };
+
+  std::array<Word, kRounds> sched{};
+  for (size_t t = 0; t < 16; t++) {
+    sched[t] = load(block + (sizeof(Word) * t));
+  }
+  for (size_t t = 16; t < kRounds; t++) {
+    sched[t] = sigma1(sched[t - 2]) + sched[t - 7] + sigma0(sched[t - 15]) +
+               sched[t - 16];
+  }
+
+  auto [a, b, c, d, e, f, g, h] = *state;
+  for (size_t t = 0; t < kRounds; t++) {
+    const Word temp1 =
+        h + sum1(e) + ((e & f) ^ (~e & g)) + round_constants[t] + sched[t];
+    const Word temp2 = sum0(a) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + temp1;
+    d = c;
+    c = b;
+    b = a;
+    a = temp1 + temp2;
+  }
+
+  (*state)[0] += a;
+  (*state)[1] += b;
+  (*state)[2] += c;
+  (*state)[3] += d;
+  (*state)[4] += e;
+  (*state)[5] += f;
+  (*state)[6] += g;
+  (*state)[7] += h;
+}
+
+/** Runs compress over data, and then the Merkle-Damgard padding (0x80, zeros,
+ * and the big-endian bit length, in kLengthBytes bytes). */
+template <size_t kBlockBytes, size_t kLengthBytes, typename Compress>
+void HashBlocks(std::string_view data, Compress compress) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+  const size_t whole = data.size() - (data.size() % kBlockBytes);
+  for (size_t i = 0; i < whole; i += kBlockBytes) {
+    compress(bytes + i);
+  }
+
+  std::array<uint8_t, 2 * kBlockBytes> tail{};
+  const size_t rest = data.size() - whole;
+  if (rest > 0) {
+    std::memcpy(tail.data(), bytes + whole, rest);
+  }
+  tail.at(rest) = 0x80;
+  const size_t tail_len =
+      rest + 1 + kLengthBytes <= kBlockBytes ? kBlockBytes : 2 * kBlockBytes;
+  const uint64_t size = data.size();
+  // The bit length, as a (up to) 128-bit number:
+  StoreBE<uint64_t>(size << 3U, tail.data() + tail_len - 8);
+  if constexpr (kLengthBytes == 16) {
+    StoreBE<uint64_t>(size >> 61U, tail.data() + tail_len - 16);
+  }
+  for (size_t i = 0; i < tail_len; i += kBlockBytes) {
+    compress(tail.data() + i);
+  }
+}
+
+template <typename Word, size_t kRounds>
+void Sha2(std::string_view data,
+          std::array<Word, 8> state,
+          const std::array<Word, kRounds>& round_constants,
+          size_t out_words,
+          uint8_t* out) {
+  HashBlocks<16 * sizeof(Word), 2 * sizeof(Word)>(
+      data, [&state, &round_constants](const uint8_t* block) {
+        Sha2Compress(&state, round_constants, block);
+      });
+  for (size_t i = 0; i < out_words; i++) {
+    StoreBE(state.at(i), out + (i * sizeof(Word)));
+  }
+}
+
+auto XxRound(uint64_t acc, uint64_t input) -> uint64_t {
+  acc += input * kXxPrime2;
+  acc = Rotl(acc, 31);
+  return acc * kXxPrime1;
+}
+
+auto XxMerge(uint64_t acc, uint64_t val) -> uint64_t {
+  acc ^= XxRound(0, val);
+  return (acc * kXxPrime1) + kXxPrime4;
+}
+
+}  // end anonymous namespace
+
+auto DigestSize(DigestAlgorithm algorithm) -> size_t {
+  switch (algorithm) {
+    case DigestAlgorithm::kSha1:
+      return 20;
+    case DigestAlgorithm::kSha256:
+      return 32;
+    case DigestAlgorithm::kSha384:
+      return 48;
+    case DigestAlgorithm::kSha512:
+      return 64;
+  }
+  return 0;
+}
+
+void Digest(DigestAlgorithm algorithm, std::string_view data, uint8_t* out) {
+  switch (algorithm) {
+    case DigestAlgorithm::kSha1: {
+      std::array<uint32_t, 5> state = kSha1Init;
+      HashBlocks<64, 8>(data, [&state](const uint8_t* block) {
+        Sha1Compress(&state, block);
+      });
+      for (size_t i = 0; i < state.size(); i++) {
+        StoreBE(state.at(i), out + (4 * i));
+      }
+      return;
+    }
+    case DigestAlgorithm::kSha256:
+      Sha2(data, kSha256Init, kSha256K, 8, out);
+      return;
+    case DigestAlgorithm::kSha384:
+      Sha2(data, kSha384Init, kSha512K, 6, out);
+      return;
+    case DigestAlgorithm::kSha512:
+      Sha2(data, kSha512Init, kSha512K, 8, out);
+      return;
+  }
+}
+
+auto XxHash64(std::string_view data, uint64_t seed) -> uint64_t {
+  const auto* ptr = reinterpret_cast<const uint8_t*>(data.data());
+  const uint8_t* const end = ptr + data.size();
+  uint64_t hash = 0;
+
+  if (data.size() >= 32) {
+    // Four independent lanes, which keeps the CPU's multipliers busy:
+    uint64_t v1 = seed + kXxPrime1 + kXxPrime2;
+    uint64_t v2 = seed + kXxPrime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - kXxPrime1;
+    for (; end - ptr >= 32; ptr += 32) {
+      v1 = XxRound(v1, LoadLE64(ptr));
+      v2 = XxRound(v2, LoadLE64(ptr + 8));
+      v3 = XxRound(v3, LoadLE64(ptr + 16));
+      v4 = XxRound(v4, LoadLE64(ptr + 24));
+    }
+    hash = Rotl(v1, 1) + Rotl(v2, 7) + Rotl(v3, 12) + Rotl(v4, 18);
+    hash = XxMerge(hash, v1);
+    hash = XxMerge(hash, v2);
+    hash = XxMerge(hash, v3);
+    hash = XxMerge(hash, v4);
+  } else {
+    hash = seed + kXxPrime5;
+  }
+
+  hash += data.size();
+  for (; end - ptr >= 8; ptr += 8) {
+    hash ^= XxRound(0, LoadLE64(ptr));
+    hash = (Rotl(hash, 27) * kXxPrime1) + kXxPrime4;
+  }
+  if (end - ptr >= 4) {
+    hash ^= LoadLE32(ptr) * kXxPrime1;
+    hash = (Rotl(hash, 23) * kXxPrime2) + kXxPrime3;
+    ptr += 4;
+  }
+  for (; ptr < end; ptr++) {
+    hash ^= *ptr * kXxPrime5;
+    hash = Rotl(hash, 11) * kXxPrime1;
+  }
+
+  hash ^= hash >> 33U;
+  hash *= kXxPrime2;
+  hash ^= hash >> 29U;
+  hash *= kXxPrime3;
+  hash ^= hash >> 32U;
+  return hash;
+}
+
+}  // end namespace MiniRacer
@@ -0,0 +1,32 @@
+#ifndef INCLUDE_MINI_RACER_DIGEST_H
+#define INCLUDE_MINI_RACER_DIGEST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace MiniRacer {
+
+enum class DigestAlgorithm : uint8_t {
+  kSha1,
+  kSha256,
+  kSha384,
+  kSha512,
+};
+
+/** Returns the size, in bytes, of the given algorithm's digests. */
+auto DigestSize(DigestAlgorithm algorithm) -> size_t;
+
+/** Hashes data, writing DigestSize(algorithm) bytes to out.
+ *
+ * We hash whole blocks straight from data, and copy only the final, padded,
+ * block(s), so that callers can pass (say) an ArrayBuffer's backing store
+ * directly. */
+void Digest(DigestAlgorithm algorithm, std::string_view data, uint8_t* out);
+
+/** Computes the (non-cryptographic) XXH64 hash of data. */
+auto XxHash64(std::string_view data, uint64_t seed) -> uint64_t;
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_DIGEST_H
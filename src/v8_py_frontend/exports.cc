@@ -1,16 +1,29 @@
 #include "exports.h"
 #include <v8-initialization.h>
 #include <v8-version-string.h>
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
 #include "binary_value.h"
+#include "call_tracer.h"
 #include "callback.h"
 #include "context.h"
 #include "context_factory.h"
+#include "context_pin.h"
+#include "worker_pool_platform.h"
 
 namespace {
+using MiniRacer::PinnedCall;
+using MiniRacer::TracedCall;
+using MiniRacer::TraceOp;
+
 auto GetContext(uint64_t context_id) -> std::shared_ptr<MiniRacer::Context> {
   auto* context_factory = MiniRacer::ContextFactory::Get();
   if (context_factory == nullptr) {
@@ -18,6 +31,31 @@ auto GetContext(uint64_t context_id) -> std::shared_ptr<MiniRacer::Context> {
   }
   return context_factory->GetContext(context_id);
 }
+
+auto InitContext(MiniRacer::Callback callback, bool use_standby) -> uint64_t {
+  TracedCall trace(TraceOp::kInitContext, 0);
+  auto* context_factory = MiniRacer::ContextFactory::Get();
+  if (context_factory == nullptr) {
+    return 0;
+  }
+
+  // We wrap the callback so that, if tracing, we can record each callback
+  // along with its context ID. We only learn the ID once the context exists,
+  // but the context can't call back before we return it to the caller anyway.
+  auto traced_context_id = std::make_shared<std::atomic<uint64_t>>(0);
+  const uint64_t context_id = context_factory->MakeContext(
+      [callback, traced_context_id](uint64_t callback_id,
+                                    MiniRacer::BinaryValueHandle* val) {
+        TracedCall callback_trace(TraceOp::kCallback,
+                                  traced_context_id->load());
+        callback_trace.U64(callback_id).ResultHandle(val);
+        callback(callback_id, val);
+      },
+      use_standby);
+  traced_context_id->store(context_id);
+  trace.SetContextId(context_id);
+  return trace.Result(context_id);
+}
 }  // end anonymous namespace
 
 // This lint check wants us to make classes to encompass parameters, which
@@ -29,11 +67,26 @@ auto GetContext(uint64_t context_id) -> std::shared_ptr<MiniRacer::Context> {
 LIB_EXPORT auto mr_eval(uint64_t context_id,
                         MiniRacer::BinaryValueHandle* code_handle,
                         uint64_t callback_id) -> uint64_t {
+  TracedCall trace(TraceOp::kEval, context_id);
+  trace.Handle(code_handle).U64(callback_id);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return 0;
+  }
+  return trace.Result(context->Eval(code_handle, callback_id));
+}
+
+LIB_EXPORT auto mr_exec(uint64_t context_id,
+                        MiniRacer::BinaryValueHandle* code_handle,
+                        bool report_success,
+                        uint64_t callback_id) -> uint64_t {
+  TracedCall trace(TraceOp::kExec, context_id);
+  trace.Handle(code_handle).U64(report_success ? 1 : 0).U64(callback_id);
   auto context = GetContext(context_id);
   if (!context) {
     return 0;
   }
-  return context->Eval(code_handle, callback_id);
+  return trace.Result(context->Exec(code_handle, report_success, callback_id));
 }
 
 LIB_EXPORT void mr_init_v8(const char* v8_flags,
@@ -43,14 +96,16 @@ LIB_EXPORT void mr_init_v8(const char* v8_flags,
 }
 
 LIB_EXPORT auto mr_init_context(MiniRacer::Callback callback) -> uint64_t {
-  auto* context_factory = MiniRacer::ContextFactory::Get();
-  if (context_factory == nullptr) {
-    return 0;
-  }
-  return context_factory->MakeContext(callback);
+  return InitContext(callback, /*use_standby=*/false);
+}
+
+LIB_EXPORT auto mr_init_standby_context(MiniRacer::Callback callback)
+    -> uint64_t {
+  return InitContext(callback, /*use_standby=*/true);
 }
 
 LIB_EXPORT void mr_free_context(uint64_t context_id) {
+  const TracedCall trace(TraceOp::kFreeContext, context_id);
   auto* context_factory = MiniRacer::ContextFactory::Get();
   if (context_factory == nullptr) {
     return;
@@ -66,8 +121,28 @@ LIB_EXPORT auto mr_context_count() -> size_t {
   return context_factory->Count();
 }
 
+// Pinning isn't traced: a pinned call is recorded just like its unpinned
+// equivalent, and replayed as one.
+LIB_EXPORT auto mr_context_pin(uint64_t context_id) -> MiniRacer::ContextPin* {
+  auto context = GetContext(context_id);
+  if (!context) {
+    return nullptr;
+  }
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  return new MiniRacer::ContextPin(context_id, std::move(context));
+}
+
+LIB_EXPORT void mr_context_unpin(MiniRacer::ContextPin* pin) {
+  if (pin == nullptr) {
+    return;
+  }
+  pin->Unref();
+}
+
 LIB_EXPORT void mr_free_value(uint64_t context_id,
                               MiniRacer::BinaryValueHandle* val_handle) {
+  TracedCall trace(TraceOp::kFreeValue, context_id);
+  trace.Handle(val_handle);
   auto context = GetContext(context_id);
   if (!context) {
     return;
@@ -79,22 +154,26 @@ LIB_EXPORT auto mr_alloc_int_val(uint64_t context_id,
                                  int64_t val,
                                  MiniRacer::BinaryTypes type)
     -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kAllocIntVal, context_id);
+  trace.I64(val).U64(type);
   auto context = GetContext(context_id);
   if (!context) {
     return nullptr;
   }
-  return context->AllocBinaryValue(val, type);
+  return trace.Result(context->AllocBinaryValue(val, type));
 }
 
 LIB_EXPORT auto mr_alloc_double_val(uint64_t context_id,
                                     double val,
                                     MiniRacer::BinaryTypes type)
     -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kAllocDoubleVal, context_id);
+  trace.F64(val).U64(type);
   auto context = GetContext(context_id);
   if (!context) {
     return nullptr;
   }
-  return context->AllocBinaryValue(val, type);
+  return trace.Result(context->AllocBinaryValue(val, type));
 }
 
 LIB_EXPORT auto mr_alloc_string_val(uint64_t context_id,
@@ -102,14 +181,19 @@ LIB_EXPORT auto mr_alloc_string_val(uint64_t context_id,
                                     uint64_t len,
                                     MiniRacer::BinaryTypes type)
     -> MiniRacer::BinaryValueHandle* {
+  const std::string_view str(val, len);
+  TracedCall trace(TraceOp::kAllocStringVal, context_id);
+  trace.Bytes(str).U64(type);
   auto context = GetContext(context_id);
   if (!context) {
     return nullptr;
   }
-  return context->AllocBinaryValue(std::string_view(val, len), type);
+  return trace.Result(context->AllocBinaryValue(str, type));
 }
 
 LIB_EXPORT void mr_cancel_task(uint64_t context_id, uint64_t task_id) {
+  TracedCall trace(TraceOp::kCancelTask, context_id);
+  trace.U64(task_id);
   auto context = GetContext(context_id);
   if (!context) {
     return;
@@ -119,14 +203,18 @@ LIB_EXPORT void mr_cancel_task(uint64_t context_id, uint64_t task_id) {
 
 LIB_EXPORT auto mr_heap_stats(uint64_t context_id,
                               uint64_t callback_id) -> uint64_t {
+  TracedCall trace(TraceOp::kHeapStats, context_id);
+  trace.U64(callback_id);
   auto context = GetContext(context_id);
   if (!context) {
     return 0;
   }
-  return context->HeapStats(callback_id);
+  return trace.Result(context->HeapStats(callback_id));
 }
 
 LIB_EXPORT void mr_set_hard_memory_limit(uint64_t context_id, size_t limit) {
+  TracedCall trace(TraceOp::kSetHardMemoryLimit, context_id);
+  trace.U64(limit);
   auto context = GetContext(context_id);
   if (!context) {
     return;
@@ -135,6 +223,8 @@ LIB_EXPORT void mr_set_hard_memory_limit(uint64_t context_id, size_t limit) {
 }
 
 LIB_EXPORT void mr_set_soft_memory_limit(uint64_t context_id, size_t limit) {
+  TracedCall trace(TraceOp::kSetSoftMemoryLimit, context_id);
+  trace.U64(limit);
   auto context = GetContext(context_id);
   if (!context) {
     return;
@@ -143,22 +233,25 @@ LIB_EXPORT void mr_set_soft_memory_limit(uint64_t context_id, size_t limit) {
 }
 
 LIB_EXPORT auto mr_hard_memory_limit_reached(uint64_t context_id) -> bool {
+  TracedCall trace(TraceOp::kHardMemoryLimitReached, context_id);
   auto context = GetContext(context_id);
   if (!context) {
     return false;
   }
-  return context->IsHardMemoryLimitReached();
+  return trace.Result(context->IsHardMemoryLimitReached());
 }
 
 LIB_EXPORT auto mr_soft_memory_limit_reached(uint64_t context_id) -> bool {
+  TracedCall trace(TraceOp::kSoftMemoryLimitReached, context_id);
   auto context = GetContext(context_id);
   if (!context) {
     return false;
   }
-  return context->IsSoftMemoryLimitReached();
+  return trace.Result(context->IsSoftMemoryLimitReached());
 }
 
 LIB_EXPORT void mr_low_memory_notification(uint64_t context_id) {
+  const TracedCall trace(TraceOp::kLowMemoryNotification, context_id);
   auto context = GetContext(context_id);
   if (!context) {
     return;
@@ -166,13 +259,178 @@ LIB_EXPORT void mr_low_memory_notification(uint64_t context_id) {
   context->ApplyLowMemoryNotification();
 }
 
+LIB_EXPORT auto mr_trim_memory(uint64_t context_id) -> uint64_t {
+  TracedCall trace(TraceOp::kTrimMemory, context_id);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return 0;
+  }
+  return trace.Result(context->TrimMemory());
+}
+
+LIB_EXPORT void mr_set_idle_trim(uint64_t context_id, uint64_t idle_ms) {
+  TracedCall trace(TraceOp::kSetIdleTrim, context_id);
+  trace.U64(idle_ms);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return;
+  }
+  context->SetIdleTrim(idle_ms);
+}
+
+LIB_EXPORT auto mr_trim_stats(uint64_t context_id)
+    -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kTrimStats, context_id);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return nullptr;
+  }
+  return trace.Result(context->TrimStats());
+}
+
+LIB_EXPORT void mr_set_spin_wait(uint64_t context_id, uint64_t microseconds) {
+  TracedCall trace(TraceOp::kSetSpinWait, context_id);
+  trace.U64(microseconds);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return;
+  }
+  context->SetSpinWait(microseconds);
+}
+
+LIB_EXPORT auto mr_set_microtask_policy(uint64_t context_id, uint8_t policy)
+    -> bool {
+  TracedCall trace(TraceOp::kSetMicrotaskPolicy, context_id);
+  trace.U64(policy);
+  if (policy > static_cast<uint8_t>(MiniRacer::MicrotaskPolicy::kScoped)) {
+    return trace.Result(false);
+  }
+  auto context = GetContext(context_id);
+  if (!context) {
+    return trace.Result(false);
+  }
+  context->SetMicrotaskPolicy(static_cast<MiniRacer::MicrotaskPolicy>(policy));
+  return trace.Result(true);
+}
+
+LIB_EXPORT void mr_set_task_watchdog(uint64_t context_id,
+                                     uint64_t threshold_ms) {
+  TracedCall trace(TraceOp::kSetTaskWatchdog, context_id);
+  trace.U64(threshold_ms);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return;
+  }
+  context->SetTaskWatchdog(threshold_ms);
+}
+
+LIB_EXPORT auto mr_task_watchdog_records(uint64_t context_id)
+    -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kTaskWatchdogRecords, context_id);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return nullptr;
+  }
+  return trace.Result(context->TaskWatchdogRecords());
+}
+
+LIB_EXPORT auto mr_install_console(uint64_t context_id, uint64_t capacity)
+    -> bool {
+  TracedCall trace(TraceOp::kInstallConsole, context_id);
+  trace.U64(capacity);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return trace.Result(false);
+  }
+  return trace.Result(context->InstallConsole(capacity));
+}
+
+LIB_EXPORT auto mr_drain_console(uint64_t context_id)
+    -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kDrainConsole, context_id);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return nullptr;
+  }
+  return trace.Result(context->DrainConsole());
+}
+
+LIB_EXPORT auto mr_allow_file_reads(uint64_t context_id,
+                                    char* dir,
+                                    uint64_t len) -> bool {
+  const std::string_view dir_str(dir, len);
+  TracedCall trace(TraceOp::kAllowFileReads, context_id);
+  trace.Bytes(dir_str);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return trace.Result(false);
+  }
+  return trace.Result(context->AllowFileReads(dir_str));
+}
+
+LIB_EXPORT auto mr_pin_isolate_thread(uint64_t context_id,
+                                      char* cpus,
+                                      uint64_t len,
+                                      int32_t numa_node) -> bool {
+  const std::string_view cpus_str(cpus, len);
+  TracedCall trace(TraceOp::kPinIsolateThread, context_id);
+  trace.Bytes(cpus_str).I64(numa_node);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return trace.Result(false);
+  }
+  return trace.Result(context->PinIsolateThread(cpus_str, numa_node));
+}
+
 LIB_EXPORT auto mr_make_js_callback(uint64_t context_id, uint64_t callback_id)
     -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kMakeJSCallback, context_id);
+  trace.U64(callback_id);
   auto context = GetContext(context_id);
   if (!context) {
     return nullptr;
   }
-  return context->MakeJSCallback(callback_id);
+  return trace.Result(context->MakeJSCallback(callback_id));
+}
+
+LIB_EXPORT auto mr_configure_platform(uint32_t worker_threads,
+                                      uint32_t max_user_visible_workers,
+                                      uint32_t max_best_effort_workers,
+                                      bool huge_pages) -> bool {
+  MiniRacer::PlatformConfig config{};
+  config.worker_threads = worker_threads;
+  config.max_user_visible_workers = max_user_visible_workers;
+  config.max_best_effort_workers = max_best_effort_workers;
+  config.huge_pages = huge_pages;
+  return MiniRacer::ContextFactory::ConfigurePlatform(config);
+}
+
+LIB_EXPORT auto mr_platform_stats(uint64_t* out, size_t out_len) -> size_t {
+  MiniRacer::PlatformStats stats{};
+  auto* context_factory = MiniRacer::ContextFactory::Get();
+  if (context_factory != nullptr) {
+    stats = context_factory->GetPlatformStats();
+  }
+
+  std::vector<uint64_t> words = {stats.worker_threads, stats.delayed};
+  for (const MiniRacer::PriorityStats& priority : stats.priorities) {
+    words.insert(words.end(),
+                 {priority.posted, priority.executed, priority.queued,
+                  priority.running, priority.peak_running});
+  }
+
+  const std::span<uint64_t> out_span(out, out_len);
+  const size_t count = std::min(out_len, words.size());
+  std::copy_n(words.begin(), count, out_span.begin());
+  return count;
+}
+
+LIB_EXPORT void mr_set_standby_contexts(uint64_t count) {
+  auto* context_factory = MiniRacer::ContextFactory::Get();
+  if (context_factory == nullptr) {
+    return;
+  }
+  context_factory->SetStandbyContexts(count);
 }
 
 LIB_EXPORT auto mr_v8_version() -> char const* {
@@ -186,32 +444,38 @@ LIB_EXPORT auto mr_v8_is_using_sandbox() -> bool {
 LIB_EXPORT auto mr_get_identity_hash(uint64_t context_id,
                                      MiniRacer::BinaryValueHandle* obj_handle)
     -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kGetIdentityHash, context_id);
+  trace.Handle(obj_handle);
   auto context = GetContext(context_id);
   if (!context) {
     return nullptr;
   }
-  return context->GetIdentityHash(obj_handle);
+  return trace.Result(context->GetIdentityHash(obj_handle));
 }
 
 LIB_EXPORT auto mr_get_own_property_names(
     uint64_t context_id,
     MiniRacer::BinaryValueHandle* obj_handle) -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kGetOwnPropertyNames, context_id);
+  trace.Handle(obj_handle);
   auto context = GetContext(context_id);
   if (!context) {
     return nullptr;
   }
-  return context->GetOwnPropertyNames(obj_handle);
+  return trace.Result(context->GetOwnPropertyNames(obj_handle));
 }
 
 LIB_EXPORT auto mr_get_object_item(uint64_t context_id,
                                    MiniRacer::BinaryValueHandle* obj_handle,
                                    MiniRacer::BinaryValueHandle* key_handle)
     -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kGetObjectItem, context_id);
+  trace.Handle(obj_handle).Handle(key_handle);
   auto context = GetContext(context_id);
   if (!context) {
     return nullptr;
   }
-  return context->GetObjectItem(obj_handle, key_handle);
+  return trace.Result(context->GetObjectItem(obj_handle, key_handle));
 }
 
 LIB_EXPORT auto mr_set_object_item(uint64_t context_id,
@@ -219,22 +483,27 @@ LIB_EXPORT auto mr_set_object_item(uint64_t context_id,
                                    MiniRacer::BinaryValueHandle* key_handle,
                                    MiniRacer::BinaryValueHandle* val_handle)
     -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kSetObjectItem, context_id);
+  trace.Handle(obj_handle).Handle(key_handle).Handle(val_handle);
   auto context = GetContext(context_id);
   if (!context) {
     return nullptr;
   }
-  return context->SetObjectItem(obj_handle, key_handle, val_handle);
+  return trace.Result(
+      context->SetObjectItem(obj_handle, key_handle, val_handle));
 }
 
 LIB_EXPORT auto mr_del_object_item(uint64_t context_id,
                                    MiniRacer::BinaryValueHandle* obj_handle,
                                    MiniRacer::BinaryValueHandle* key_handle)
     -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kDelObjectItem, context_id);
+  trace.Handle(obj_handle).Handle(key_handle);
   auto context = GetContext(context_id);
   if (!context) {
     return nullptr;
   }
-  return context->DelObjectItem(obj_handle, key_handle);
+  return trace.Result(context->DelObjectItem(obj_handle, key_handle));
 }
 
 LIB_EXPORT auto mr_splice_array(uint64_t context_id,
@@ -243,12 +512,37 @@ LIB_EXPORT auto mr_splice_array(uint64_t context_id,
                                 int32_t delete_count,
                                 MiniRacer::BinaryValueHandle* new_val_handle)
     -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kSpliceArray, context_id);
+  trace.Handle(array_handle).I64(start).I64(delete_count).Handle(
+      new_val_handle);
   auto context = GetContext(context_id);
   if (!context) {
     return nullptr;
   }
-  return context->SpliceArray(array_handle, start, delete_count,
-                              new_val_handle);
+  return trace.Result(context->SpliceArray(array_handle, start, delete_count,
+                                           new_val_handle));
+}
+
+LIB_EXPORT auto mr_run_batch(uint64_t context_id,
+                             const uint64_t* words,
+                             size_t words_len,
+                             MiniRacer::BinaryValueHandle** results,
+                             size_t results_len) -> size_t {
+  TracedCall trace(TraceOp::kRunBatch, context_id);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto* words_bytes = reinterpret_cast<const char*>(words);
+  trace.Bytes({words_bytes, words_len * sizeof(uint64_t)}).U64(results_len);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return 0;
+  }
+  const size_t count =
+      context->RunBatch(words, words_len, results, results_len);
+  for (const MiniRacer::BinaryValueHandle* result :
+       std::span(results, count)) {
+    trace.ResultHandle(result);
+  }
+  return count;
 }
 
 LIB_EXPORT auto mr_call_function(uint64_t context_id,
@@ -256,21 +550,91 @@ LIB_EXPORT auto mr_call_function(uint64_t context_id,
                                  MiniRacer::BinaryValueHandle* this_handle,
                                  MiniRacer::BinaryValueHandle* argv_handle,
                                  uint64_t callback_id) -> uint64_t {
+  TracedCall trace(TraceOp::kCallFunction, context_id);
+  trace.Handle(func_handle).Handle(this_handle).Handle(argv_handle).U64(
+      callback_id);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return 0;
+  }
+  return trace.Result(context->CallFunction(func_handle, this_handle,
+                                            argv_handle, callback_id));
+}
+
+LIB_EXPORT auto mr_call_json(uint64_t context_id,
+                             MiniRacer::BinaryValueHandle* expr_handle,
+                             MiniRacer::BinaryValueHandle* args_json_handle,
+                             uint64_t callback_id) -> uint64_t {
+  TracedCall trace(TraceOp::kCallJSON, context_id);
+  trace.Handle(expr_handle).Handle(args_json_handle).U64(callback_id);
   auto context = GetContext(context_id);
   if (!context) {
     return 0;
   }
-  return context->CallFunction(func_handle, this_handle, argv_handle,
-                               callback_id);
+  return trace.Result(
+      context->CallJSON(expr_handle, args_json_handle, callback_id));
+}
+
+LIB_EXPORT auto mr_map_json(uint64_t context_id,
+                            MiniRacer::BinaryValueHandle* expr_handle,
+                            MiniRacer::BinaryValueHandle* records_json_handle,
+                            uint64_t callback_id) -> uint64_t {
+  TracedCall trace(TraceOp::kMapJSON, context_id);
+  trace.Handle(expr_handle).Handle(records_json_handle).U64(callback_id);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return 0;
+  }
+  return trace.Result(
+      context->MapJSON(expr_handle, records_json_handle, callback_id));
 }
 
 LIB_EXPORT auto mr_heap_snapshot(uint64_t context_id,
                                  uint64_t callback_id) -> uint64_t {
+  TracedCall trace(TraceOp::kHeapSnapshot, context_id);
+  trace.U64(callback_id);
   auto context = GetContext(context_id);
   if (!context) {
     return 0;
   }
-  return context->HeapSnapshot(callback_id);
+  return trace.Result(context->HeapSnapshot(callback_id));
+}
+
+LIB_EXPORT auto mr_heap_summary(uint64_t context_id,
+                                uint64_t top_n,
+                                uint64_t callback_id) -> uint64_t {
+  TracedCall trace(TraceOp::kHeapSummary, context_id);
+  trace.U64(top_n);
+  trace.U64(callback_id);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return 0;
+  }
+  return trace.Result(context->HeapSummary(top_n, callback_id));
+}
+
+LIB_EXPORT auto mr_set_heap_growth_baseline(uint64_t context_id,
+                                            uint64_t callback_id) -> uint64_t {
+  TracedCall trace(TraceOp::kSetHeapGrowthBaseline, context_id);
+  trace.U64(callback_id);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return 0;
+  }
+  return trace.Result(context->SetHeapGrowthBaseline(callback_id));
+}
+
+LIB_EXPORT auto mr_heap_growth(uint64_t context_id,
+                               uint64_t top_n,
+                               uint64_t callback_id) -> uint64_t {
+  TracedCall trace(TraceOp::kHeapGrowth, context_id);
+  trace.U64(top_n);
+  trace.U64(callback_id);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return 0;
+  }
+  return trace.Result(context->HeapGrowth(top_n, callback_id));
 }
 
 LIB_EXPORT auto mr_value_count(uint64_t context_id) -> size_t {
@@ -281,4 +645,139 @@ LIB_EXPORT auto mr_value_count(uint64_t context_id) -> size_t {
   return context->BinaryValueCount();
 }
 
+LIB_EXPORT auto mr_value_stats(uint64_t context_id)
+    -> MiniRacer::BinaryValueHandle* {
+  TracedCall trace(TraceOp::kValueStats, context_id);
+  auto context = GetContext(context_id);
+  if (!context) {
+    return nullptr;
+  }
+  return trace.Result(context->ValueStats());
+}
+
+LIB_EXPORT auto mr_start_trace(const char* path) -> bool {
+  return MiniRacer::CallTracer::Get()->Start(path);
+}
+
+LIB_EXPORT void mr_stop_trace() {
+  MiniRacer::CallTracer::Get()->Stop();
+}
+
+LIB_EXPORT void mr_pinned_free_value(MiniRacer::ContextPin* pin,
+                                     MiniRacer::BinaryValueHandle* val_handle) {
+  const PinnedCall context(pin);
+  TracedCall trace(TraceOp::kFreeValue, pin->GetContextId());
+  trace.Handle(val_handle);
+  context->FreeBinaryValue(val_handle);
+}
+
+LIB_EXPORT auto mr_pinned_alloc_int_val(MiniRacer::ContextPin* pin,
+                                        int64_t val,
+                                        MiniRacer::BinaryTypes type)
+    -> MiniRacer::BinaryValueHandle* {
+  const PinnedCall context(pin);
+  TracedCall trace(TraceOp::kAllocIntVal, pin->GetContextId());
+  trace.I64(val).U64(type);
+  return trace.Result(context->AllocBinaryValue(val, type));
+}
+
+LIB_EXPORT auto mr_pinned_alloc_double_val(MiniRacer::ContextPin* pin,
+                                           double val,
+                                           MiniRacer::BinaryTypes type)
+    -> MiniRacer::BinaryValueHandle* {
+  const PinnedCall context(pin);
+  TracedCall trace(TraceOp::kAllocDoubleVal, pin->GetContextId());
+  trace.F64(val).U64(type);
+  return trace.Result(context->AllocBinaryValue(val, type));
+}
+
+LIB_EXPORT auto mr_pinned_alloc_string_val(MiniRacer::ContextPin* pin,
+                                           char* val,
+                                           uint64_t len,
+                                           MiniRacer::BinaryTypes type)
+    -> MiniRacer::BinaryValueHandle* {
+  const std::string_view str(val, len);
+  const PinnedCall context(pin);
+  TracedCall trace(TraceOp::kAllocStringVal, pin->GetContextId());
+  trace.Bytes(str).U64(type);
+  return trace.Result(context->AllocBinaryValue(str, type));
+}
+
+LIB_EXPORT auto mr_pinned_get_object_item(
+    MiniRacer::ContextPin* pin,
+    MiniRacer::BinaryValueHandle* obj_handle,
+    MiniRacer::BinaryValueHandle* key_handle) -> MiniRacer::BinaryValueHandle* {
+  const PinnedCall context(pin);
+  TracedCall trace(TraceOp::kGetObjectItem, pin->GetContextId());
+  trace.Handle(obj_handle).Handle(key_handle);
+  return trace.Result(context->GetObjectItem(obj_handle, key_handle));
+}
+
+LIB_EXPORT auto mr_pinned_set_object_item(
+    MiniRacer::ContextPin* pin,
+    MiniRacer::BinaryValueHandle* obj_handle,
+    MiniRacer::BinaryValueHandle* key_handle,
+    MiniRacer::BinaryValueHandle* val_handle) -> MiniRacer::BinaryValueHandle* {
+  const PinnedCall context(pin);
+  TracedCall trace(TraceOp::kSetObjectItem, pin->GetContextId());
+  trace.Handle(obj_handle).Handle(key_handle).Handle(val_handle);
+  return trace.Result(
+      context->SetObjectItem(obj_handle, key_handle, val_handle));
+}
+
+LIB_EXPORT auto mr_pinned_del_object_item(
+    MiniRacer::ContextPin* pin,
+    MiniRacer::BinaryValueHandle* obj_handle,
+    MiniRacer::BinaryValueHandle* key_handle) -> MiniRacer::BinaryValueHandle* {
+  const PinnedCall context(pin);
+  TracedCall trace(TraceOp::kDelObjectItem, pin->GetContextId());
+  trace.Handle(obj_handle).Handle(key_handle);
+  return trace.Result(context->DelObjectItem(obj_handle, key_handle));
+}
+
+LIB_EXPORT auto mr_pinned_eval(MiniRacer::ContextPin* pin,
+                               MiniRacer::BinaryValueHandle* code_handle,
+                               uint64_t callback_id) -> uint64_t {
+  const PinnedCall context(pin);
+  TracedCall trace(TraceOp::kEval, pin->GetContextId());
+  trace.Handle(code_handle).U64(callback_id);
+  return trace.Result(context->Eval(code_handle, callback_id));
+}
+
+LIB_EXPORT auto mr_pinned_exec(MiniRacer::ContextPin* pin,
+                               MiniRacer::BinaryValueHandle* code_handle,
+                               bool report_success,
+                               uint64_t callback_id) -> uint64_t {
+  const PinnedCall context(pin);
+  TracedCall trace(TraceOp::kExec, pin->GetContextId());
+  trace.Handle(code_handle).U64(report_success ? 1 : 0).U64(callback_id);
+  return trace.Result(context->Exec(code_handle, report_success, callback_id));
+}
+
+LIB_EXPORT auto mr_pinned_call_function(
+    MiniRacer::ContextPin* pin,
+    MiniRacer::BinaryValueHandle* func_handle,
+    MiniRacer::BinaryValueHandle* this_handle,
+    MiniRacer::BinaryValueHandle* argv_handle,
+    uint64_t callback_id) -> uint64_t {
+  const PinnedCall context(pin);
+  TracedCall trace(TraceOp::kCallFunction, pin->GetContextId());
+  trace.Handle(func_handle).Handle(this_handle).Handle(argv_handle).U64(
+      callback_id);
+  return trace.Result(context->CallFunction(func_handle, this_handle,
+                                            argv_handle, callback_id));
+}
+
+LIB_EXPORT auto mr_pinned_call_json(
+    MiniRacer::ContextPin* pin,
+    MiniRacer::BinaryValueHandle* expr_handle,
+    MiniRacer::BinaryValueHandle* args_json_handle,
+    uint64_t callback_id) -> uint64_t {
+  const PinnedCall context(pin);
+  TracedCall trace(TraceOp::kCallJSON, pin->GetContextId());
+  trace.Handle(expr_handle).Handle(args_json_handle).U64(callback_id);
+  return trace.Result(
+      context->CallJSON(expr_handle, args_json_handle, callback_id));
+}
+
 // NOLINTEND(bugprone-easily-swappable-parameters)
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include "binary_value.h"
 #include "callback.h"
+#include "context_pin.h"
 
 #ifdef V8_OS_WIN
 #define LIB_EXPORT __declspec(dllexport)
@@ -25,6 +26,51 @@ LIB_EXPORT void mr_init_v8(const char* v8_flags,
                            const char* icu_path,
                            const char* snapshot_path);
 
+/** Configure the worker pool which runs V8's background tasks (e.g.,
+ * concurrent GC and compiles). Must be called before mr_init_v8, and has no
+ * effect if V8 runs single-threaded (i.e., with the --single-threaded flag).
+ *
+ * worker_threads is the size of the pool. max_user_visible_workers and
+ * max_best_effort_workers cap how many workers may run tasks of the
+ * corresponding v8::TaskPriority at once. Zero means the default for each: a
+ * pool of one fewer thread than cores (up to 16), with no caps short of the
+ * pool size.
+ *
+ * If huge_pages is set, we ask the kernel to back large regions allocated by
+ * V8 (through the platform's page allocator) and large ArrayBuffers with
+ * transparent huge pages. This applies in single-threaded mode too, and does
+ * nothing on platforms other than Linux.
+ *
+ * Returns false if V8 is already initialized.
+ **/
+LIB_EXPORT auto mr_configure_platform(uint32_t worker_threads,
+                                      uint32_t max_user_visible_workers,
+                                      uint32_t max_best_effort_workers,
+                                      bool huge_pages) -> bool;
+
+/** Get counters for the worker pool which runs V8's background tasks.
+ *
+ * Writes up to out_len of the following words into out, and returns how many
+ * it wrote: the number of worker threads, the number of delayed tasks not yet
+ * due, and then for each v8::TaskPriority (best effort, user visible, and user
+ * blocking, in that order) the number of tasks posted, executed, queued, and
+ * running, and the most tasks which ever ran at once.
+ *
+ * All counters are zero if V8 runs single-threaded.
+ **/
+LIB_EXPORT auto mr_platform_stats(uint64_t* out, size_t out_len) -> size_t;
+
+/** Keep count pre-warmed contexts on standby, so that mr_init_standby_context
+ * returns quickly (e.g., when replacing a context whose isolate hit its hard
+ * memory limit). Standby contexts are rebuilt on a background thread as
+ * they're used up. Zero (the default) turns this off, discards any standby
+ * contexts, and joins that thread; callers which set a nonzero count must set
+ * zero again before exit.
+ *
+ * mr_init_v8 must be called first.
+ **/
+LIB_EXPORT void mr_set_standby_contexts(uint64_t count);
+
 /** Determine the V8 version. **/
 LIB_EXPORT auto mr_v8_version() -> char const*;
 
@@ -49,6 +95,13 @@ LIB_EXPORT auto mr_v8_is_using_sandbox() -> bool;
  **/
 LIB_EXPORT auto mr_init_context(MiniRacer::Callback callback) -> uint64_t;
 
+/** Like mr_init_context, but hands out a standby context (see
+ * mr_set_standby_contexts) if there is one, rather than building a new one.
+ * This is traced as mr_init_context.
+ **/
+LIB_EXPORT auto mr_init_standby_context(MiniRacer::Callback callback)
+    -> uint64_t;
+
 /** Free a MiniRacer context.
  *
  * This shuts down the v8::ISolate, v8::Context, the message loop thread, and
@@ -62,6 +115,27 @@ LIB_EXPORT void mr_free_context(uint64_t context_id);
  **/
 LIB_EXPORT auto mr_context_count() -> size_t;
 
+/** Pin a MiniRacer context, for use with the mr_pinned_* functions.
+ *
+ * Every other call looks its context up by ID, in a process-wide table
+ * guarded by a mutex. The mr_pinned_* functions (which mirror the most
+ * frequently used calls) instead take the returned pin, and go straight to the
+ * context.
+ *
+ * A pin keeps its context alive, even past mr_free_context, until released
+ * with mr_context_unpin.
+ *
+ * Returns nullptr if there is no such context.
+ **/
+LIB_EXPORT auto mr_context_pin(uint64_t context_id) -> MiniRacer::ContextPin*;
+
+/** Release a pin created by mr_context_pin.
+ *
+ * Calls already in progress through the pin (on other threads) complete
+ * normally, but no new calls may be made with it.
+ **/
+LIB_EXPORT void mr_context_unpin(MiniRacer::ContextPin* pin);
+
 /** Configure the V8 hard memory limit. **/
 LIB_EXPORT void mr_set_hard_memory_limit(uint64_t context_id, size_t limit);
 
@@ -80,6 +154,124 @@ LIB_EXPORT auto mr_soft_memory_limit_reached(uint64_t context_id) -> bool;
  **/
 LIB_EXPORT void mr_low_memory_notification(uint64_t context_id);
 
+/** Trim the memory footprint of a context, waiting for any running task to
+ * finish first.
+ *
+ * This runs memory-reducing garbage collections, which compact the heap,
+ * shrink new space, drop the compilation cache, and return freed pages to the
+ * OS, and age cold bytecode (and the code compiled from it) towards being
+ * flushed. It's meant for contexts which are about to sit idle.
+ *
+ * Returns the number of bytes of heap and malloced memory reclaimed.
+ **/
+LIB_EXPORT auto mr_trim_memory(uint64_t context_id) -> uint64_t;
+
+/** Trim the context (as with mr_trim_memory) automatically once it has been
+ * idle, i.e., has started no task, for idle_ms milliseconds. We trim once per
+ * idle spell. Zero (the default) disables idle trimming.
+ **/
+LIB_EXPORT void mr_set_idle_trim(uint64_t context_id, uint64_t idle_ms);
+
+/** Get the context's trim counters, as a JSON object with keys:
+ *   trims: the number of trims (including idle ones),
+ *   idle_trims: the number of idle trims, and
+ *   bytes_reclaimed: the total bytes reclaimed by all trims.
+ **/
+LIB_EXPORT auto mr_trim_stats(uint64_t context_id)
+    -> MiniRacer::BinaryValueHandle*;
+
+/** Set how long, in microseconds, to spin-wait before blocking, when waiting
+ * for work on the isolate thread or for results of synchronous calls (such as
+ * object property access) on the calling thread.
+ *
+ * This reduces the latency of frequent small calls at the cost of CPU time.
+ * Zero (the default) means always block immediately.
+ **/
+LIB_EXPORT void mr_set_spin_wait(uint64_t context_id, uint64_t microseconds);
+
+/** Set when microtasks (e.g., Promise reactions) run.
+ *
+ * policy must be one of the values of MiniRacer::MicrotaskPolicy:
+ *   0: after every task (the default),
+ *   1: after every task which might run JavaScript, or
+ *   2: on exiting each JavaScript task, using V8's scoped microtask policy.
+ *
+ * Returns false if the context ID or policy is invalid.
+ **/
+LIB_EXPORT auto mr_set_microtask_policy(uint64_t context_id, uint8_t policy)
+    -> bool;
+
+/** Watch for tasks which run longer than threshold_ms milliseconds.
+ *
+ * When a task (e.g., a call to mr_eval) runs past the threshold, we record it,
+ * including the JavaScript stack as of when the threshold passed. We keep the
+ * last 64 records (see mr_task_watchdog_records).
+ *
+ * Zero (the default) disables the watchdog.
+ **/
+LIB_EXPORT void mr_set_task_watchdog(uint64_t context_id,
+                                     uint64_t threshold_ms);
+
+/** Get the tasks recorded by the task watchdog, as a JSON array (oldest
+ * first) of objects with keys:
+ *   id: a number which increases with each record,
+ *   task_kind: "javascript" or "no_javascript",
+ *   elapsed_ms: how long the task had run when recorded, and
+ *   stack: the JavaScript stack, innermost frame first, as an array of
+ *     objects with keys function, script, line, and column.
+ **/
+LIB_EXPORT auto mr_task_watchdog_records(uint64_t context_id)
+    -> MiniRacer::BinaryValueHandle*;
+
+/** Replace console.log, console.info, console.warn, console.error, and
+ * console.debug with native implementations which format their arguments
+ * and append the result to a buffer, for the caller to drain with
+ * mr_drain_console. The buffer holds up to capacity lines, after which we
+ * drop the oldest. Lines over 16KiB are truncated.
+ *
+ * Returns false if the context ID is invalid or capacity is zero.
+ **/
+LIB_EXPORT auto mr_install_console(uint64_t context_id, uint64_t capacity)
+    -> bool;
+
+/** Empty the console buffer (see mr_install_console), and return what it held
+ * as a JSON object with keys:
+ *   dropped: how many lines we dropped since the last drain because the
+ *     buffer was full, and
+ *   lines: an array (oldest first) of [level, text] pairs, where level is
+ *     "log", "info", "warn", "error", or "debug".
+ **/
+LIB_EXPORT auto mr_drain_console(uint64_t context_id)
+    -> MiniRacer::BinaryValueHandle*;
+
+/** Let JavaScript read files from within the given directory (a UTF-8 path
+ * of len bytes), through a global readFileSync(path) function which returns
+ * an ArrayBuffer. The function is installed by the first call.
+ *
+ * Files are mapped (copy-on-write) rather than read. See ARCHITECTURE.md for
+ * the security implications.
+ *
+ * Returns false if the context ID is invalid, dir isn't a directory, or this
+ * platform doesn't support file reads (currently, only POSIX platforms do).
+ **/
+LIB_EXPORT auto mr_allow_file_reads(uint64_t context_id,
+                                    char* dir,
+                                    uint64_t len) -> bool;
+
+/** Pin the context's message loop thread (which runs all its JavaScript) to
+ * the given CPUs, a list of len bytes in the Linux format (e.g., "0-3,8"),
+ * and, if numa_node is non-negative, prefer that NUMA node for the thread's
+ * future memory allocations (including most of the V8 heap). If the CPU list
+ * is empty, the thread is pinned to the CPUs of numa_node.
+ *
+ * Returns false if the context ID is invalid, the arguments are malformed,
+ * the kernel refuses, or this isn't Linux.
+ **/
+LIB_EXPORT auto mr_pin_isolate_thread(uint64_t context_id,
+                                      char* cpus,
+                                      uint64_t len,
+                                      int32_t numa_node) -> bool;
+
 /** Make a JS callback wrapping the C callback supplied to mr_init_context.
  *
  * When the given JS function is called, any args will be packed into an array
@@ -131,6 +323,22 @@ LIB_EXPORT void mr_free_value(uint64_t context_id,
  **/
 LIB_EXPORT auto mr_value_count(uint64_t context_id) -> size_t;
 
+/** Break down the values allocated in this context which the caller hasn't
+ * yet freed (see mr_free_value), as JSON. Keys are:
+ *   total: the count of all values (as returned by mr_value_count),
+ *   strings, arrays, objects, functions, buffers, promises, exceptions, and
+ *     other: counts of values by type,
+ *   string_bytes: the bytes of string data held by strings and exceptions,
+ *   buffer_bytes: the bytes of buffer data exposed by ArrayBuffers and
+ *     friends,
+ *   persistents: how many values hold a v8::Persistent reference (and thus
+ *     keep a JavaScript object alive), and
+ *   collector_backlog: how many V8 objects from already-freed values are
+ *     waiting to be deleted on the isolate thread.
+ **/
+LIB_EXPORT auto mr_value_stats(uint64_t context_id)
+    -> MiniRacer::BinaryValueHandle*;
+
 /** Get the V8 object identity hash for the given object. **/
 LIB_EXPORT auto mr_get_identity_hash(uint64_t context_id,
                                      MiniRacer::BinaryValueHandle* obj_handle)
@@ -199,10 +407,45 @@ LIB_EXPORT auto mr_splice_array(uint64_t context_id,
                                 MiniRacer::BinaryValueHandle* new_val_handle)
     -> MiniRacer::BinaryValueHandle*;
 
+/** Run a batch of object operations with one round trip to the isolate
+ * thread.
+ *
+ * words encodes a sequence of operations. Each starts with an opcode word,
+ * followed by operand words:
+ *
+ *   1 (get):    obj, key
+ *   2 (set):    obj, key, value
+ *   3 (delete): obj, key
+ *   4 (splice): array, start (int), delete_count (int), count (int), followed
+ *               by count new items
+ *   5 (call):   func, this, count (int), followed by count arguments
+ *
+ * Value operands (everything not marked int) are either a
+ * MiniRacer::BinaryValueHandle*, or, if the top bit is set, the index (in the
+ * remaining bits) of an earlier operation in the batch, whose result is used.
+ * Ints are two's complement int64_t.
+ *
+ * Operations run in order, synchronously, and without timeouts. Their results
+ * are the same as for the equivalent individual calls (e.g.,
+ * mr_get_object_item, mr_call_function) and are written into results, which
+ * must have room for one value per operation. Execution stops at the first
+ * failing operation, whose result is then an exception. A malformed batch
+ * yields just one exception result.
+ *
+ * Returns the number of results written, which the caller should free with
+ * mr_free_value.
+ **/
+LIB_EXPORT auto mr_run_batch(uint64_t context_id,
+                             const uint64_t* words,
+                             size_t words_len,
+                             MiniRacer::BinaryValueHandle** results,
+                             size_t results_len) -> size_t;
+
 /** Cancel the given asynchronous task.
  *
- * (Such tasks are started by mr_eval, mr_call_function, mr_heap_stats, and
- * mr_heap_snapshot).
+ * (Such tasks are started by mr_eval, mr_exec, mr_call_function,
+ * mr_call_json, mr_map_json, mr_heap_stats, mr_heap_snapshot, mr_heap_summary,
+ * mr_set_heap_growth_baseline, and mr_heap_growth).
  **/
 LIB_EXPORT void mr_cancel_task(uint64_t context_id, uint64_t task_id);
 
@@ -224,6 +467,22 @@ LIB_EXPORT auto mr_eval(uint64_t context_id,
                         MiniRacer::BinaryValueHandle* code_handle,
                         uint64_t callback_id) -> uint64_t;
 
+/** Execute the given JavaScript code, discarding its result.
+ *
+ * This is mr_eval for code run only for its side effects: it skips converting
+ * the completion value (which, for objects, would otherwise create a handle
+ * for the caller to free).
+ *
+ * On failure, the exception is passed back to the callback as with mr_eval.
+ * On success, if report_success is true, the callback receives an undefined
+ * value; otherwise the callback is not called at all, so that setup code can be
+ * queued up without waiting on (or cleaning up after) each script.
+ **/
+LIB_EXPORT auto mr_exec(uint64_t context_id,
+                        MiniRacer::BinaryValueHandle* code_handle,
+                        bool report_success,
+                        uint64_t callback_id) -> uint64_t;
+
 /** Call JavaScript `func.call(this, ...argv)`.
  *
  * This call is processed asynchronously and as such accepts a callback ID.
@@ -237,6 +496,44 @@ LIB_EXPORT auto mr_call_function(uint64_t context_id,
                                  MiniRacer::BinaryValueHandle* argv_handle,
                                  uint64_t callback_id) -> uint64_t;
 
+/** Call JavaScript `JSON.stringify(expr.apply(this, JSON.parse(args_json)))`,
+ * where expr and args_json are strings and this is the global object.
+ *
+ * Unlike evaluating that as code with mr_eval, this only compiles expr once
+ * (and caches it for future calls), and doesn't involve the JavaScript-visible
+ * JSON object.
+ *
+ * This call is processed asynchronously and as such accepts a callback ID.
+ * The callback ID and a MiniRacer::BinaryValueHandle* containing the
+ * result (a string, or undefined if the function's result has no JSON
+ * representation) are passed back to the callback upon completion. A task ID
+ * is returned which can be passed back to mr_cancel_task to cancel evaluation.
+ **/
+LIB_EXPORT auto mr_call_json(uint64_t context_id,
+                             MiniRacer::BinaryValueHandle* expr_handle,
+                             MiniRacer::BinaryValueHandle* args_json_handle,
+                             uint64_t callback_id) -> uint64_t;
+
+/** Call the JavaScript function named by expr (as in mr_call_json) on each
+ * element of the JSON array records_json, and return the JSON array of
+ * results. Results without a JSON representation (e.g., undefined) become
+ * null.
+ *
+ * This is meant for streaming many records through one function: callers can
+ * split the records into batches, and keep several batches in flight, so that
+ * serializing the next batch overlaps with running the current one. Batches
+ * are processed in the order they are submitted.
+ *
+ * This call is processed asynchronously and as such accepts a callback ID.
+ * The callback ID and a MiniRacer::BinaryValueHandle* containing the
+ * result (a string) are passed back to the callback upon completion. A task ID
+ * is returned which can be passed back to mr_cancel_task to cancel evaluation.
+ **/
+LIB_EXPORT auto mr_map_json(uint64_t context_id,
+                            MiniRacer::BinaryValueHandle* expr_handle,
+                            MiniRacer::BinaryValueHandle* records_json_handle,
+                            uint64_t callback_id) -> uint64_t;
+
 /** Get stats for the V8 heap.
  *
  * This function is intended for use in debugging only.
@@ -261,6 +558,124 @@ LIB_EXPORT auto mr_heap_stats(uint64_t context_id,
 LIB_EXPORT auto mr_heap_snapshot(uint64_t context_id,
                                  uint64_t callback_id) -> uint64_t;
 
+/** Summarize the V8 heap by constructor.
+ *
+ * This takes a heap snapshot, like mr_heap_snapshot, but instead of returning
+ * the whole thing, aggregates it natively into a table, as JSON:
+ *   {"node_count": ..., "total_size": ...,
+ *    "columns": ["name", "count", "shallow_size", "retained_size"],
+ *    "rows": [["Foo", 10, 400, 1200], ...]}
+ * with one row per constructor (or other kind of heap object, like
+ * "(string)"), for the top_n constructors by retained size (or all of them,
+ * if top_n is 0).
+ *
+ * This call is processed asynchronously and as such accepts a callback ID.
+ * The callback ID and a MiniRacer::BinaryValueHandle* containing the
+ * evaluation result are passed back to the callback upon completion. A task ID
+ * is returned which can be passed back to mr_cancel_task to cancel evaluation.
+ **/
+LIB_EXPORT auto mr_heap_summary(uint64_t context_id,
+                                uint64_t top_n,
+                                uint64_t callback_id) -> uint64_t;
+
+/** Record which objects are on the V8 heap now, for mr_heap_growth.
+ *
+ * This turns on V8's heap object tracking, which assigns each heap object a
+ * stable ID. The result is the last ID assigned so far, as an integer.
+ *
+ * This call is processed asynchronously and as such accepts a callback ID.
+ * The callback ID and a MiniRacer::BinaryValueHandle* containing the
+ * evaluation result are passed back to the callback upon completion. A task ID
+ * is returned which can be passed back to mr_cancel_task to cancel evaluation.
+ **/
+LIB_EXPORT auto mr_set_heap_growth_baseline(uint64_t context_id,
+                                            uint64_t callback_id) -> uint64_t;
+
+/** Summarize the objects allocated since mr_set_heap_growth_baseline which
+ * are still alive, by constructor.
+ *
+ * This takes a heap snapshot (which collects garbage first) and returns a
+ * table like mr_heap_summary's, as JSON:
+ *   {"baseline_object_id": ..., "object_count": ..., "total_size": ...,
+ *    "columns": ["name", "count", "size"],
+ *    "rows": [["Foo", 10, 400], ...]}
+ * for the top_n constructors by size (or all of them, if top_n is 0). If no
+ * baseline was recorded, the result is a value exception.
+ *
+ * This call is processed asynchronously and as such accepts a callback ID.
+ * The callback ID and a MiniRacer::BinaryValueHandle* containing the
+ * evaluation result are passed back to the callback upon completion. A task ID
+ * is returned which can be passed back to mr_cancel_task to cancel evaluation.
+ **/
+LIB_EXPORT auto mr_heap_growth(uint64_t context_id,
+                               uint64_t top_n,
+                               uint64_t callback_id) -> uint64_t;
+
+/** Start recording API calls into a binary trace file at the given path.
+ *
+ * This function is intended for performance work: the trace records each API
+ * call made through this library (by any context in the process), along with
+ * its timing, arguments, and any handles it consumed and produced, so that
+ * the workload can later be replayed (see helpers/trace_replay.py).
+ *
+ * Note that traces include all code and string data passed into this library.
+ *
+ * Returns false if tracing is already on, or the file couldn't be opened.
+ **/
+LIB_EXPORT auto mr_start_trace(const char* path) -> bool;
+
+/** Stop recording API calls, and flush and close the trace file. **/
+LIB_EXPORT void mr_stop_trace();
+
+/** Equivalents of the functions of the same name without "pinned_", which
+ * take a pin from mr_context_pin instead of a context ID. **/
+LIB_EXPORT void mr_pinned_free_value(MiniRacer::ContextPin* pin,
+                                     MiniRacer::BinaryValueHandle* val_handle);
+LIB_EXPORT auto mr_pinned_alloc_int_val(MiniRacer::ContextPin* pin,
+                                        int64_t val,
+                                        MiniRacer::BinaryTypes type)
+    -> MiniRacer::BinaryValueHandle*;
+LIB_EXPORT auto mr_pinned_alloc_double_val(MiniRacer::ContextPin* pin,
+                                           double val,
+                                           MiniRacer::BinaryTypes type)
+    -> MiniRacer::BinaryValueHandle*;
+LIB_EXPORT auto mr_pinned_alloc_string_val(MiniRacer::ContextPin* pin,
+                                           char* val,
+                                           uint64_t len,
+                                           MiniRacer::BinaryTypes type)
+    -> MiniRacer::BinaryValueHandle*;
+LIB_EXPORT auto mr_pinned_get_object_item(
+    MiniRacer::ContextPin* pin,
+    MiniRacer::BinaryValueHandle* obj_handle,
+    MiniRacer::BinaryValueHandle* key_handle) -> MiniRacer::BinaryValueHandle*;
+LIB_EXPORT auto mr_pinned_set_object_item(
+    MiniRacer::ContextPin* pin,
+    MiniRacer::BinaryValueHandle* obj_handle,
+    MiniRacer::BinaryValueHandle* key_handle,
+    MiniRacer::BinaryValueHandle* val_handle) -> MiniRacer::BinaryValueHandle*;
+LIB_EXPORT auto mr_pinned_del_object_item(
+    MiniRacer::ContextPin* pin,
+    MiniRacer::BinaryValueHandle* obj_handle,
+    MiniRacer::BinaryValueHandle* key_handle) -> MiniRacer::BinaryValueHandle*;
+LIB_EXPORT auto mr_pinned_eval(MiniRacer::ContextPin* pin,
+                               MiniRacer::BinaryValueHandle* code_handle,
+                               uint64_t callback_id) -> uint64_t;
+LIB_EXPORT auto mr_pinned_exec(MiniRacer::ContextPin* pin,
+                               MiniRacer::BinaryValueHandle* code_handle,
+                               bool report_success,
+                               uint64_t callback_id) -> uint64_t;
+LIB_EXPORT auto mr_pinned_call_function(
+    MiniRacer::ContextPin* pin,
+    MiniRacer::BinaryValueHandle* func_handle,
+    MiniRacer::BinaryValueHandle* this_handle,
+    MiniRacer::BinaryValueHandle* argv_handle,
+    uint64_t callback_id) -> uint64_t;
+LIB_EXPORT auto mr_pinned_call_json(
+    MiniRacer::ContextPin* pin,
+    MiniRacer::BinaryValueHandle* expr_handle,
+    MiniRacer::BinaryValueHandle* args_json_handle,
+    uint64_t callback_id) -> uint64_t;
+
 // NOLINTEND(bugprone-easily-swappable-parameters)
 
 }  // end extern "C"
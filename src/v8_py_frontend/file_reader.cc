@@ -0,0 +1,310 @@
+#include "file_reader.h"
+
+#include <v8-array-buffer.h>
+#include <v8-context.h>
+#include <v8-exception.h>
+#include <v8-function-callback.h>
+#include <v8-function.h>
+#include <v8-initialization.h>
+#include <v8-isolate.h>
+#include <v8-local-handle.h>
+#include <v8-object.h>
+#include <v8-platform.h>
+#include <v8-primitive.h>
+#include <v8-typed-array.h>
+#include <v8config.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include "context_holder.h"
+#include "id_maker.h"
+
+#if defined(V8_OS_POSIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // V8_OS_POSIX
+
+namespace MiniRacer {
+
+namespace {
+
+void ThrowError(v8::Isolate* isolate, const std::string& msg) {
+  isolate->ThrowException(v8::Exception::Error(
+      v8::String::NewFromUtf8(isolate, msg.c_str()).ToLocalChecked()));
+}
+
+#if defined(V8_OS_POSIX)
+
+struct FreeDeleter {
+  void operator()(char* ptr) const {
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    std::free(ptr);
+  }
+};
+
+/** Resolves path to an absolute path with no symlinks or "..", or returns an
+ * empty string if the path doesn't exist. */
+auto Canonicalize(std::string_view path) -> std::string {
+  if (path.empty() || path.find('\0') != std::string_view::npos) {
+    return {};
+  }
+  const std::unique_ptr<char, FreeDeleter> resolved(
+      realpath(std::string(path).c_str(), nullptr));
+  if (!resolved) {
+    return {};
+  }
+  return resolved.get();
+}
+
+/** Opens rel (a canonical path relative to dir) one component at a time,
+ * refusing to follow symlinks. Thus if someone swaps a directory on the path
+ * for a symlink after we canonicalized it, we fail rather than escape dir. */
+auto OpenBeneath(const std::string& dir, std::string_view rel) -> int {
+  int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  while (dir_fd >= 0) {
+    const size_t slash = rel.find('/');
+    const bool last = slash == std::string_view::npos;
+    const std::string component(rel.substr(0, slash));
+    // O_NONBLOCK keeps us from hanging on FIFOs, which we reject below anyway:
+    const int fd =
+        openat(dir_fd, component.c_str(),
+               O_RDONLY | O_NOFOLLOW | O_CLOEXEC |
+                   (last ? O_NONBLOCK : O_DIRECTORY));
+    close(dir_fd);
+    if (last) {
+      return fd;
+    }
+    dir_fd = fd;
+    rel.remove_prefix(slash + 1);
+  }
+  return -1;
+}
+
+/** A file mapping, sized to whole pages. */
+struct Mapping {
+  void* data;
+  size_t size;
+};
+
+void Unmap(void* /*data*/, size_t /*length*/, void* deleter_data) {
+  // This may run on any thread. Both munmap and VirtualAddressSpace are
+  // thread-safe.
+  const std::unique_ptr<Mapping> mapping(static_cast<Mapping*>(deleter_data));
+#if defined(V8_ENABLE_SANDBOX)
+  v8::V8::GetSandboxAddressSpace()->FreePages(
+      reinterpret_cast<uintptr_t>(mapping->data), mapping->size);
+#else
+  munmap(mapping->data, mapping->size);
+#endif  // V8_ENABLE_SANDBOX
+}
+
+/** Maps len bytes of fd, copy-on-write, so that scripts which write to the
+ * ArrayBuffer change only their own copy. Returns nullptr on failure. */
+auto Map(int fd, size_t len) -> std::unique_ptr<Mapping> {
+#if defined(V8_ENABLE_SANDBOX)
+  // Reserve pages in the sandbox, and map the file over them:
+  v8::VirtualAddressSpace* space = v8::V8::GetSandboxAddressSpace();
+  const size_t granularity = space->allocation_granularity();
+  const size_t size = (len + granularity - 1) / granularity * granularity;
+  const uintptr_t address =
+      space->AllocatePages(v8::VirtualAddressSpace::kNoHint, size, granularity,
+                           v8::PagePermissions::kNoAccess);
+  if (address == 0) {
+    return nullptr;
+  }
+  // NOLINTNEXTLINE(performance-no-int-to-ptr)
+  void* data = mmap(reinterpret_cast<void*>(address), size,
+                    PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+  if (data == MAP_FAILED) {
+    space->FreePages(address, size);
+    return nullptr;
+  }
+#else
+  const size_t size = len;
+  void* data =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+#endif  // V8_ENABLE_SANDBOX
+  return std::make_unique<Mapping>(Mapping{data, size});
+}
+
+#endif  // V8_OS_POSIX
+
+}  // end anonymous namespace
+
+auto FileAllowlist::Add(std::string_view dir) -> bool {
+#if defined(V8_OS_POSIX)
+  std::string canonical = Canonicalize(dir);
+  struct stat info {};
+  if (canonical.empty() || stat(canonical.c_str(), &info) != 0 ||
+      !S_ISDIR(info.st_mode)) {
+    return false;
+  }
+  const std::lock_guard<std::mutex> lock(mutex_);
+  dirs_.push_back(std::move(canonical));
+  return true;
+#else
+  std::ignore = dir;
+  return false;
+#endif  // V8_OS_POSIX
+}
+
+auto FileAllowlist::Open(std::string_view path) const -> int {
+#if defined(V8_OS_POSIX)
+  const std::string canonical = Canonicalize(path);
+  if (canonical.empty()) {
+    return -1;
+  }
+  const std::lock_guard<std::mutex> lock(mutex_);
+  for (const std::string& dir : dirs_) {
+    // ("/" is the only canonical path which ends in a slash.)
+    const size_t prefix_len = dir == "/" ? 1 : dir.size() + 1;
+    if (canonical.size() > prefix_len &&
+        canonical.compare(0, dir.size(), dir) == 0 &&
+        canonical[prefix_len - 1] == '/') {
+      return OpenBeneath(dir, std::string_view(canonical).substr(prefix_len));
+    }
+  }
+  return -1;
+#else
+  std::ignore = path;
+  return -1;
+#endif  // V8_OS_POSIX
+}
+
+std::shared_ptr<IdMaker<FileAllowlist>> FileReader::allowlists_;
+std::once_flag FileReader::allowlists_init_flag_;
+
+auto FileReader::GetAllowlists() -> std::shared_ptr<IdMaker<FileAllowlist>> {
+  std::call_once(allowlists_init_flag_, []() {
+    allowlists_ = std::make_shared<IdMaker<FileAllowlist>>();
+  });
+  return allowlists_;
+}
+
+FileReader::FileReader(ContextHolder* context_holder)
+    : context_holder_(context_holder),
+      allowlist_(std::make_shared<FileAllowlist>()),
+      allowlist_holder_(allowlist_, GetAllowlists()) {}
+
+auto FileReader::AllowDirectory(v8::Isolate* isolate, std::string_view dir)
+    -> bool {
+  if (!allowlist_->Add(dir)) {
+    return false;
+  }
+  if (installed_) {
+    return true;
+  }
+
+  const v8::Isolate::Scope isolate_scope(isolate);
+  const v8::HandleScope handle_scope(isolate);
+  const v8::Local<v8::Context> context = context_holder_->Get()->Get(isolate);
+  const v8::Context::Scope context_scope(context);
+
+  // As in JSCallbackMaker, we give the function a BigInt indicating the
+  // allowlist ID, rather than a pointer:
+  const v8::Local<v8::Value> data =
+      v8::BigInt::NewFromUnsigned(isolate, allowlist_holder_.GetId());
+  const v8::Local<v8::String> name =
+      v8::String::NewFromUtf8Literal(isolate, "readFileSync");
+  v8::Local<v8::Function> func;
+  if (!v8::Function::New(context, &FileReader::OnCalledStatic, data, 1)
+           .ToLocal(&func)) {
+    return false;
+  }
+  func->SetName(name);
+  if (context->Global()
+          ->DefineOwnProperty(context, name, func, v8::DontEnum)
+          .IsNothing()) {
+    return false;
+  }
+  installed_ = true;
+  return true;
+}
+
+void FileReader::OnCalledStatic(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+  const v8::Local<v8::Value> data = info.Data();
+  if (!data->IsBigInt()) {
+    return;
+  }
+  bool lossless = false;
+  const uint64_t allowlist_id = data.As<v8::BigInt>()->Uint64Value(&lossless);
+  if (!lossless) {
+    return;
+  }
+  const std::shared_ptr<FileAllowlist> allowlist =
+      GetAllowlists()->GetObject(allowlist_id);
+  if (!allowlist) {
+    return;
+  }
+
+  if (info.Length() < 1) {
+    ThrowError(isolate, "readFileSync: 1 argument required");
+    return;
+  }
+  v8::Local<v8::String> path_str;
+  if (!info[0]->ToString(context).ToLocal(&path_str)) {
+    return;
+  }
+  const v8::String::Utf8Value path_utf8(isolate, path_str);
+  const std::string path(*path_utf8, static_cast<size_t>(path_utf8.length()));
+
+#if defined(V8_OS_POSIX)
+  // We don't distinguish missing files from forbidden ones, so as not to leak
+  // information about the filesystem outside the allowed directories:
+  const int fd = allowlist->Open(path);
+  if (fd < 0) {
+    ThrowError(isolate, "readFileSync: no such file in an allowed directory: " +
+                            path);
+    return;
+  }
+  struct stat stat_info {};
+  if (fstat(fd, &stat_info) != 0 || !S_ISREG(stat_info.st_mode)) {
+    close(fd);
+    ThrowError(isolate, "readFileSync: not a regular file: " + path);
+    return;
+  }
+  const auto len = static_cast<size_t>(stat_info.st_size);
+  if (len > v8::TypedArray::kMaxByteLength) {
+    close(fd);
+    ThrowError(isolate, "readFileSync: file too large: " + path);
+    return;
+  }
+  if (len == 0) {
+    close(fd);
+    info.GetReturnValue().Set(v8::ArrayBuffer::New(isolate, 0));
+    return;
+  }
+
+  std::unique_ptr<Mapping> mapping = Map(fd, len);
+  close(fd);
+  if (!mapping) {
+    ThrowError(isolate, "readFileSync: could not map file: " + path);
+    return;
+  }
+  void* const mapped = mapping->data;
+  std::unique_ptr<v8::BackingStore> store = v8::ArrayBuffer::NewBackingStore(
+      mapped, len, &Unmap, mapping.release());
+  info.GetReturnValue().Set(v8::ArrayBuffer::New(isolate, std::move(store)));
+#else
+  std::ignore = allowlist;
+  ThrowError(isolate, "readFileSync: not supported on this platform");
+#endif  // V8_OS_POSIX
+}
+
+}  // end namespace MiniRacer
@@ -0,0 +1,69 @@
+#ifndef INCLUDE_MINI_RACER_FILE_READER_H
+#define INCLUDE_MINI_RACER_FILE_READER_H
+
+#include <v8-function-callback.h>
+#include <v8-isolate.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "context_holder.h"
+#include "id_maker.h"
+
+namespace MiniRacer {
+
+/** The directories from which JavaScript may read files. */
+class FileAllowlist {
+ public:
+  /** Allows reads from within dir, which must be an existing directory.
+   * Returns false otherwise, or if this platform doesn't support file reads.
+   */
+  auto Add(std::string_view dir) -> bool;
+
+  /** If path names a file within an allowed directory, opens it read-only.
+   * Returns a file descriptor, or -1. */
+  auto Open(std::string_view path) const -> int;
+
+ private:
+  mutable std::mutex mutex_;
+  // Canonical (i.e., absolute, with no symlinks) paths:
+  std::vector<std::string> dirs_;
+};
+
+/** Gives JavaScript a global readFileSync(path) function, which reads files
+ * from directories the MiniRacer user (i.e., Python) allows, and returns their
+ * contents as an ArrayBuffer.
+ *
+ * Rather than read files, we map them (copy-on-write) into memory, so that
+ * scripts can read large files lazily and with no copy. With the V8 sandbox,
+ * we map files into pages allocated from the sandbox, since V8 requires
+ * ArrayBuffer backing stores to live there.
+ *
+ * As with JSCallbackMaker, the function we give JavaScript refers to the
+ * allowlist by ID, not pointer, so that late calls are safely ignored. */
+class FileReader {
+ public:
+  explicit FileReader(ContextHolder* context_holder);
+
+  /** Allows reads from within dir, and installs readFileSync the first time.
+   * Returns false if dir isn't a directory, or if this platform doesn't support
+   * file reads. Must be called from the isolate message pump. */
+  auto AllowDirectory(v8::Isolate* isolate, std::string_view dir) -> bool;
+
+ private:
+  static void OnCalledStatic(const v8::FunctionCallbackInfo<v8::Value>& info);
+  static auto GetAllowlists() -> std::shared_ptr<IdMaker<FileAllowlist>>;
+
+  static std::shared_ptr<IdMaker<FileAllowlist>> allowlists_;
+  static std::once_flag allowlists_init_flag_;
+
+  ContextHolder* context_holder_;
+  std::shared_ptr<FileAllowlist> allowlist_;
+  IdHolder<FileAllowlist> allowlist_holder_;
+  bool installed_{false};
+};
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_FILE_READER_H
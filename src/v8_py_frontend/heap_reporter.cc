@@ -1,12 +1,23 @@
 #include "heap_reporter.h"
+#include <v8-container.h>
+#include <v8-context.h>
 #include <v8-exception.h>
 #include <v8-json.h>
 #include <v8-local-handle.h>
 #include <v8-primitive.h>
 #include <v8-profiler.h>
 #include <v8-statistics.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "binary_value.h"
 
 namespace MiniRacer {
@@ -91,4 +102,500 @@ auto HeapReporter::HeapSnapshot(v8::Isolate* isolate) -> BinaryValue::Ptr {
   return bv_factory_->New(sos.result(), type_str_utf8);
 }
 
+namespace {
+
+constexpr uint32_t kNoNode = std::numeric_limits<uint32_t>::max();
+
+/** Groups heap graph nodes the way the DevTools "Summary" view does: objects
+ * by constructor name, and everything else by type. */
+auto GetClassName(v8::Isolate* isolate, const v8::HeapGraphNode* node)
+    -> std::string {
+  switch (node->GetType()) {
+    case v8::HeapGraphNode::kObject:
+    case v8::HeapGraphNode::kNative: {
+      const v8::String::Utf8Value name(isolate, node->GetName());
+      return {*name, static_cast<size_t>(name.length())};
+    }
+    case v8::HeapGraphNode::kArray:
+      return "(array)";
+    case v8::HeapGraphNode::kString:
+    case v8::HeapGraphNode::kConsString:
+    case v8::HeapGraphNode::kSlicedString:
+      return "(string)";
+    case v8::HeapGraphNode::kCode:
+      return "(compiled code)";
+    case v8::HeapGraphNode::kClosure:
+      return "(closure)";
+    case v8::HeapGraphNode::kRegExp:
+      return "(regexp)";
+    case v8::HeapGraphNode::kHeapNumber:
+      return "(number)";
+    case v8::HeapGraphNode::kSymbol:
+      return "(symbol)";
+    case v8::HeapGraphNode::kBigInt:
+      return "(bigint)";
+    case v8::HeapGraphNode::kObjectShape:
+      return "(object shape)";
+    case v8::HeapGraphNode::kSynthetic:
+      return "(synthetic)";
+    case v8::HeapGraphNode::kHidden:
+    default:
+      return "(system)";
+  }
+}
+
+struct ClassSummary {
+  std::string name;
+  uint64_t count;
+  uint64_t shallow_size;
+  uint64_t retained_size;
+};
+
+/** Aggregates a heap snapshot by class (see GetClassName).
+ *
+ * The snapshot API gives us shallow sizes only, so we compute retained sizes
+ * ourselves: we build the dominator tree of the heap graph (using the
+ * iterative algorithm from Cooper, Harvey, and Kennedy, "A Simple, Fast
+ * Dominance Algorithm"), and sum shallow sizes up the tree. Like V8's own
+ * size calculation, we don't follow weak or shortcut edges.
+ *
+ * As in DevTools, a class's retained size only counts objects which aren't
+ * dominated by another object of the same class, so nested objects aren't
+ * counted twice. */
+class HeapSummarizer {
+ public:
+  HeapSummarizer(v8::Isolate* isolate, const v8::HeapSnapshot* snap);
+
+  auto Summarize() -> std::vector<ClassSummary>;
+
+ private:
+  void NumberNodes();
+  void ComputeDominators();
+  auto Intersect(uint32_t po_a, uint32_t po_b) const -> uint32_t;
+  void SumRetainedSizes(std::vector<ClassSummary>* classes);
+
+  v8::Isolate* isolate_;
+  const v8::HeapSnapshot* snap_;
+  // Snapshot node index to class index:
+  std::vector<uint32_t> class_of_;
+  // Snapshot node index to postorder number (kNoNode if unreachable), and
+  // back:
+  std::vector<uint32_t> po_of_;
+  std::vector<uint32_t> node_of_;
+  // Predecessors of each reachable node, by postorder number, in CSR form:
+  std::vector<uint32_t> pred_begin_;
+  std::vector<uint32_t> preds_;
+  // Immediate dominator of each reachable node, by postorder number:
+  std::vector<uint32_t> idom_;
+};
+
+auto FollowEdge(const v8::HeapGraphEdge* edge) -> bool {
+  return edge->GetType() != v8::HeapGraphEdge::kWeak &&
+         edge->GetType() != v8::HeapGraphEdge::kShortcut;
+}
+
+HeapSummarizer::HeapSummarizer(v8::Isolate* isolate,
+                               const v8::HeapSnapshot* snap)
+    : isolate_(isolate), snap_(snap) {}
+
+auto HeapSummarizer::Summarize() -> std::vector<ClassSummary> {
+  const auto node_count = static_cast<uint32_t>(snap_->GetNodesCount());
+
+  std::vector<ClassSummary> classes;
+  std::unordered_map<std::string, uint32_t> class_ids;
+  class_of_.resize(node_count);
+  for (uint32_t i = 0; i < node_count; i++) {
+    const v8::HeapGraphNode* node = snap_->GetNode(static_cast<int>(i));
+    const auto [iter, inserted] = class_ids.try_emplace(
+        GetClassName(isolate_, node), static_cast<uint32_t>(classes.size()));
+    if (inserted) {
+      classes.push_back({iter->first, 0, 0, 0});
+    }
+    class_of_[i] = iter->second;
+    ClassSummary& summary = classes[iter->second];
+    summary.count++;
+    summary.shallow_size += node->GetShallowSize();
+  }
+
+  NumberNodes();
+  ComputeDominators();
+  SumRetainedSizes(&classes);
+  return classes;
+}
+
+void HeapSummarizer::NumberNodes() {
+  const auto node_count = static_cast<uint32_t>(snap_->GetNodesCount());
+
+  std::unordered_map<const v8::HeapGraphNode*, uint32_t> index_of;
+  index_of.reserve(node_count);
+  for (uint32_t i = 0; i < node_count; i++) {
+    index_of.emplace(snap_->GetNode(static_cast<int>(i)), i);
+  }
+  const auto to_index = [&index_of](const v8::HeapGraphEdge* edge) {
+    return index_of.at(edge->GetToNode());
+  };
+
+  // Number nodes in postorder, with an iterative DFS from the root. Each stack
+  // entry is a node index and the next child to visit.
+  po_of_.assign(node_count, kNoNode);
+  node_of_.clear();
+  std::vector<bool> visited(node_count, false);
+  std::vector<std::pair<uint32_t, int>> stack;
+  const uint32_t root = index_of.at(snap_->GetRoot());
+  visited[root] = true;
+  stack.emplace_back(root, 0);
+  while (!stack.empty()) {
+    auto& [index, next_child] = stack.back();
+    const v8::HeapGraphNode* node = snap_->GetNode(static_cast<int>(index));
+    if (next_child < node->GetChildrenCount()) {
+      const v8::HeapGraphEdge* edge = node->GetChild(next_child++);
+      if (!FollowEdge(edge)) {
+        continue;
+      }
+      const uint32_t child = to_index(edge);
+      if (!visited[child]) {
+        visited[child] = true;
+        stack.emplace_back(child, 0);
+      }
+      continue;
+    }
+    po_of_[index] = static_cast<uint32_t>(node_of_.size());
+    node_of_.push_back(index);
+    stack.pop_back();
+  }
+
+  // Gather predecessors:
+  const auto reachable = static_cast<uint32_t>(node_of_.size());
+  pred_begin_.assign(reachable + 1, 0);
+  for (const uint32_t index : node_of_) {
+    const v8::HeapGraphNode* node = snap_->GetNode(static_cast<int>(index));
+    for (int i = 0; i < node->GetChildrenCount(); i++) {
+      const v8::HeapGraphEdge* edge = node->GetChild(i);
+      if (FollowEdge(edge)) {
+        pred_begin_[po_of_[to_index(edge)] + 1]++;
+      }
+    }
+  }
+  for (uint32_t po = 0; po < reachable; po++) {
+    pred_begin_[po + 1] += pred_begin_[po];
+  }
+  preds_.resize(pred_begin_[reachable]);
+  std::vector<uint32_t> fill(pred_begin_.begin(), pred_begin_.end() - 1);
+  for (uint32_t po = 0; po < reachable; po++) {
+    const v8::HeapGraphNode* node =
+        snap_->GetNode(static_cast<int>(node_of_[po]));
+    for (int i = 0; i < node->GetChildrenCount(); i++) {
+      const v8::HeapGraphEdge* edge = node->GetChild(i);
+      if (FollowEdge(edge)) {
+        preds_[fill[po_of_[to_index(edge)]]++] = po;
+      }
+    }
+  }
+}
+
+void HeapSummarizer::ComputeDominators() {
+  const auto reachable = static_cast<uint32_t>(node_of_.size());
+  const uint32_t root = reachable - 1;
+  idom_.assign(reachable, kNoNode);
+  idom_[root] = root;
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    // Visit in reverse postorder, skipping the root:
+    for (uint32_t po = root; po-- > 0;) {
+      uint32_t new_idom = kNoNode;
+      for (uint32_t i = pred_begin_[po]; i < pred_begin_[po + 1]; i++) {
+        const uint32_t pred = preds_[i];
+        if (idom_[pred] == kNoNode) {
+          continue;
+        }
+        new_idom = new_idom == kNoNode ? pred : Intersect(pred, new_idom);
+      }
+      if (idom_[po] != new_idom) {
+        idom_[po] = new_idom;
+        changed = true;
+      }
+    }
+  }
+}
+
+auto HeapSummarizer::Intersect(uint32_t po_a, uint32_t po_b) const
+    -> uint32_t {
+  while (po_a != po_b) {
+    while (po_a < po_b) {
+      po_a = idom_[po_a];
+    }
+    while (po_b < po_a) {
+      po_b = idom_[po_b];
+    }
+  }
+  return po_a;
+}
+
+void HeapSummarizer::SumRetainedSizes(std::vector<ClassSummary>* classes) {
+  const auto reachable = static_cast<uint32_t>(node_of_.size());
+  const uint32_t root = reachable - 1;
+
+  // A dominator always comes after the nodes it dominates in postorder, so one
+  // forward pass sums retained sizes up the tree:
+  std::vector<uint64_t> retained(reachable);
+  for (uint32_t po = 0; po < reachable; po++) {
+    retained[po] +=
+        snap_->GetNode(static_cast<int>(node_of_[po]))->GetShallowSize();
+    if (po != root) {
+      retained[idom_[po]] += retained[po];
+    }
+  }
+
+  // Build the dominator tree, in CSR form, to walk it from the root:
+  std::vector<uint32_t> child_begin(reachable + 1, 0);
+  for (uint32_t po = 0; po < root; po++) {
+    child_begin[idom_[po] + 1]++;
+  }
+  for (uint32_t po = 0; po < reachable; po++) {
+    child_begin[po + 1] += child_begin[po];
+  }
+  std::vector<uint32_t> children(child_begin[reachable]);
+  std::vector<uint32_t> fill(child_begin.begin(), child_begin.end() - 1);
+  for (uint32_t po = 0; po < root; po++) {
+    children[fill[idom_[po]]++] = po;
+  }
+
+  // Walk the tree, tracking how many objects of each class are on the path
+  // from the root, and credit each object's retained size to its class only if
+  // none are:
+  std::vector<uint32_t> on_path(classes->size(), 0);
+  std::vector<std::pair<uint32_t, uint32_t>> stack;
+  stack.emplace_back(root, child_begin[root]);
+  on_path[class_of_[node_of_[root]]]++;
+  while (!stack.empty()) {
+    auto& [po, next_child] = stack.back();
+    if (next_child < child_begin[po + 1]) {
+      const uint32_t child = children[next_child++];
+      const uint32_t class_id = class_of_[node_of_[child]];
+      if (on_path[class_id] == 0) {
+        (*classes)[class_id].retained_size += retained[child];
+      }
+      on_path[class_id]++;
+      stack.emplace_back(child, child_begin[child]);
+      continue;
+    }
+    on_path[class_of_[node_of_[po]]]--;
+    stack.pop_back();
+  }
+}
+
+/** Sorts classes by the given field, largest first, and keeps the first top_n
+ * (or all, if top_n is 0). */
+void KeepTop(std::vector<ClassSummary>* classes,
+             size_t top_n,
+             uint64_t ClassSummary::* field) {
+  const auto by_field = [field](const ClassSummary& lhs,
+                                const ClassSummary& rhs) {
+    return lhs.*field > rhs.*field;
+  };
+  if (top_n > 0 && top_n < classes->size()) {
+    std::partial_sort(classes->begin(),
+                      classes->begin() + static_cast<ptrdiff_t>(top_n),
+                      classes->end(), by_field);
+    classes->resize(top_n);
+    return;
+  }
+  std::sort(classes->begin(), classes->end(), by_field);
+}
+
+/** A compact table of figures by class, along with some overall totals. */
+struct ClassTable {
+  std::vector<std::pair<const char*, uint64_t>> totals;
+  // Not including the leading "name" column:
+  std::vector<const char*> columns;
+  std::vector<std::pair<std::string, std::vector<uint64_t>>> rows;
+};
+
+/** Renders a ClassTable as JSON:
+ *   {<totals>..., "columns": ["name", <columns>...],
+ *    "rows": [[<name>, <values>...], ...]} */
+auto TableToJSON(v8::Isolate* isolate,
+                 BinaryValueFactory* bv_factory,
+                 const ClassTable& table) -> BinaryValue::Ptr {
+  const v8::TryCatch trycatch(isolate);
+  const v8::Local<v8::Context> context = v8::Context::New(isolate);
+  const v8::Context::Scope context_scope(context);
+
+  const auto number = [isolate](uint64_t val) {
+    return v8::Number::New(isolate, static_cast<double>(val));
+  };
+  const auto string = [isolate](std::string_view str) {
+    return v8::String::NewFromUtf8(isolate, str.data(),
+                                   v8::NewStringType::kNormal,
+                                   static_cast<int>(str.size()));
+  };
+
+  const v8::Local<v8::Object> table_obj = v8::Object::New(isolate);
+  for (const auto& [name, val] : table.totals) {
+    table_obj->Set(context, string(name).ToLocalChecked(), number(val))
+        .Check();
+  }
+
+  const v8::Local<v8::Array> columns =
+      v8::Array::New(isolate, static_cast<int>(table.columns.size() + 1));
+  columns->Set(context, 0, v8::String::NewFromUtf8Literal(isolate, "name"))
+      .Check();
+  for (size_t i = 0; i < table.columns.size(); i++) {
+    columns
+        ->Set(context, static_cast<uint32_t>(i + 1),
+              string(table.columns[i]).ToLocalChecked())
+        .Check();
+  }
+  table_obj
+      ->Set(context, v8::String::NewFromUtf8Literal(isolate, "columns"),
+            columns)
+      .Check();
+
+  const v8::Local<v8::Array> rows =
+      v8::Array::New(isolate, static_cast<int>(table.rows.size()));
+  for (size_t i = 0; i < table.rows.size(); i++) {
+    const auto& [name, values] = table.rows[i];
+    v8::Local<v8::String> name_str;
+    if (!string(name).ToLocal(&name_str)) {
+      return bv_factory->New("error building heap table", type_str_utf8);
+    }
+    const v8::Local<v8::Array> row =
+        v8::Array::New(isolate, static_cast<int>(values.size() + 1));
+    row->Set(context, 0, name_str).Check();
+    for (size_t j = 0; j < values.size(); j++) {
+      row->Set(context, static_cast<uint32_t>(j + 1), number(values[j]))
+          .Check();
+    }
+    rows->Set(context, static_cast<uint32_t>(i), row).Check();
+  }
+  table_obj
+      ->Set(context, v8::String::NewFromUtf8Literal(isolate, "rows"), rows)
+      .Check();
+
+  v8::Local<v8::String> output;
+  if (!v8::JSON::Stringify(context, table_obj).ToLocal(&output) ||
+      output.IsEmpty()) {
+    return bv_factory->New("error stringifying heap output", type_str_utf8);
+  }
+  return bv_factory->New(context, output);
+}
+
+class DiscardingOutputStream : public v8::OutputStream {
+ public:
+  auto WriteAsciiChunk(char* /*data*/, int /*size*/) -> WriteResult override {
+    return kContinue;
+  }
+
+  auto WriteHeapStatsChunk(v8::HeapStatsUpdate* /*data*/, int /*count*/)
+      -> WriteResult override {
+    return kContinue;
+  }
+
+  void EndOfStream() override {}
+};
+
+}  // end anonymous namespace
+
+auto HeapReporter::HeapSummary(v8::Isolate* isolate, size_t top_n)
+    -> BinaryValue::Ptr {
+  const v8::Isolate::Scope isolatescope(isolate);
+  const v8::HandleScope handle_scope(isolate);
+
+  v8::HeapProfiler* profiler = isolate->GetHeapProfiler();
+  const v8::HeapSnapshot* snap = profiler->TakeHeapSnapshot();
+  const auto node_count = static_cast<uint64_t>(snap->GetNodesCount());
+  std::vector<ClassSummary> classes = HeapSummarizer(isolate, snap).Summarize();
+  profiler->DeleteAllHeapSnapshots();
+
+  uint64_t total_size = 0;
+  for (const ClassSummary& summary : classes) {
+    total_size += summary.shallow_size;
+  }
+  KeepTop(&classes, top_n, &ClassSummary::retained_size);
+
+  ClassTable table;
+  table.totals = {{"node_count", node_count}, {"total_size", total_size}};
+  table.columns = {"count", "shallow_size", "retained_size"};
+  for (ClassSummary& summary : classes) {
+    table.rows.emplace_back(
+        std::move(summary.name),
+        std::vector<uint64_t>{summary.count, summary.shallow_size,
+                              summary.retained_size});
+  }
+  return TableToJSON(isolate, bv_factory_, table);
+}
+
+auto HeapReporter::SetHeapGrowthBaseline(v8::Isolate* isolate)
+    -> BinaryValue::Ptr {
+  const v8::Isolate::Scope isolatescope(isolate);
+  const v8::HandleScope handle_scope(isolate);
+
+  v8::HeapProfiler* profiler = isolate->GetHeapProfiler();
+  if (!growth_baseline_.has_value()) {
+    profiler->StartTrackingHeapObjects();
+  }
+
+  // This assigns IDs to any objects which don't have them yet, and returns the
+  // last one assigned. Any object with a larger ID is newer:
+  DiscardingOutputStream stream;
+  growth_baseline_ = profiler->GetHeapStats(&stream);
+  return bv_factory_->New(static_cast<int64_t>(*growth_baseline_),
+                          type_integer);
+}
+
+auto HeapReporter::HeapGrowth(v8::Isolate* isolate, size_t top_n)
+    -> BinaryValue::Ptr {
+  const v8::Isolate::Scope isolatescope(isolate);
+  const v8::HandleScope handle_scope(isolate);
+
+  if (!growth_baseline_.has_value()) {
+    return bv_factory_->New("no heap growth baseline was recorded",
+                            type_value_exception);
+  }
+  const v8::SnapshotObjectId baseline = *growth_baseline_;
+
+  // Taking a snapshot collects garbage first, so everything in it is alive:
+  v8::HeapProfiler* profiler = isolate->GetHeapProfiler();
+  const v8::HeapSnapshot* snap = profiler->TakeHeapSnapshot();
+
+  std::vector<ClassSummary> classes;
+  std::unordered_map<std::string, size_t> class_ids;
+  uint64_t object_count = 0;
+  uint64_t total_size = 0;
+  for (int i = 0; i < snap->GetNodesCount(); i++) {
+    const v8::HeapGraphNode* node = snap->GetNode(i);
+    if (node->GetId() <= baseline ||
+        node->GetType() == v8::HeapGraphNode::kSynthetic) {
+      continue;
+    }
+    const auto [iter, inserted] =
+        class_ids.try_emplace(GetClassName(isolate, node), classes.size());
+    if (inserted) {
+      classes.push_back({iter->first, 0, 0, 0});
+    }
+    ClassSummary& summary = classes[iter->second];
+    summary.count++;
+    summary.shallow_size += node->GetShallowSize();
+    object_count++;
+    total_size += node->GetShallowSize();
+  }
+  profiler->DeleteAllHeapSnapshots();
+
+  KeepTop(&classes, top_n, &ClassSummary::shallow_size);
+
+  ClassTable table;
+  table.totals = {{"baseline_object_id", baseline},
+                  {"object_count", object_count},
+                  {"total_size", total_size}};
+  table.columns = {"count", "size"};
+  for (ClassSummary& summary : classes) {
+    table.rows.emplace_back(
+        std::move(summary.name),
+        std::vector<uint64_t>{summary.count, summary.shallow_size});
+  }
+  return TableToJSON(isolate, bv_factory_, table);
+}
+
 }  // end namespace MiniRacer
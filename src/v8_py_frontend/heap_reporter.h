@@ -2,6 +2,9 @@
 #define INCLUDE_MINI_RACER_HEAP_REPORTER_H
 
 #include <v8-isolate.h>
+#include <v8-profiler.h>
+#include <cstddef>
+#include <optional>
 #include "binary_value.h"
 
 namespace MiniRacer {
@@ -13,9 +16,21 @@ class HeapReporter {
 
   auto HeapSnapshot(v8::Isolate* isolate) -> BinaryValue::Ptr;
   auto HeapStats(v8::Isolate* isolate) -> BinaryValue::Ptr;
+  /** Takes a heap snapshot, and summarizes it by constructor: the count,
+   * total shallow size, and total retained size of objects of each, for the
+   * top_n constructors by retained size (or all, if top_n is 0). */
+  auto HeapSummary(v8::Isolate* isolate, size_t top_n) -> BinaryValue::Ptr;
+  /** Records which heap objects exist now, for HeapGrowth. Returns the last
+   * heap object ID assigned so far. */
+  auto SetHeapGrowthBaseline(v8::Isolate* isolate) -> BinaryValue::Ptr;
+  /** Summarizes the objects allocated since SetHeapGrowthBaseline which are
+   * still alive, by constructor: their count and total size, for the top_n
+   * constructors by size (or all, if top_n is 0). */
+  auto HeapGrowth(v8::Isolate* isolate, size_t top_n) -> BinaryValue::Ptr;
 
  private:
   BinaryValueFactory* bv_factory_;
+  std::optional<v8::SnapshotObjectId> growth_baseline_;
 };
 
 }  // end namespace MiniRacer
@@ -0,0 +1,155 @@
+#include "huge_pages.h"
+
+#include <v8-array-buffer.h>
+#include <v8-platform.h>
+#include <v8config.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#if defined(V8_OS_LINUX)
+#include <sys/mman.h>
+#endif  // V8_OS_LINUX
+
+namespace MiniRacer {
+
+namespace {
+
+constexpr uintptr_t kHugePageSize = uintptr_t{2} << 20;
+
+std::atomic<bool> huge_pages_enabled{false};
+
+}  // end anonymous namespace
+
+void SetHugePagesEnabled(bool enabled) {
+  huge_pages_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+auto HugePagesEnabled() -> bool {
+  return huge_pages_enabled.load(std::memory_order_relaxed);
+}
+
+#if defined(V8_OS_LINUX) && defined(MADV_HUGEPAGE)
+
+void AdviseHugePages(void* address, size_t length) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto start = reinterpret_cast<uintptr_t>(address);
+  const uintptr_t begin = (start + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  const uintptr_t end = (start + length) & ~(kHugePageSize - 1);
+  if (address == nullptr || end <= begin) {
+    return;
+  }
+  // This is only advice, which the kernel may reject (e.g., if THP is
+  // disabled outright), so we ignore failures:
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  void* aligned = static_cast<char*>(address) + (begin - start);
+  madvise(aligned, end - begin, MADV_HUGEPAGE);
+}
+
+#else  // V8_OS_LINUX && MADV_HUGEPAGE
+
+void AdviseHugePages(void* /*address*/, size_t /*length*/) {}
+
+#endif  // V8_OS_LINUX && MADV_HUGEPAGE
+
+HugePageAllocator::HugePageAllocator(v8::PageAllocator* page_allocator)
+    : page_allocator_(page_allocator) {}
+
+auto HugePageAllocator::AllocatePageSize() -> size_t {
+  return page_allocator_->AllocatePageSize();
+}
+
+auto HugePageAllocator::CommitPageSize() -> size_t {
+  return page_allocator_->CommitPageSize();
+}
+
+void HugePageAllocator::SetRandomMmapSeed(int64_t seed) {
+  page_allocator_->SetRandomMmapSeed(seed);
+}
+
+auto HugePageAllocator::GetRandomMmapAddr() -> void* {
+  return page_allocator_->GetRandomMmapAddr();
+}
+
+auto HugePageAllocator::AllocatePages(void* address,
+                                      size_t length,
+                                      size_t alignment,
+                                      Permission permissions) -> void* {
+  void* pages =
+      page_allocator_->AllocatePages(address, length, alignment, permissions);
+  // Executable regions are left alone, since V8 may want to remap them:
+  if (permissions != kReadWriteExecute && permissions != kReadExecute &&
+      permissions != kNoAccessWillJitLater) {
+    AdviseHugePages(pages, length);
+  }
+  return pages;
+}
+
+auto HugePageAllocator::FreePages(void* address, size_t length) -> bool {
+  return page_allocator_->FreePages(address, length);
+}
+
+auto HugePageAllocator::ReleasePages(void* address,
+                                     size_t length,
+                                     size_t new_length) -> bool {
+  return page_allocator_->ReleasePages(address, length, new_length);
+}
+
+auto HugePageAllocator::SetPermissions(void* address,
+                                       size_t length,
+                                       Permission permissions) -> bool {
+  return page_allocator_->SetPermissions(address, length, permissions);
+}
+
+auto HugePageAllocator::RecommitPages(void* address,
+                                      size_t length,
+                                      Permission permissions) -> bool {
+  return page_allocator_->RecommitPages(address, length, permissions);
+}
+
+auto HugePageAllocator::DiscardSystemPages(void* address, size_t size)
+    -> bool {
+  return page_allocator_->DiscardSystemPages(address, size);
+}
+
+auto HugePageAllocator::DecommitPages(void* address, size_t size) -> bool {
+  return page_allocator_->DecommitPages(address, size);
+}
+
+auto HugePageAllocator::ReserveForSharedMemoryMapping(void* address,
+                                                      size_t size) -> bool {
+  return page_allocator_->ReserveForSharedMemoryMapping(address, size);
+}
+
+auto HugePageAllocator::AllocateSharedPages(size_t length,
+                                            const void* original_address)
+    -> std::unique_ptr<SharedMemory> {
+  return page_allocator_->AllocateSharedPages(length, original_address);
+}
+
+auto HugePageAllocator::CanAllocateSharedPages() -> bool {
+  return page_allocator_->CanAllocateSharedPages();
+}
+
+HugePageArrayBufferAllocator::HugePageArrayBufferAllocator()
+    : allocator_(v8::ArrayBuffer::Allocator::NewDefaultAllocator()) {}
+
+auto HugePageArrayBufferAllocator::Allocate(size_t length) -> void* {
+  void* data = allocator_->Allocate(length);
+  AdviseHugePages(data, length);
+  return data;
+}
+
+auto HugePageArrayBufferAllocator::AllocateUninitialized(size_t length)
+    -> void* {
+  void* data = allocator_->AllocateUninitialized(length);
+  AdviseHugePages(data, length);
+  return data;
+}
+
+void HugePageArrayBufferAllocator::Free(void* data, size_t length) {
+  allocator_->Free(data, length);
+}
+
+}  // end namespace MiniRacer
@@ -0,0 +1,79 @@
+#ifndef INCLUDE_MINI_RACER_HUGE_PAGES_H
+#define INCLUDE_MINI_RACER_HUGE_PAGES_H
+
+#include <v8-array-buffer.h>
+#include <v8-platform.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace MiniRacer {
+
+/** Turns on transparent huge pages for the ArrayBuffer allocators of
+ * subsequently created isolates (see HugePageArrayBufferAllocator). */
+void SetHugePagesEnabled(bool enabled);
+auto HugePagesEnabled() -> bool;
+
+/** Asks the kernel to back the 2 MiB-aligned interior of the given region with
+ * transparent huge pages, using madvise(MADV_HUGEPAGE). Regions which don't
+ * contain a whole huge page are left alone. Does nothing on platforms other
+ * than Linux. */
+void AdviseHugePages(void* address, size_t length);
+
+/** A v8::PageAllocator which asks for transparent huge pages on every region
+ * it allocates which is big enough to hold any, and otherwise defers to
+ * another page allocator.
+ *
+ * V8 reserves large regions up front (e.g., the pointer compression cage) and
+ * then commits pages within them as the heap grows. Once a region is marked,
+ * pages committed later within it are eligible for huge pages too, which cuts
+ * TLB misses for large heaps. */
+class HugePageAllocator : public v8::PageAllocator {
+ public:
+  explicit HugePageAllocator(v8::PageAllocator* page_allocator);
+
+  auto AllocatePageSize() -> size_t override;
+  auto CommitPageSize() -> size_t override;
+  void SetRandomMmapSeed(int64_t seed) override;
+  auto GetRandomMmapAddr() -> void* override;
+  auto AllocatePages(void* address,
+                     size_t length,
+                     size_t alignment,
+                     Permission permissions) -> void* override;
+  auto FreePages(void* address, size_t length) -> bool override;
+  auto ReleasePages(void* address, size_t length, size_t new_length)
+      -> bool override;
+  auto SetPermissions(void* address, size_t length, Permission permissions)
+      -> bool override;
+  auto RecommitPages(void* address, size_t length, Permission permissions)
+      -> bool override;
+  auto DiscardSystemPages(void* address, size_t size) -> bool override;
+  auto DecommitPages(void* address, size_t size) -> bool override;
+  auto ReserveForSharedMemoryMapping(void* address, size_t size)
+      -> bool override;
+  auto AllocateSharedPages(size_t length, const void* original_address)
+      -> std::unique_ptr<SharedMemory> override;
+  auto CanAllocateSharedPages() -> bool override;
+
+ private:
+  v8::PageAllocator* page_allocator_;
+};
+
+/** A v8::ArrayBuffer::Allocator which asks for transparent huge pages on
+ * large buffers, and otherwise defers to V8's default allocator (which, in
+ * sandboxed builds, is what places buffers inside the sandbox). */
+class HugePageArrayBufferAllocator : public v8::ArrayBuffer::Allocator {
+ public:
+  HugePageArrayBufferAllocator();
+
+  auto Allocate(size_t length) -> void* override;
+  auto AllocateUninitialized(size_t length) -> void* override;
+  void Free(void* data, size_t length) override;
+
+ private:
+  std::unique_ptr<v8::ArrayBuffer::Allocator> allocator_;
+};
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_HUGE_PAGES_H
@@ -3,11 +3,24 @@
 #include <v8-array-buffer.h>
 #include <v8-isolate.h>
 #include <v8-microtask.h>
+#include <memory>
+#include "huge_pages.h"
 
 namespace MiniRacer {
 
-IsolateHolder::IsolateHolder()
-    : allocator_(v8::ArrayBuffer::Allocator::NewDefaultAllocator()) {
+namespace {
+
+auto NewArrayBufferAllocator() -> std::unique_ptr<v8::ArrayBuffer::Allocator> {
+  if (HugePagesEnabled()) {
+    return std::make_unique<HugePageArrayBufferAllocator>();
+  }
+  return std::unique_ptr<v8::ArrayBuffer::Allocator>(
+      v8::ArrayBuffer::Allocator::NewDefaultAllocator());
+}
+
+}  // end anonymous namespace
+
+IsolateHolder::IsolateHolder() : allocator_(NewArrayBufferAllocator()) {
   v8::Isolate::CreateParams create_params;
   create_params.array_buffer_allocator = allocator_.get();
 
@@ -3,7 +3,12 @@
 #include <v8-isolate.h>
 #include <v8-local-handle.h>
 #include <v8-locker.h>
+#include <v8-microtask-queue.h>
+#include <v8-microtask.h>
 #include <v8-platform.h>
+#include <chrono>
+#include <cstdint>
+#include <optional>
 #include <thread>
 #include <tuple>
 #include "isolate_holder.h"
@@ -20,6 +25,23 @@ IsolateManager::~IsolateManager() {
   thread_.join();
 }
 
+void IsolateManager::SetSpinWait(std::chrono::nanoseconds spin_wait) {
+  pump_spinner_.SetMaxSpin(spin_wait);
+  caller_spinner_.SetMaxSpin(spin_wait);
+}
+
+void IsolateManager::SetMicrotaskPolicy(MicrotaskPolicy policy) {
+  Run(
+      [this, policy](v8::Isolate* isolate) {
+        microtask_policy_ = policy;
+        isolate->SetMicrotasksPolicy(policy == MicrotaskPolicy::kScoped
+                                         ? v8::MicrotasksPolicy::kScoped
+                                         : v8::MicrotasksPolicy::kExplicit);
+      },
+      TaskKind::kNoJavaScript)
+      .get();
+}
+
 void IsolateManager::TerminateOngoingTask() {
   isolate_holder_.Get()->TerminateExecution();
 }
@@ -29,6 +51,35 @@ void IsolateManager::StopJavaScript() {
   TerminateOngoingTask();
 }
 
+void IsolateManager::RequestInterrupt(v8::InterruptCallback callback,
+                                      void* data) {
+  isolate_holder_.Get()->RequestInterrupt(callback, data);
+}
+
+void IsolateManager::EnableTaskTracking() {
+  track_tasks_.store(true, std::memory_order_relaxed);
+}
+
+auto IsolateManager::GetRunningTask() const -> std::optional<RunningTask> {
+  const uint64_t seq = running_task_seq_.load(std::memory_order_acquire);
+  const int64_t started =
+      running_task_started_.load(std::memory_order_acquire);
+  const TaskKind kind = running_task_kind_.load(std::memory_order_relaxed);
+  if (started == 0 ||
+      running_task_seq_.load(std::memory_order_acquire) != seq) {
+    return std::nullopt;
+  }
+
+  return RunningTask{seq,
+                     std::chrono::steady_clock::time_point(
+                         std::chrono::steady_clock::duration(started)),
+                     kind};
+}
+
+auto IsolateManager::GetTaskSeq() const -> uint64_t {
+  return running_task_seq_.load(std::memory_order_acquire);
+}
+
 void IsolateManager::PumpMessages() {
   // By design, only this, the message pump thread, is ever allowed to touch
   // the isolate, so go ahead and lock it:
@@ -38,11 +89,11 @@ void IsolateManager::PumpMessages() {
 
   const v8::SealHandleScope shs(isolate);
   while (state_ == State::kRun) {
-    v8::platform::PumpMessageLoop(
-        platform_, isolate, v8::platform::MessageLoopBehavior::kWaitForWork);
+    last_task_kind_.reset();
+    PumpNextTask(isolate);
 
     if (state_ == State::kRun) {
-      isolate->PerformMicrotaskCheckpoint();
+      RunMicrotasksAfterTask(isolate);
     }
   }
 
@@ -55,11 +106,47 @@ void IsolateManager::PumpMessages() {
   }
 }
 
+void IsolateManager::PumpNextTask(v8::Isolate* isolate) {
+  // If configured, poll for work for a little while before blocking. This
+  // avoids a futex sleep and wake (on both the producer side and ours) when
+  // tasks arrive back-to-back:
+  if (pump_spinner_.Spin([this, isolate]() {
+        return v8::platform::PumpMessageLoop(
+            platform_, isolate, v8::platform::MessageLoopBehavior::kDoNotWait);
+      })) {
+    return;
+  }
+
+  v8::platform::PumpMessageLoop(
+      platform_, isolate, v8::platform::MessageLoopBehavior::kWaitForWork);
+}
+
+void IsolateManager::RunMicrotasksAfterTask(v8::Isolate* isolate) {
+  switch (microtask_policy_) {
+    case MicrotaskPolicy::kPerTask:
+      isolate->PerformMicrotaskCheckpoint();
+      return;
+    case MicrotaskPolicy::kAfterJavaScript:
+      if (last_task_kind_ != TaskKind::kNoJavaScript) {
+        isolate->PerformMicrotaskCheckpoint();
+      }
+      return;
+    case MicrotaskPolicy::kScoped:
+      // Our own JavaScript tasks already ran microtasks on leaving their
+      // v8::MicrotasksScope. Tasks which V8 posted (e.g., FinalizationRegistry
+      // cleanup or WebAssembly compilation results) didn't, so we do it here:
+      if (!last_task_kind_.has_value()) {
+        v8::MicrotasksScope::PerformCheckpoint(isolate);
+      }
+      return;
+  }
+}
+
 void IsolateManager::ChangeState(State state) {
   state_ = state;
   // Run a no-op task to kick the message loop into noticing we've switched
   // states:
-  std::ignore = Run([](v8::Isolate*) {});
+  std::ignore = Run([](v8::Isolate*) {}, TaskKind::kNoJavaScript);
 }
 
 }  // end namespace MiniRacer
@@ -2,18 +2,54 @@
 #define INCLUDE_MINI_RACER_ISOLATE_MANAGER_H
 
 #include <v8-isolate.h>
+#include <v8-microtask-queue.h>
 #include <v8-platform.h>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <future>
 #include <memory>
+#include <optional>
 #include <thread>
 #include <type_traits>
 #include <utility>
+#include "adaptive_spinner.h"
 #include "isolate_holder.h"
 
 namespace MiniRacer {
 
+class IsolateManager;
+
+/** Says whether a task might run JavaScript (and thus enqueue microtasks). */
+enum class TaskKind : uint8_t {
+  kJavaScript = 0,
+  kNoJavaScript = 1,
+};
+
+/** Controls when the message pump runs microtasks (e.g., Promise reactions).
+ */
+enum class MicrotaskPolicy : uint8_t {
+  // Perform a microtask checkpoint after every task.
+  kPerTask = 0,
+  // Perform a microtask checkpoint after every task, except those which are
+  // known not to run JavaScript (like garbage collection of our own handles, or
+  // heap statistics).
+  kAfterJavaScript = 1,
+  // Run each JavaScript task within a v8::MicrotasksScope (with the isolate in
+  // v8::MicrotasksPolicy::kScoped), so that V8 itself runs microtasks as the
+  // task exits JavaScript. Tasks posted by V8 itself get a checkpoint too.
+  kScoped = 2,
+};
+
+/** Describes the task the message pump is running (see
+ * IsolateManager::GetRunningTask). */
+struct RunningTask {
+  // Increments with every task we start:
+  uint64_t seq;
+  std::chrono::steady_clock::time_point started;
+  TaskKind kind;
+};
+
 /** Wraps up a runnable to run on a v8::Isolate's foreground task runner thread
  * . */
 template <typename Runnable>
@@ -22,7 +58,10 @@ class IsolateTask : public v8::Task {
   using ReturnType = std::invoke_result_t<Runnable, v8::Isolate*>;
   using FutureType = std::future<ReturnType>;
 
-  explicit IsolateTask(Runnable runnable, v8::Isolate* isolate);
+  explicit IsolateTask(Runnable runnable,
+                       IsolateManager* isolate_manager,
+                       v8::Isolate* isolate,
+                       TaskKind kind);
 
   void Run() override;
 
@@ -30,7 +69,9 @@ class IsolateTask : public v8::Task {
 
  private:
   std::packaged_task<ReturnType(v8::Isolate*)> packaged_task_;
+  IsolateManager* isolate_manager_;
   v8::Isolate* isolate_;
+  TaskKind kind_;
 };
 
 /** Owns a v8::Isolate and mediates access to it via a task queue.
@@ -59,16 +100,60 @@ class IsolateManager {
    * v8::TaskRunner::PostTask. Returns a future which gets the result.
    * The caller should, of course, ensure that any references bound into the
    * runnable outlive the task, by awaiting the returned future before tearing
-   * down any referred-to objects. */
+   * down any referred-to objects.
+   * Tasks which never run JavaScript should say so using kind, so we can skip
+   * microtask checkpoints after them (see SetMicrotaskPolicy). */
   template <typename Runnable>
-  [[nodiscard]] auto Run(Runnable runnable)
+  [[nodiscard]] auto Run(Runnable runnable,
+                         TaskKind kind = TaskKind::kJavaScript)
       -> IsolateTask<Runnable>::FutureType;
 
+  /** Runs a task on the foreground thread, and waits for its result.
+   * Equivalent to Run(runnable, kind).get(), except that it may spin-wait for
+   * the result (see SetSpinWait). */
+  template <typename Runnable>
+  auto RunAndAwait(Runnable runnable, TaskKind kind = TaskKind::kJavaScript)
+      -> IsolateTask<Runnable>::ReturnType;
+
+  /** Configures how long the message pump and RunAndAwait callers spin,
+   * looking for work or results respectively, before blocking. This trades
+   * CPU for latency on frequent, small calls. Zero (the default) disables
+   * spinning. */
+  void SetSpinWait(std::chrono::nanoseconds spin_wait);
+
+  /** Configures when microtasks run. Defaults to MicrotaskPolicy::kPerTask.
+   */
+  void SetMicrotaskPolicy(MicrotaskPolicy policy);
+
   void TerminateOngoingTask();
 
   void StopJavaScript();
 
+  /** Asks V8 to call callback on the foreground thread, from within the
+   * currently running (or next) JavaScript, using
+   * v8::Isolate::RequestInterrupt. Unlike Run, this doesn't wait for the
+   * running task to finish. The callback must not run JavaScript. May be
+   * called from any thread. */
+  void RequestInterrupt(v8::InterruptCallback callback, void* data);
+
+  /** Turns on tracking of the task we're running, for GetRunningTask. This
+   * costs a clock read per task, so it's off by default. */
+  void EnableTaskTracking();
+
+  /** Returns the task we're running, or nullopt if we aren't running one (or
+   * task tracking is off, or we raced with the start of a new task). May be
+   * called from any thread. */
+  [[nodiscard]] auto GetRunningTask() const -> std::optional<RunningTask>;
+
+  /** Returns how many tasks we've started (counting only while task tracking
+   * is on). May be called from any thread. */
+  [[nodiscard]] auto GetTaskSeq() const -> uint64_t;
+
  private:
+  template <typename Runnable>
+  friend class IsolateTask;
+  friend class RunningTaskScope;
+
   enum State : std::uint8_t {
     kRun = 0,
     kNoJavaScript = 1,
@@ -76,21 +161,75 @@ class IsolateManager {
   };
 
   void PumpMessages();
+  void PumpNextTask(v8::Isolate* isolate);
+  void RunMicrotasksAfterTask(v8::Isolate* isolate);
   void ChangeState(State state);
 
   v8::Platform* platform_;
   std::atomic<State> state_;
+  AdaptiveSpinner pump_spinner_;
+  AdaptiveSpinner caller_spinner_;
+  // The following are only touched from the message pump thread.
+  MicrotaskPolicy microtask_policy_{MicrotaskPolicy::kPerTask};
+  // The kind of the last task we ran, or nullopt if it was not one of ours
+  // (i.e., V8 itself posted it):
+  std::optional<TaskKind> last_task_kind_;
+  // The following are written from the message pump thread, and read from any
+  // thread via GetRunningTask:
+  std::atomic<bool> track_tasks_{false};
+  std::atomic<uint64_t> running_task_seq_{0};
+  // In steady_clock ticks; zero when no task is running:
+  std::atomic<int64_t> running_task_started_{0};
+  std::atomic<TaskKind> running_task_kind_{TaskKind::kJavaScript};
   IsolateHolder isolate_holder_;
   std::thread thread_;
 };
 
+/** Records the start and end of a task, if task tracking is on. */
+class RunningTaskScope {
+ public:
+  RunningTaskScope(IsolateManager* isolate_manager, TaskKind kind);
+  ~RunningTaskScope();
+
+  RunningTaskScope(const RunningTaskScope&) = delete;
+  auto operator=(const RunningTaskScope&) -> RunningTaskScope& = delete;
+  RunningTaskScope(RunningTaskScope&&) = delete;
+  auto operator=(RunningTaskScope&&) -> RunningTaskScope& = delete;
+
+ private:
+  IsolateManager* isolate_manager_;
+};
+
+inline RunningTaskScope::RunningTaskScope(IsolateManager* isolate_manager,
+                                          TaskKind kind)
+    : isolate_manager_(
+          isolate_manager->track_tasks_.load(std::memory_order_relaxed)
+              ? isolate_manager
+              : nullptr) {
+  if (isolate_manager_ == nullptr) {
+    return;
+  }
+  isolate_manager_->running_task_kind_.store(kind, std::memory_order_relaxed);
+  isolate_manager_->running_task_started_.store(
+      std::chrono::steady_clock::now().time_since_epoch().count(),
+      std::memory_order_relaxed);
+  isolate_manager_->running_task_seq_.fetch_add(1, std::memory_order_release);
+}
+
+inline RunningTaskScope::~RunningTaskScope() {
+  if (isolate_manager_ == nullptr) {
+    return;
+  }
+  isolate_manager_->running_task_started_.store(0, std::memory_order_release);
+}
+
 /** Schedules a task to run on the foreground thread, using
  * v8::TaskRunner::PostTask. Awaits task completion. */
 template <typename Runnable>
-inline auto IsolateManager::Run(Runnable runnable)
+inline auto IsolateManager::Run(Runnable runnable, TaskKind kind)
     -> IsolateTask<Runnable>::FutureType {
-  auto task = std::make_unique<IsolateTask<Runnable>>(std::move(runnable),
-                                                      isolate_holder_.Get());
+  auto task = std::make_unique<IsolateTask<Runnable>>(
+      std::move(runnable), this, isolate_holder_.Get(), kind);
 
   auto fut = task->GetFuture();
 
@@ -100,13 +239,40 @@ inline auto IsolateManager::Run(Runnable runnable)
   return fut;
 }
 
+template <typename Runnable>
+inline auto IsolateManager::RunAndAwait(Runnable runnable, TaskKind kind)
+    -> IsolateTask<Runnable>::ReturnType {
+  auto fut = Run(std::move(runnable), kind);
+  caller_spinner_.Spin([&fut]() {
+    return fut.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  });
+  return fut.get();
+}
+
 template <typename Runnable>
 inline IsolateTask<Runnable>::IsolateTask(Runnable runnable,
-                                          v8::Isolate* isolate)
-    : packaged_task_(std::move(runnable)), isolate_(isolate) {}
+                                          IsolateManager* isolate_manager,
+                                          v8::Isolate* isolate,
+                                          TaskKind kind)
+    : packaged_task_(std::move(runnable)),
+      isolate_manager_(isolate_manager),
+      isolate_(isolate),
+      kind_(kind) {}
 
 template <typename Runnable>
 inline void IsolateTask<Runnable>::Run() {
+  isolate_manager_->last_task_kind_ = kind_;
+  const RunningTaskScope running_task(isolate_manager_, kind_);
+
+  if (kind_ == TaskKind::kJavaScript &&
+      isolate_manager_->microtask_policy_ == MicrotaskPolicy::kScoped) {
+    // V8 runs microtasks when we leave this scope:
+    const v8::MicrotasksScope microtasks_scope(
+        isolate_, nullptr, v8::MicrotasksScope::kRunMicrotasks);
+    packaged_task_(isolate_);
+    return;
+  }
+
   packaged_task_(isolate_);
 }
 
@@ -12,10 +12,12 @@ IsolateMemoryMonitor::IsolateMemoryMonitor(IsolateManager* isolate_manager)
     : isolate_manager_(isolate_manager),
       state_(std::make_shared<IsolateMemoryMonitorState>()) {
   isolate_manager_
-      ->Run([state = state_](v8::Isolate* isolate) {
-        isolate->AddGCEpilogueCallback(&IsolateMemoryMonitor::StaticGCCallback,
-                                       state.get());
-      })
+      ->Run(
+          [state = state_](v8::Isolate* isolate) {
+            isolate->AddGCEpilogueCallback(
+                &IsolateMemoryMonitor::StaticGCCallback, state.get());
+          },
+          TaskKind::kNoJavaScript)
       .get();
 }
 
@@ -36,16 +38,19 @@ auto IsolateMemoryMonitor::IsHardMemoryLimitReached() const -> bool {
 
 void IsolateMemoryMonitor::ApplyLowMemoryNotification() {
   isolate_manager_
-      ->Run([](v8::Isolate* isolate) { isolate->LowMemoryNotification(); })
+      ->Run([](v8::Isolate* isolate) { isolate->LowMemoryNotification(); },
+            TaskKind::kNoJavaScript)
       .get();
 }
 
 IsolateMemoryMonitor::~IsolateMemoryMonitor() {
   isolate_manager_
-      ->Run([state = state_](v8::Isolate* isolate) {
-        isolate->RemoveGCEpilogueCallback(
-            &IsolateMemoryMonitor::StaticGCCallback, state.get());
-      })
+      ->Run(
+          [state = state_](v8::Isolate* isolate) {
+            isolate->RemoveGCEpilogueCallback(
+                &IsolateMemoryMonitor::StaticGCCallback, state.get());
+          },
+          TaskKind::kNoJavaScript)
       .get();
 }
 
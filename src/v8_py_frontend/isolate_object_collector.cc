@@ -1,41 +1,88 @@
 #include "isolate_object_collector.h"
+#include <v8-array-buffer.h>
+#include <v8-function.h>
 #include <v8-isolate.h>
-#include <functional>
+#include <v8-persistent-handle.h>
+#include <v8-value.h>
+#include <cstddef>
+#include <memory>
 #include <mutex>
 #include <tuple>
 #include <utility>
-#include <vector>
+#include "gsl_stub.h"
 #include "isolate_manager.h"
 
 namespace MiniRacer {
 
 IsolateObjectCollector::IsolateObjectCollector(IsolateManager* isolate_manager)
-    : isolate_manager_(isolate_manager), is_collecting_(false) {}
+    : isolate_manager_(isolate_manager),
+      is_collecting_(false),
+      interrupt_requested_(false) {}
 
 IsolateObjectCollector::~IsolateObjectCollector() {
   std::unique_lock<std::mutex> lock(mutex_);
   collection_done_cv_.wait(lock, [this] { return !is_collecting_; });
 }
 
+void IsolateObjectCollector::Collect(
+    gsl::owner<v8::Persistent<v8::Value>*> obj) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  garbage_.values.push_back(obj);
+  AfterCollectLocked();
+}
+
+void IsolateObjectCollector::Collect(
+    gsl::owner<v8::Persistent<v8::Function>*> obj) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  garbage_.functions.push_back(obj);
+  AfterCollectLocked();
+}
+
+void IsolateObjectCollector::Collect(
+    gsl::owner<std::shared_ptr<v8::BackingStore>*> obj) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  garbage_.backing_stores.push_back(obj);
+  AfterCollectLocked();
+}
+
+auto IsolateObjectCollector::Backlog() -> size_t {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return garbage_.Size();
+}
+
+void IsolateObjectCollector::AfterCollectLocked() {
+  if (!is_collecting_) {
+    StartCollectingLocked();
+    return;
+  }
+
+  // There is already a collection task in flight. If the backlog has grown
+  // large, that task is probably stuck behind a long-running script:
+  if (!interrupt_requested_ && garbage_.Size() >= kInterruptThreshold) {
+    interrupt_requested_ = true;
+    isolate_manager_->RequestInterrupt(&IsolateObjectCollector::OnInterrupt,
+                                       this);
+  }
+}
+
 void IsolateObjectCollector::StartCollectingLocked() {
   is_collecting_ = true;
 
-  std::ignore = isolate_manager_->Run([this](v8::Isolate*) { DoCollection(); });
+  std::ignore = isolate_manager_->Run([this](v8::Isolate*) { DoCollection(); },
+                                      TaskKind::kNoJavaScript);
 }
 
 void IsolateObjectCollector::DoCollection() {
-  std::vector<std::function<void()>> batch;
+  Garbage batch;
   {
     const std::lock_guard<std::mutex> lock(mutex_);
     batch = std::exchange(garbage_, {});
   }
 
-  for (const auto& collector : batch) {
-    collector();
-  }
+  batch.Delete();
 
   const std::lock_guard<std::mutex> lock(mutex_);
-  if (garbage_.empty()) {
+  if (garbage_.Size() == 0) {
     is_collecting_ = false;
     collection_done_cv_.notify_all();
     return;
@@ -44,6 +91,41 @@ void IsolateObjectCollector::DoCollection() {
   StartCollectingLocked();
 }
 
+void IsolateObjectCollector::OnInterrupt(v8::Isolate* /*isolate*/,
+                                         void* data) {
+  // We're on the message pump thread, in the middle of running a script, and
+  // hold the isolate lock, so we can delete things here. We leave
+  // is_collecting_ alone; the collection task still in flight resets it.
+  auto* self = static_cast<IsolateObjectCollector*>(data);
+  Garbage batch;
+  {
+    const std::lock_guard<std::mutex> lock(self->mutex_);
+    self->interrupt_requested_ = false;
+    batch = std::exchange(self->garbage_, {});
+  }
+
+  batch.Delete();
+}
+
+auto IsolateObjectCollector::Garbage::Size() const -> size_t {
+  return values.size() + functions.size() + backing_stores.size();
+}
+
+void IsolateObjectCollector::Garbage::Delete() {
+  for (gsl::owner<v8::Persistent<v8::Value>*> obj : values) {
+    delete obj;
+  }
+  for (gsl::owner<v8::Persistent<v8::Function>*> obj : functions) {
+    delete obj;
+  }
+  for (gsl::owner<std::shared_ptr<v8::BackingStore>*> obj : backing_stores) {
+    delete obj;
+  }
+  values.clear();
+  functions.clear();
+  backing_stores.clear();
+}
+
 IsolateObjectDeleter::IsolateObjectDeleter()
     : isolate_object_collector_(nullptr) {}
 
@@ -1,8 +1,14 @@
 #ifndef INCLUDE_MINI_RACER_ISOLATE_OBJECT_COLLECTOR_H
 #define INCLUDE_MINI_RACER_ISOLATE_OBJECT_COLLECTOR_H
 
+#include <v8-array-buffer.h>
+#include <v8-function.h>
+#include <v8-isolate.h>
+#include <v8-persistent-handle.h>
+#include <v8-value.h>
 #include <condition_variable>
-#include <functional>
+#include <cstddef>
+#include <memory>
 #include <mutex>
 #include <vector>
 #include "gsl_stub.h"
@@ -21,7 +27,16 @@ namespace MiniRacer {
  * the Isolate lock is not safe, and there is no documentation indicating
  * methods like v8::Persistent::~Persistent are exempt from this rule. So this
  * class delegates deletion to the Isolate message loop.
- */
+ *
+ * Normally we collect from a task on the message loop. But that task can't run
+ * while a long-running script occupies the loop, and meanwhile garbage (e.g.,
+ * values freed by Python callbacks which the script calls) piles up. So once
+ * the backlog reaches kInterruptThreshold objects, we also ask V8 to interrupt
+ * the running script and collect from within the interrupt.
+ *
+ * V8 only services interrupts while running JavaScript, so the owner must stop
+ * JavaScript (see IsolateManager::StopJavaScript) before destroying this
+ * object, lest a pending interrupt fire after we're gone. */
 class IsolateObjectCollector {
  public:
   explicit IsolateObjectCollector(IsolateManager* isolate_manager);
@@ -34,18 +49,38 @@ class IsolateObjectCollector {
   auto operator=(IsolateObjectCollector&& other) -> IsolateObjectCollector& =
                                                         delete;
 
-  template <typename T>
-  void Collect(T* obj);
+  void Collect(gsl::owner<v8::Persistent<v8::Value>*> obj);
+  void Collect(gsl::owner<v8::Persistent<v8::Function>*> obj);
+  void Collect(gsl::owner<std::shared_ptr<v8::BackingStore>*> obj);
+
+  /** Returns how many objects are awaiting deletion. */
+  auto Backlog() -> size_t;
 
  private:
+  static constexpr size_t kInterruptThreshold = 1024;
+
+  /** Objects awaiting deletion, kept in one plain pointer list per type (so
+   * that queueing an object doesn't allocate a closure for it). */
+  struct Garbage {
+    std::vector<gsl::owner<v8::Persistent<v8::Value>*>> values;
+    std::vector<gsl::owner<v8::Persistent<v8::Function>*>> functions;
+    std::vector<gsl::owner<std::shared_ptr<v8::BackingStore>*>> backing_stores;
+
+    [[nodiscard]] auto Size() const -> size_t;
+    void Delete();
+  };
+
+  void AfterCollectLocked();
   void StartCollectingLocked();
   void DoCollection();
+  static void OnInterrupt(v8::Isolate* isolate, void* data);
 
   IsolateManager* isolate_manager_;
   std::mutex mutex_;
-  std::vector<std::function<void()>> garbage_;
+  Garbage garbage_;
   std::condition_variable collection_done_cv_;
   bool is_collecting_;
+  bool interrupt_requested_;
 };
 
 /** A deleter for use with std::shared_ptr and std::unique_ptr. */
@@ -62,20 +97,6 @@ class IsolateObjectDeleter {
   IsolateObjectCollector* isolate_object_collector_;
 };
 
-template <typename T>
-inline void IsolateObjectCollector::Collect(gsl::owner<T*> obj) {
-  const std::lock_guard<std::mutex> lock(mutex_);
-
-  garbage_.push_back([obj]() { delete obj; });
-
-  if (is_collecting_) {
-    // There is already a collection in progress.
-    return;
-  }
-
-  StartCollectingLocked();
-}
-
 template <typename T>
 void IsolateObjectDeleter::operator()(gsl::owner<T*> handle) const {
   isolate_object_collector_->Collect(handle);
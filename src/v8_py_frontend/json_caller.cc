@@ -0,0 +1,259 @@
+#include "json_caller.h"
+
+#include <v8-container.h>
+#include <v8-context.h>
+#include <v8-exception.h>
+#include <v8-function.h>
+#include <v8-isolate.h>
+#include <v8-json.h>
+#include <v8-local-handle.h>
+#include <v8-message.h>
+#include <v8-persistent-handle.h>
+#include <v8-primitive.h>
+#include <v8-script.h>
+#include <v8-value.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "binary_value.h"
+#include "context_holder.h"
+#include "isolate_memory_monitor.h"
+#include "isolate_object_collector.h"
+
+namespace MiniRacer {
+
+JSONCaller::JSONCaller(ContextHolder* context,
+                       BinaryValueFactory* bv_factory,
+                       IsolateMemoryMonitor* memory_monitor,
+                       IsolateObjectCollector* isolate_object_collector)
+    : context_(context),
+      bv_factory_(bv_factory),
+      memory_monitor_(memory_monitor),
+      isolate_object_collector_(isolate_object_collector) {}
+
+auto JSONCaller::Call(v8::Isolate* isolate,
+                      BinaryValue* expr_ptr,
+                      BinaryValue* args_json_ptr) -> BinaryValue::Ptr {
+  const v8::Isolate::Scope isolate_scope(isolate);
+  const v8::HandleScope handle_scope(isolate);
+  const v8::Local<v8::Context> context = context_->Get()->Get(isolate);
+  const v8::Context::Scope context_scope(context);
+
+  const v8::TryCatch trycatch(isolate);
+
+  const v8::Local<v8::Value> expr_val = expr_ptr->ToValue(context);
+  if (!expr_val->IsString()) {
+    return bv_factory_->New("expr is not a string", type_execute_exception);
+  }
+
+  const v8::Local<v8::Value> args_json_val = args_json_ptr->ToValue(context);
+  if (!args_json_val->IsString()) {
+    return bv_factory_->New("args is not a string", type_execute_exception);
+  }
+
+  v8::Local<v8::Function> func;
+  BinaryValue::Ptr err = GetFunction(isolate, context, trycatch,
+                                     expr_val.As<v8::String>(), &func);
+  if (err) {
+    return err;
+  }
+
+  v8::Local<v8::Value> args_val;
+  if (!v8::JSON::Parse(context, args_json_val.As<v8::String>())
+           .ToLocal(&args_val)) {
+    return MakeError(context, trycatch);
+  }
+
+  if (!args_val->IsArray()) {
+    return bv_factory_->New("args is not an array", type_execute_exception);
+  }
+
+  const v8::Local<v8::Array> args_array = args_val.As<v8::Array>();
+  std::vector<v8::Local<v8::Value>> argv;
+  argv.reserve(args_array->Length());
+  for (uint32_t i = 0; i < args_array->Length(); i++) {
+    argv.push_back(args_array->Get(context, i).ToLocalChecked());
+  }
+
+  // Like a sloppy-mode function would, we pass the global object as "this":
+  v8::Local<v8::Value> result;
+  if (!func->Call(context, context->Global(), static_cast<int>(argv.size()),
+                  argv.data())
+           .ToLocal(&result)) {
+    return MakeError(context, trycatch);
+  }
+
+  // JSON.stringify yields undefined (not a string) for these:
+  if (result->IsUndefined() || result->IsFunction() || result->IsSymbol()) {
+    return bv_factory_->New(context, v8::Undefined(isolate));
+  }
+
+  v8::Local<v8::String> result_json;
+  if (!v8::JSON::Stringify(context, result).ToLocal(&result_json)) {
+    return MakeError(context, trycatch);
+  }
+
+  return bv_factory_->New(context, result_json);
+}
+
+auto JSONCaller::Map(v8::Isolate* isolate,
+                     BinaryValue* expr_ptr,
+                     BinaryValue* records_json_ptr) -> BinaryValue::Ptr {
+  const v8::Isolate::Scope isolate_scope(isolate);
+  const v8::HandleScope handle_scope(isolate);
+  const v8::Local<v8::Context> context = context_->Get()->Get(isolate);
+  const v8::Context::Scope context_scope(context);
+
+  const v8::TryCatch trycatch(isolate);
+
+  const v8::Local<v8::Value> expr_val = expr_ptr->ToValue(context);
+  if (!expr_val->IsString()) {
+    return bv_factory_->New("expr is not a string", type_execute_exception);
+  }
+
+  const v8::Local<v8::Value> records_json_val =
+      records_json_ptr->ToValue(context);
+  if (!records_json_val->IsString()) {
+    return bv_factory_->New("records is not a string", type_execute_exception);
+  }
+
+  v8::Local<v8::Function> func;
+  BinaryValue::Ptr err = GetFunction(isolate, context, trycatch,
+                                     expr_val.As<v8::String>(), &func);
+  if (err) {
+    return err;
+  }
+
+  v8::Local<v8::Value> records_val;
+  if (!v8::JSON::Parse(context, records_json_val.As<v8::String>())
+           .ToLocal(&records_val)) {
+    return MakeError(context, trycatch);
+  }
+
+  if (!records_val->IsArray()) {
+    return bv_factory_->New("records is not an array",
+                            type_execute_exception);
+  }
+
+  // We map the records in place, so the parsed input array doubles as the
+  // output array:
+  const v8::Local<v8::Array> records = records_val.As<v8::Array>();
+  const uint32_t length = records->Length();
+  for (uint32_t i = 0; i < length; i++) {
+    v8::Local<v8::Value> record = records->Get(context, i).ToLocalChecked();
+    v8::Local<v8::Value> result;
+    if (!func->Call(context, context->Global(), 1, &record).ToLocal(&result)) {
+      return MakeError(context, trycatch);
+    }
+    if (records->Set(context, i, result).IsNothing()) {
+      return MakeError(context, trycatch);
+    }
+  }
+
+  // As with any array, JSON.stringify renders results which have no JSON
+  // representation (e.g., undefined) as null:
+  v8::Local<v8::String> results_json;
+  if (!v8::JSON::Stringify(context, records).ToLocal(&results_json)) {
+    return MakeError(context, trycatch);
+  }
+
+  return bv_factory_->New(context, results_json);
+}
+
+auto JSONCaller::GetFunction(v8::Isolate* isolate,
+                             v8::Local<v8::Context> context,
+                             const v8::TryCatch& trycatch,
+                             v8::Local<v8::String> expr,
+                             v8::Local<v8::Function>* func)
+    -> BinaryValue::Ptr {
+  v8::Local<v8::Function> resolver;
+  BinaryValue::Ptr err = GetResolver(isolate, context, expr, &resolver);
+  if (err) {
+    return err;
+  }
+
+  v8::Local<v8::Value> func_val;
+  if (!resolver->Call(context, v8::Undefined(isolate), 0, nullptr)
+           .ToLocal(&func_val)) {
+    return MakeError(context, trycatch);
+  }
+
+  if (!func_val->IsFunction()) {
+    return bv_factory_->New("function is not callable", type_execute_exception);
+  }
+
+  *func = func_val.As<v8::Function>();
+  return {};
+}
+
+auto JSONCaller::GetResolver(v8::Isolate* isolate,
+                             v8::Local<v8::Context> context,
+                             v8::Local<v8::String> expr,
+                             v8::Local<v8::Function>* resolver)
+    -> BinaryValue::Ptr {
+  const v8::String::Utf8Value expr_utf8(isolate, expr);
+  std::string key(*expr_utf8, expr_utf8.length());
+
+  auto iter = cache_.find(key);
+  if (iter != cache_.end()) {
+    lru_.splice(lru_.begin(), lru_, iter->second);
+    *resolver = iter->second->resolver->Get(isolate);
+    return {};
+  }
+
+  const v8::TryCatch trycatch(isolate);
+
+  // The newline keeps a trailing line comment in expr from swallowing our
+  // closing parentheses:
+  const v8::Local<v8::String> source = v8::String::Concat(
+      isolate,
+      v8::String::Concat(isolate,
+                         v8::String::NewFromUtf8Literal(isolate, "(() => ("),
+                         expr),
+      v8::String::NewFromUtf8Literal(isolate, "\n))"));
+
+  // Provide a name just for exception messages:
+  v8::ScriptOrigin script_origin(
+      v8::String::NewFromUtf8Literal(isolate, "<anonymous>"));
+
+  v8::Local<v8::Script> script;
+  if (!v8::Script::Compile(context, source, &script_origin).ToLocal(&script)) {
+    return bv_factory_->New(context, trycatch.Message(), trycatch.Exception(),
+                            type_parse_exception);
+  }
+
+  v8::Local<v8::Value> resolver_val;
+  if (!script->Run(context).ToLocal(&resolver_val)) {
+    return MakeError(context, trycatch);
+  }
+
+  *resolver = resolver_val.As<v8::Function>();
+
+  lru_.push_front(
+      {key, ResolverPtr(new v8::Persistent<v8::Function>(isolate, *resolver),
+                        IsolateObjectDeleter(isolate_object_collector_))});
+  cache_[std::move(key)] = lru_.begin();
+  if (lru_.size() > kMaxCachedResolvers) {
+    cache_.erase(lru_.back().expr);
+    lru_.pop_back();
+  }
+
+  return {};
+}
+
+auto JSONCaller::MakeError(v8::Local<v8::Context> context,
+                           const v8::TryCatch& trycatch) -> BinaryValue::Ptr {
+  if (memory_monitor_->IsHardMemoryLimitReached()) {
+    return bv_factory_->New("", type_oom_exception);
+  }
+
+  BinaryTypes result_type = type_execute_exception;
+  if (trycatch.HasTerminated()) {
+    result_type = type_terminated_exception;
+  }
+
+  return bv_factory_->New(context, trycatch.Message(), trycatch.Exception(),
+                          result_type);
+}
+
+}  // end namespace MiniRacer
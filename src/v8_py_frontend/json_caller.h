@@ -0,0 +1,90 @@
+#ifndef INCLUDE_MINI_RACER_JSON_CALLER_H
+#define INCLUDE_MINI_RACER_JSON_CALLER_H
+
+#include <v8-context.h>
+#include <v8-exception.h>
+#include <v8-function.h>
+#include <v8-isolate.h>
+#include <v8-local-handle.h>
+#include <v8-persistent-handle.h>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "binary_value.h"
+#include "context_holder.h"
+#include "isolate_memory_monitor.h"
+#include "isolate_object_collector.h"
+
+namespace MiniRacer {
+
+/** Calls a JavaScript function, named by an expression, with arguments given as
+ * JSON, and returns the result as JSON (the equivalent of
+ * `JSON.stringify(expr.apply(this, JSON.parse(args)))`).
+ *
+ * To spare V8 from parsing and compiling fresh source on every call, we compile
+ * each distinct expression once, into a "resolver" function `() => (expr)`,
+ * and keep recently used resolvers in a small cache. We call the resolver on
+ * every call (instead of caching the function it returns), so that
+ * reassignments of the function are still honored.
+ *
+ * Map applies such a function to every element of a JSON array of records,
+ * and returns the JSON array of results. This lets callers stream records
+ * through a function in batches, with one round trip per batch instead of one
+ * per record.
+ *
+ * All methods in this class assume that the caller holds the Isolate lock
+ * (i.e., is operating from the isolate message pump). */
+class JSONCaller {
+ public:
+  JSONCaller(ContextHolder* context,
+             BinaryValueFactory* bv_factory,
+             IsolateMemoryMonitor* memory_monitor,
+             IsolateObjectCollector* isolate_object_collector);
+
+  auto Call(v8::Isolate* isolate,
+            BinaryValue* expr_ptr,
+            BinaryValue* args_json_ptr) -> BinaryValue::Ptr;
+  auto Map(v8::Isolate* isolate,
+           BinaryValue* expr_ptr,
+           BinaryValue* records_json_ptr) -> BinaryValue::Ptr;
+
+ private:
+  using ResolverPtr =
+      std::unique_ptr<v8::Persistent<v8::Function>, IsolateObjectDeleter>;
+  struct CacheEntry {
+    std::string expr;
+    ResolverPtr resolver;
+  };
+
+  static constexpr size_t kMaxCachedResolvers = 256;
+
+  /** Resolves expr to a function. Returns an error value, or nullptr on
+   * success. */
+  auto GetFunction(v8::Isolate* isolate,
+                   v8::Local<v8::Context> context,
+                   const v8::TryCatch& trycatch,
+                   v8::Local<v8::String> expr,
+                   v8::Local<v8::Function>* func) -> BinaryValue::Ptr;
+  /** Finds or compiles the resolver for expr. Returns an error value, or
+   * nullptr on success. */
+  auto GetResolver(v8::Isolate* isolate,
+                   v8::Local<v8::Context> context,
+                   v8::Local<v8::String> expr,
+                   v8::Local<v8::Function>* resolver) -> BinaryValue::Ptr;
+  auto MakeError(v8::Local<v8::Context> context,
+                 const v8::TryCatch& trycatch) -> BinaryValue::Ptr;
+
+  ContextHolder* context_;
+  BinaryValueFactory* bv_factory_;
+  IsolateMemoryMonitor* memory_monitor_;
+  IsolateObjectCollector* isolate_object_collector_;
+  // Most recently used first:
+  std::list<CacheEntry> lru_;
+  std::unordered_map<std::string, std::list<CacheEntry>::iterator> cache_;
+};
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_JSON_CALLER_H
@@ -0,0 +1,47 @@
+#ifndef INCLUDE_MINI_RACER_JSON_UTIL_H
+#define INCLUDE_MINI_RACER_JSON_UTIL_H
+
+#include <array>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace MiniRacer {
+
+/** Appends str to out as a quoted JSON string, for code which builds JSON
+ * without access to the isolate (and thus v8::JSON). str should be UTF-8. */
+inline void AppendJSONString(std::string* out, std::string_view str) {
+  out->push_back('"');
+  for (const char chr : str) {
+    switch (chr) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      case '\r':
+        out->append("\\r");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(chr) < 0x20) {
+          std::array<char, 8> escaped{};
+          std::snprintf(escaped.data(), escaped.size(), "\\u%04x", chr);
+          out->append(escaped.data());
+        } else {
+          out->push_back(chr);
+        }
+    }
+  }
+  out->push_back('"');
+}
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_JSON_UTIL_H
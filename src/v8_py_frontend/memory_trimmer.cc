@@ -0,0 +1,117 @@
+#include "memory_trimmer.h"
+#include <v8-isolate.h>
+#include <v8-statistics.h>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include "isolate_manager.h"
+
+namespace MiniRacer {
+
+namespace {
+
+auto Footprint(v8::Isolate* isolate) -> uint64_t {
+  v8::HeapStatistics stats;
+  isolate->GetHeapStatistics(&stats);
+  return stats.total_physical_size() + stats.malloced_memory();
+}
+
+}  // end anonymous namespace
+
+MemoryTrimmer::MemoryTrimmer(IsolateManager* isolate_manager)
+    : isolate_manager_(isolate_manager) {}
+
+MemoryTrimmer::~MemoryTrimmer() {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+auto MemoryTrimmer::Trim() -> uint64_t {
+  const uint64_t reclaimed = isolate_manager_->RunAndAwait(
+      [](v8::Isolate* isolate) { return TrimIsolate(isolate); },
+      TaskKind::kNoJavaScript);
+
+  const std::lock_guard<std::mutex> lock(mutex_);
+  trims_++;
+  bytes_reclaimed_ += reclaimed;
+  return reclaimed;
+}
+
+void MemoryTrimmer::SetIdleThreshold(std::chrono::milliseconds threshold) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    threshold_ = threshold;
+    if (threshold_.count() > 0 && !thread_.joinable()) {
+      isolate_manager_->EnableTaskTracking();
+      thread_ = std::thread([this]() { Watch(); });
+    }
+  }
+  cv_.notify_all();
+}
+
+auto MemoryTrimmer::GetStatsJSON() -> std::string {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return "{\"trims\":" + std::to_string(trims_) +
+         ",\"idle_trims\":" + std::to_string(idle_trims_) +
+         ",\"bytes_reclaimed\":" + std::to_string(bytes_reclaimed_) + "}";
+}
+
+void MemoryTrimmer::Watch() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t last_seq = isolate_manager_->GetTaskSeq();
+  // The task count right after our last trim, so we trim only once per idle
+  // spell:
+  std::optional<uint64_t> trimmed_seq;
+  while (!stop_) {
+    if (threshold_.count() == 0) {
+      cv_.wait(lock);
+      continue;
+    }
+
+    cv_.wait_for(lock, threshold_, [this]() { return stop_; });
+    if (stop_ || threshold_.count() == 0) {
+      continue;
+    }
+
+    const uint64_t seq = isolate_manager_->GetTaskSeq();
+    const bool idle = seq == last_seq && seq != trimmed_seq &&
+                      !isolate_manager_->GetRunningTask().has_value();
+    last_seq = seq;
+    if (!idle) {
+      continue;
+    }
+
+    lock.unlock();
+    Trim();
+    lock.lock();
+
+    idle_trims_++;
+    // Our own trim counts as a task:
+    last_seq = isolate_manager_->GetTaskSeq();
+    trimmed_seq = last_seq;
+  }
+}
+
+auto MemoryTrimmer::TrimIsolate(v8::Isolate* isolate) -> uint64_t {
+  const uint64_t before = Footprint(isolate);
+
+  // This drops the compilation cache, and runs memory-reducing full GCs
+  // (which compact the heap and shrink new space) until they stop freeing
+  // anything. (A critical MemoryPressureNotification would run just one such
+  // GC, and leave V8 on its low-memory heuristics for whatever runs next.)
+  isolate->LowMemoryNotification();
+
+  const uint64_t after = Footprint(isolate);
+  return before > after ? before - after : 0;
+}
+
+}  // end namespace MiniRacer
@@ -0,0 +1,69 @@
+#ifndef INCLUDE_MINI_RACER_MEMORY_TRIMMER_H
+#define INCLUDE_MINI_RACER_MEMORY_TRIMMER_H
+
+#include <v8-isolate.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "isolate_manager.h"
+
+namespace MiniRacer {
+
+/** Shrinks the memory footprint of an isolate which isn't doing anything, on
+ * demand or (once an idle threshold is set) automatically.
+ *
+ * A trim runs memory-reducing full garbage collections, which compact the
+ * heap, shrink new space, drop the compilation cache, and return freed pages to
+ * the OS. Each full GC also ages the bytecode of functions which didn't run
+ * since the last one, and V8 flushes bytecode which gets old enough (along
+ * with the baseline and optimized code compiled from it). So repeated trims of
+ * a context which stays idle shed its cold code too.
+ *
+ * For idle trimming, a thread polls the IsolateManager's task count once per
+ * idle threshold, and trims the isolate when no task has started since the
+ * last poll, and none is running. We don't trim again until the isolate has
+ * run something else. */
+class MemoryTrimmer {
+ public:
+  explicit MemoryTrimmer(IsolateManager* isolate_manager);
+  ~MemoryTrimmer();
+
+  MemoryTrimmer(const MemoryTrimmer&) = delete;
+  auto operator=(const MemoryTrimmer&) -> MemoryTrimmer& = delete;
+  MemoryTrimmer(MemoryTrimmer&&) = delete;
+  auto operator=(MemoryTrimmer&& other) -> MemoryTrimmer& = delete;
+
+  /** Trims the isolate now (waiting for any running task to finish first),
+   * and returns how many bytes of heap and malloced memory that freed. */
+  auto Trim() -> uint64_t;
+
+  /** Sets how long the isolate must be idle before we trim it. Zero (the
+   * default) disables idle trimming. */
+  void SetIdleThreshold(std::chrono::milliseconds threshold);
+
+  /** Returns trim counters as a JSON object, with keys trims, idle_trims, and
+   * bytes_reclaimed. */
+  auto GetStatsJSON() -> std::string;
+
+ private:
+  void Watch();
+  static auto TrimIsolate(v8::Isolate* isolate) -> uint64_t;
+
+  IsolateManager* isolate_manager_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::chrono::milliseconds threshold_{0};
+  bool stop_{false};
+  uint64_t trims_{0};
+  uint64_t idle_trims_{0};
+  uint64_t bytes_reclaimed_{0};
+  // Started on the first SetIdleThreshold call:
+  std::thread thread_;
+};
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_MEMORY_TRIMMER_H
@@ -0,0 +1,579 @@
+// A standalone concurrency stress test for the MiniRacer C API.
+//
+// This hammers a pool of contexts from many threads with a random mix of
+// evaluations, cancelations, value allocation and (double-)frees, object
+// manipulation (by context ID and through pins), JS-to-C callbacks, heap
+// stats, and context teardown, all
+// through the exported C API (as the Python wrapper would use it). It checks
+// that results are sane, that every async task calls back exactly once unless
+// its context was torn down, and reports throughput per operation.
+//
+// It's meant to be run under ThreadSanitizer and AddressSanitizer builds (see
+// `helpers/v8_build.py --stress`), to validate changes to CancelableTask,
+// IsolateObjectCollector, BinaryValueRegistry, and scheduling in general.
+//
+// Usage:
+//   mini_racer_stress [--threads N] [--contexts N] [--seconds N] [--seed N]
+//                     [--icu PATH] [--snapshot PATH]
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "binary_value.h"
+#include "exports.h"
+
+namespace {
+
+using MiniRacer::BinaryValueHandle;
+
+// How long we wait for a task to call back before declaring a hang:
+constexpr std::chrono::seconds kCallbackTimeout(30);
+
+struct Options {
+  int threads = 16;
+  int contexts = 4;
+  int seconds = 30;
+  uint64_t seed = 0;
+  std::filesystem::path icu_path = "icudtl.dat";
+  std::filesystem::path snapshot_path = "snapshot_blob.bin";
+};
+
+/** Tracks callbacks we're waiting for, across all contexts. */
+class PendingCallbacks {
+ public:
+  struct Pending {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<BinaryValueHandle*> results;
+  };
+
+  auto Register() -> std::pair<uint64_t, std::shared_ptr<Pending>> {
+    auto pending = std::make_shared<Pending>();
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const uint64_t callback_id = next_id_++;
+    pending_[callback_id] = pending;
+    return {callback_id, pending};
+  }
+
+  void Unregister(uint64_t callback_id) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(callback_id);
+  }
+
+  void Deliver(uint64_t callback_id, BinaryValueHandle* val) {
+    std::shared_ptr<Pending> pending;
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      auto iter = pending_.find(callback_id);
+      if (iter == pending_.end()) {
+        unexpected_.fetch_add(1);
+        return;
+      }
+      pending = iter->second;
+    }
+    {
+      const std::lock_guard<std::mutex> lock(pending->mutex);
+      pending->results.push_back(val);
+    }
+    pending->cv.notify_all();
+  }
+
+  [[nodiscard]] auto Unexpected() const -> uint64_t {
+    return unexpected_.load();
+  }
+
+ private:
+  std::mutex mutex_;
+  uint64_t next_id_{1};
+  std::unordered_map<uint64_t, std::shared_ptr<Pending>> pending_;
+  std::atomic<uint64_t> unexpected_{0};
+};
+
+PendingCallbacks g_pending;
+
+void OnCallback(uint64_t callback_id, BinaryValueHandle* val) {
+  g_pending.Deliver(callback_id, val);
+}
+
+/** A slot holding one context, which threads may tear down and replace. */
+class ContextSlot {
+ public:
+  ContextSlot() : context_id_(mr_init_context(&OnCallback)) {}
+
+  ~ContextSlot() { mr_free_context(context_id_); }
+
+  ContextSlot(const ContextSlot&) = delete;
+  auto operator=(const ContextSlot&) -> ContextSlot& = delete;
+  ContextSlot(ContextSlot&&) = delete;
+  auto operator=(ContextSlot&& other) -> ContextSlot& = delete;
+
+  /** Returns the current context ID and generation. Other threads may free the
+   * context at any time; API calls on freed IDs must fail gracefully. */
+  auto Get() -> std::pair<uint64_t, uint64_t> {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return {context_id_, generation_};
+  }
+
+  [[nodiscard]] auto Generation() -> uint64_t {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return generation_;
+  }
+
+  void Replace() {
+    const uint64_t new_id = mr_init_context(&OnCallback);
+    uint64_t old_id = 0;
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      old_id = std::exchange(context_id_, new_id);
+      generation_++;
+    }
+    mr_free_context(old_id);
+  }
+
+ private:
+  std::mutex mutex_;
+  uint64_t context_id_;
+  uint64_t generation_{0};
+};
+
+enum Op : uint8_t {
+  kEval,
+  kEvalCancel,
+  kAllocFree,
+  kObjectOps,
+  kPinnedOps,
+  kJSCallback,
+  kHeapStats,
+  kTeardown,
+  kNumOps,
+};
+
+constexpr std::array<std::string_view, kNumOps> kOpNames = {
+    "eval",     "eval+cancel", "alloc+free", "object ops",
+    "pinned",   "callback",    "heap stats", "teardown",
+};
+
+// Relative frequency of each operation:
+constexpr std::array<int, kNumOps> kOpWeights = {30, 15, 20, 20, 15, 10, 3, 1};
+
+struct Counters {
+  std::array<std::atomic<uint64_t>, kNumOps> completed{};
+  std::atomic<uint64_t> abandoned{0};
+  std::atomic<uint64_t> failures{0};
+};
+
+Counters g_counters;
+
+void Fail(std::string_view what) {
+  g_counters.failures.fetch_add(1);
+  std::fprintf(stderr, "FAILURE: %.*s\n", static_cast<int>(what.size()),
+               what.data());
+}
+
+/** Waits for one callback. Returns nullptr if the context was torn down
+ * before the callback arrived, and reports a failure on a genuine hang. */
+auto Await(ContextSlot* slot,
+           uint64_t generation,
+           uint64_t callback_id,
+           const std::shared_ptr<PendingCallbacks::Pending>& pending)
+    -> BinaryValueHandle* {
+  std::unique_lock<std::mutex> lock(pending->mutex);
+  const bool arrived = pending->cv.wait_for(
+      lock, kCallbackTimeout, [&pending] { return !pending->results.empty(); });
+  if (!arrived) {
+    lock.unlock();
+    if (slot->Generation() != generation) {
+      g_counters.abandoned.fetch_add(1);
+    } else {
+      Fail("task never called back (hang?)");
+    }
+    g_pending.Unregister(callback_id);
+    return nullptr;
+  }
+  BinaryValueHandle* val = pending->results.front();
+  pending->results.erase(pending->results.begin());
+  return val;
+}
+
+auto IsException(const BinaryValueHandle* val) -> bool {
+  return val == nullptr || val->type >= MiniRacer::type_execute_exception;
+}
+
+auto AllocString(uint64_t context_id, std::string_view str)
+    -> BinaryValueHandle* {
+  std::string copy(str);
+  return mr_alloc_string_val(context_id, copy.data(), copy.size(),
+                             MiniRacer::type_str_utf8);
+}
+
+/** Evaluates code synchronously (from the caller's perspective). */
+auto Eval(ContextSlot* slot,
+          uint64_t context_id,
+          uint64_t generation,
+          std::string_view code,
+          int cancel_after_us = -1) -> BinaryValueHandle* {
+  BinaryValueHandle* code_handle = AllocString(context_id, code);
+  auto [callback_id, pending] = g_pending.Register();
+  const uint64_t task_id = mr_eval(context_id, code_handle, callback_id);
+  if (task_id == 0) {
+    // The context is already gone.
+    g_pending.Unregister(callback_id);
+    g_counters.abandoned.fetch_add(1);
+    return nullptr;
+  }
+  if (cancel_after_us >= 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(cancel_after_us));
+    mr_cancel_task(context_id, task_id);
+    // Canceling twice must be harmless:
+    mr_cancel_task(context_id, task_id);
+  }
+  BinaryValueHandle* result = Await(slot, generation, callback_id, pending);
+  g_pending.Unregister(callback_id);
+  mr_free_value(context_id, code_handle);
+  return result;
+}
+
+void DoEval(ContextSlot* slot, std::mt19937_64& rng) {
+  auto [context_id, generation] = slot->Get();
+  const int64_t addend = static_cast<int64_t>(rng() % 1000);
+  BinaryValueHandle* result =
+      Eval(slot, context_id, generation, "1 + " + std::to_string(addend));
+  if (result == nullptr) {
+    return;
+  }
+  if (result->type == MiniRacer::type_integer) {
+    if (result->int_val != 1 + addend) {
+      Fail("wrong eval result");
+    }
+  } else if (!IsException(result)) {
+    Fail("unexpected eval result type");
+  }
+  mr_free_value(context_id, result);
+}
+
+void DoEvalCancel(ContextSlot* slot, std::mt19937_64& rng) {
+  auto [context_id, generation] = slot->Get();
+  const int cancel_after_us = static_cast<int>(rng() % 2000);
+  BinaryValueHandle* result = Eval(
+      slot, context_id, generation,
+      "let x = 0; for (let i = 0; i < 1e7; i++) { x += i; } x", cancel_after_us);
+  if (result == nullptr) {
+    return;
+  }
+  if (result->type != MiniRacer::type_terminated_exception &&
+      result->type != MiniRacer::type_double &&
+      result->type != MiniRacer::type_integer) {
+    Fail("unexpected eval+cancel result type");
+  }
+  mr_free_value(context_id, result);
+}
+
+void DoAllocFree(ContextSlot* slot, std::mt19937_64& rng) {
+  const uint64_t context_id = slot->Get().first;
+  std::vector<BinaryValueHandle*> handles;
+  const size_t count = 1 + (rng() % 32);
+  for (size_t i = 0; i < count; i++) {
+    switch (rng() % 3) {
+      case 0:
+        handles.push_back(mr_alloc_int_val(
+            context_id, static_cast<int64_t>(rng()), MiniRacer::type_integer));
+        break;
+      case 1:
+        handles.push_back(mr_alloc_double_val(context_id, 0.5,
+                                              MiniRacer::type_double));
+        break;
+      default:
+        handles.push_back(
+            AllocString(context_id, std::string(rng() % 256, 'x')));
+        break;
+    }
+  }
+  for (auto* handle : handles) {
+    mr_free_value(context_id, handle);
+  }
+
+  // Double frees and use-after-free must be handled gracefully. We try them
+  // in this thread's own context: in a shared one, another thread may have
+  // been handed the freed address for a new value in the meantime, and we'd
+  // free (or read) that instead.
+  if (rng() % 4 == 0) {
+    thread_local ContextSlot own_slot;
+    const uint64_t own_id = own_slot.Get().first;
+    BinaryValueHandle* handle =
+        mr_alloc_int_val(own_id, 1, MiniRacer::type_integer);
+    mr_free_value(own_id, handle);
+    mr_free_value(own_id, handle);
+    BinaryValueHandle* names = mr_get_own_property_names(own_id, handle);
+    if (!IsException(names)) {
+      Fail("use after free not rejected");
+    }
+    mr_free_value(own_id, names);
+  }
+}
+
+void DoObjectOps(ContextSlot* slot, std::mt19937_64& rng) {
+  auto [context_id, generation] = slot->Get();
+  BinaryValueHandle* obj = Eval(slot, context_id, generation, "({a: 1})");
+  if (obj == nullptr) {
+    return;
+  }
+  BinaryValueHandle* key = AllocString(context_id, "b");
+  BinaryValueHandle* val = mr_alloc_int_val(
+      context_id, static_cast<int64_t>(rng() % 100), MiniRacer::type_integer);
+  for (auto* result : {
+           mr_set_object_item(context_id, obj, key, val),
+           mr_get_object_item(context_id, obj, key),
+           mr_get_own_property_names(context_id, obj),
+           mr_get_identity_hash(context_id, obj),
+           mr_del_object_item(context_id, obj, key),
+       }) {
+    mr_free_value(context_id, result);
+  }
+  mr_free_value(context_id, val);
+  mr_free_value(context_id, key);
+  mr_free_value(context_id, obj);
+}
+
+void DoPinnedOps(ContextSlot* slot, std::mt19937_64& rng) {
+  auto [context_id, generation] = slot->Get();
+  MiniRacer::ContextPin* pin = mr_context_pin(context_id);
+  if (pin == nullptr) {
+    g_counters.abandoned.fetch_add(1);
+    return;
+  }
+
+  // The pin keeps the context alive even if another thread tears it down
+  // meanwhile, so everything here must succeed.
+  std::string code = "({a: 1})";
+  BinaryValueHandle* code_handle = mr_pinned_alloc_string_val(
+      pin, code.data(), code.size(), MiniRacer::type_str_utf8);
+  auto [callback_id, pending] = g_pending.Register();
+  if (mr_pinned_eval(pin, code_handle, callback_id) == 0) {
+    Fail("pinned eval failed to start");
+  }
+  BinaryValueHandle* obj = Await(slot, generation, callback_id, pending);
+  g_pending.Unregister(callback_id);
+  mr_pinned_free_value(pin, code_handle);
+  if (IsException(obj)) {
+    Fail("pinned eval failed");
+    mr_context_unpin(pin);
+    return;
+  }
+
+  std::string key_str = "b";
+  BinaryValueHandle* key = mr_pinned_alloc_string_val(
+      pin, key_str.data(), key_str.size(), MiniRacer::type_str_utf8);
+  const auto num = static_cast<int64_t>(rng() % 100);
+  BinaryValueHandle* val =
+      mr_pinned_alloc_int_val(pin, num, MiniRacer::type_integer);
+  mr_pinned_free_value(pin, mr_pinned_set_object_item(pin, obj, key, val));
+  BinaryValueHandle* got = mr_pinned_get_object_item(pin, obj, key);
+  if (got == nullptr || got->type != MiniRacer::type_integer ||
+      got->int_val != num) {
+    Fail("wrong pinned get result");
+  }
+  mr_pinned_free_value(pin, got);
+  mr_pinned_free_value(pin, mr_pinned_del_object_item(pin, obj, key));
+  mr_pinned_free_value(pin, val);
+  mr_pinned_free_value(pin, key);
+  mr_pinned_free_value(pin, obj);
+  mr_context_unpin(pin);
+}
+
+void DoJSCallback(ContextSlot* slot, std::mt19937_64& /*rng*/) {
+  auto [context_id, generation] = slot->Get();
+
+  auto [js_callback_id, js_pending] = g_pending.Register();
+  BinaryValueHandle* func =
+      Eval(slot, context_id, generation, "(f) => { f(7); return 8; }");
+  BinaryValueHandle* argv = Eval(slot, context_id, generation, "[]");
+  BinaryValueHandle* js_callback =
+      mr_make_js_callback(context_id, js_callback_id);
+  BinaryValueHandle* index = mr_alloc_int_val(context_id, 0,
+                                              MiniRacer::type_integer);
+  BinaryValueHandle* this_val =
+      mr_alloc_int_val(context_id, 0, MiniRacer::type_undefined);
+  mr_free_value(context_id,
+                mr_set_object_item(context_id, argv, index, js_callback));
+
+  auto [callback_id, pending] = g_pending.Register();
+  const uint64_t task_id =
+      mr_call_function(context_id, func, this_val, argv, callback_id);
+  if (task_id != 0) {
+    BinaryValueHandle* result = Await(slot, generation, callback_id, pending);
+    if (result != nullptr) {
+      if (!IsException(result)) {
+        if (result->type != MiniRacer::type_integer || result->int_val != 8) {
+          Fail("wrong call result");
+        }
+        // The JS callback must have been called exactly once, before the
+        // function returned:
+        const std::lock_guard<std::mutex> lock(js_pending->mutex);
+        if (js_pending->results.size() != 1) {
+          Fail("JS callback not called exactly once");
+        }
+      }
+      mr_free_value(context_id, result);
+    }
+  }
+  g_pending.Unregister(callback_id);
+  g_pending.Unregister(js_callback_id);
+  {
+    const std::lock_guard<std::mutex> lock(js_pending->mutex);
+    for (auto* args : js_pending->results) {
+      mr_free_value(context_id, args);
+    }
+  }
+  for (auto* handle : {func, argv, js_callback, index, this_val}) {
+    mr_free_value(context_id, handle);
+  }
+}
+
+void DoHeapStats(ContextSlot* slot, std::mt19937_64& /*rng*/) {
+  auto [context_id, generation] = slot->Get();
+  auto [callback_id, pending] = g_pending.Register();
+  if (mr_heap_stats(context_id, callback_id) == 0) {
+    g_pending.Unregister(callback_id);
+    return;
+  }
+  BinaryValueHandle* result = Await(slot, generation, callback_id, pending);
+  g_pending.Unregister(callback_id);
+  if (result != nullptr) {
+    if (result->type != MiniRacer::type_str_utf8 && !IsException(result)) {
+      Fail("unexpected heap stats result type");
+    }
+    mr_free_value(context_id, result);
+  }
+}
+
+void DoTeardown(ContextSlot* slot, std::mt19937_64& /*rng*/) {
+  slot->Replace();
+}
+
+using OpFunc = void (*)(ContextSlot*, std::mt19937_64&);
+constexpr std::array<OpFunc, kNumOps> kOpFuncs = {
+    DoEval,      DoEvalCancel, DoAllocFree, DoObjectOps,
+    DoPinnedOps, DoJSCallback, DoHeapStats, DoTeardown,
+};
+
+void Worker(std::vector<std::unique_ptr<ContextSlot>>* slots,
+            uint64_t seed,
+            const std::atomic<bool>* stop) {
+  std::mt19937_64 rng(seed);
+  std::discrete_distribution<int> op_dist(kOpWeights.begin(),
+                                          kOpWeights.end());
+  while (!stop->load()) {
+    ContextSlot* slot = (*slots)[rng() % slots->size()].get();
+    const int op = op_dist(rng);
+    kOpFuncs.at(op)(slot, rng);
+    g_counters.completed.at(op).fetch_add(1);
+  }
+}
+
+auto ParseOptions(int argc, char** argv) -> Options {
+  Options options;
+  options.icu_path =
+      std::filesystem::path(argv[0]).parent_path() / "icudtl.dat";
+  options.snapshot_path =
+      std::filesystem::path(argv[0]).parent_path() / "snapshot_blob.bin";
+  options.seed = std::random_device()();
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string_view flag = argv[i];
+    const char* val = argv[i + 1];
+    if (flag == "--threads") {
+      options.threads = std::atoi(val);
+    } else if (flag == "--contexts") {
+      options.contexts = std::atoi(val);
+    } else if (flag == "--seconds") {
+      options.seconds = std::atoi(val);
+    } else if (flag == "--seed") {
+      options.seed = std::strtoull(val, nullptr, 10);
+    } else if (flag == "--icu") {
+      options.icu_path = val;
+    } else if (flag == "--snapshot") {
+      options.snapshot_path = val;
+    } else {
+      std::fprintf(stderr, "Unknown flag %s\n", argv[i]);
+      std::exit(2);
+    }
+  }
+  return options;
+}
+
+}  // end anonymous namespace
+
+auto main(int argc, char** argv) -> int {
+  const Options options = ParseOptions(argc, argv);
+
+  mr_init_v8("--single-threaded", options.icu_path.string().c_str(),
+             options.snapshot_path.string().c_str());
+
+  std::printf("mini_racer_stress: %d threads, %d contexts, %ds, seed %llu\n",
+              options.threads, options.contexts, options.seconds,
+              static_cast<unsigned long long>(options.seed));
+
+  std::vector<std::unique_ptr<ContextSlot>> slots;
+  slots.reserve(options.contexts);
+  for (int i = 0; i < options.contexts; i++) {
+    slots.push_back(std::make_unique<ContextSlot>());
+  }
+
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  threads.reserve(options.threads);
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < options.threads; i++) {
+    threads.emplace_back(Worker, &slots, options.seed + i, &stop);
+  }
+
+  std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+  stop.store(true);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const double elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+  slots.clear();
+
+  uint64_t total = 0;
+  for (int op = 0; op < kNumOps; op++) {
+    const uint64_t count = g_counters.completed.at(op).load();
+    total += count;
+    std::printf("%-14.*s %10llu ops %12.1f ops/s\n",
+                static_cast<int>(kOpNames.at(op).size()),
+                kOpNames.at(op).data(), static_cast<unsigned long long>(count),
+                static_cast<double>(count) / elapsed);
+  }
+  std::printf("%-14s %10llu ops %12.1f ops/s\n", "total",
+              static_cast<unsigned long long>(total),
+              static_cast<double>(total) / elapsed);
+  std::printf("abandoned by teardown: %llu, unexpected callbacks: %llu\n",
+              static_cast<unsigned long long>(g_counters.abandoned.load()),
+              static_cast<unsigned long long>(g_pending.Unexpected()));
+
+  if (mr_context_count() != 0) {
+    Fail("contexts leaked");
+  }
+
+  const uint64_t failures = g_counters.failures.load();
+  std::printf("%s: %llu failures\n", failures == 0 ? "PASS" : "FAIL",
+              static_cast<unsigned long long>(failures));
+  return failures == 0 ? 0 : 1;
+}
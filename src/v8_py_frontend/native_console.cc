@@ -0,0 +1,349 @@
+#include "native_console.h"
+#include <v8-container.h>
+#include <v8-context.h>
+#include <v8-exception.h>
+#include <v8-function-callback.h>
+#include <v8-function.h>
+#include <v8-json.h>
+#include <v8-local-handle.h>
+#include <v8-maybe.h>
+#include <v8-object.h>
+#include <v8-primitive.h>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "context_holder.h"
+#include "id_maker.h"
+#include "json_util.h"
+
+namespace MiniRacer {
+
+namespace {
+
+struct ConsoleMethod {
+  const char* name;
+  ConsoleLevel level;
+};
+
+constexpr std::array<ConsoleMethod, 5> kConsoleMethods = {{
+    {"log", ConsoleLevel::kLog},
+    {"info", ConsoleLevel::kInfo},
+    {"warn", ConsoleLevel::kWarn},
+    {"error", ConsoleLevel::kError},
+    {"debug", ConsoleLevel::kDebug},
+}};
+
+auto LevelName(ConsoleLevel level) -> const char* {
+  for (const ConsoleMethod& method : kConsoleMethods) {
+    if (method.level == level) {
+      return method.name;
+    }
+  }
+  return "log";
+}
+
+auto ToUtf8(v8::Isolate* isolate, v8::Local<v8::String> str) -> std::string {
+  const v8::String::Utf8Value utf8(isolate, str);
+  if (*utf8 == nullptr) {
+    return {};
+  }
+  return {*utf8, static_cast<size_t>(utf8.length())};
+}
+
+/** Renders a console.log argument, roughly as browsers do. Returns Nothing if
+ * that throws (or terminates), leaving the exception pending. */
+auto FormatValue(v8::Isolate* isolate,
+                 v8::Local<v8::Context> context,
+                 v8::Local<v8::Value> value) -> v8::Maybe<std::string> {
+  if (value->IsString()) {
+    return v8::Just(ToUtf8(isolate, value.As<v8::String>()));
+  }
+
+  if (value->IsNativeError()) {
+    // The stack includes the message:
+    v8::Local<v8::Value> stack;
+    if (!value.As<v8::Object>()
+             ->Get(context, v8::String::NewFromUtf8Literal(isolate, "stack"))
+             .ToLocal(&stack)) {
+      return v8::Nothing<std::string>();
+    }
+    if (stack->IsString()) {
+      return v8::Just(ToUtf8(isolate, stack.As<v8::String>()));
+    }
+  }
+
+  if (value->IsObject() && !value->IsFunction()) {
+    // Stringify fails on, e.g., cyclic objects, or a toJSON which throws, in
+    // which case we fall back to the detail string below. Termination isn't a
+    // failure we can fall back from, so we pass it on.
+    v8::TryCatch trycatch(isolate);
+    v8::Local<v8::String> json;
+    if (v8::JSON::Stringify(context, value).ToLocal(&json)) {
+      return v8::Just(ToUtf8(isolate, json));
+    }
+    if (trycatch.HasTerminated()) {
+      trycatch.ReThrow();
+      return v8::Nothing<std::string>();
+    }
+  }
+
+  v8::Local<v8::String> str;
+  if (!value->ToDetailString(context).ToLocal(&str)) {
+    return v8::Nothing<std::string>();
+  }
+  return v8::Just(ToUtf8(isolate, str));
+}
+
+/** Joins console.log arguments with spaces, after substituting any printf-like
+ * format specifiers (%s, %d, %i, %f, %o, %O, %j, and %c) in the first.
+ * Returns Nothing as soon as converting any argument throws. */
+auto FormatArgs(const v8::FunctionCallbackInfo<v8::Value>& info,
+                v8::Local<v8::Context> context) -> v8::Maybe<std::string> {
+  v8::Isolate* isolate = info.GetIsolate();
+  std::string out;
+  int next = 0;
+
+  if (info.Length() > 0 && info[0]->IsString()) {
+    const std::string format = ToUtf8(isolate, info[0].As<v8::String>());
+    next = 1;
+    for (size_t i = 0; i < format.size(); i++) {
+      if (format[i] != '%' || i + 1 == format.size()) {
+        out.push_back(format[i]);
+        continue;
+      }
+      const char spec = format[i + 1];
+      if (spec == '%') {
+        out.push_back('%');
+        i++;
+        continue;
+      }
+      if (next >= info.Length() ||
+          std::string_view("sdifoOjc").find(spec) == std::string_view::npos) {
+        out.push_back('%');
+        continue;
+      }
+      i++;
+      v8::Local<v8::Value> arg = info[next++];
+      if (spec == 'c') {
+        // CSS styling, which we ignore.
+        continue;
+      }
+      if (spec == 'd' || spec == 'i' || spec == 'f') {
+        double num = 0;
+        if (!arg->NumberValue(context).To(&num)) {
+          return v8::Nothing<std::string>();
+        }
+        if (spec != 'f') {
+          num = std::trunc(num);
+        }
+        arg = v8::Number::New(isolate, num);
+      }
+      std::string formatted;
+      if (!FormatValue(isolate, context, arg).To(&formatted)) {
+        return v8::Nothing<std::string>();
+      }
+      out.append(formatted);
+    }
+  }
+
+  for (; next < info.Length(); next++) {
+    if (next > 0) {
+      out.push_back(' ');
+    }
+    std::string formatted;
+    if (!FormatValue(isolate, context, info[next]).To(&formatted)) {
+      return v8::Nothing<std::string>();
+    }
+    out.append(formatted);
+  }
+
+  if (out.size() > NativeConsole::kMaxLineBytes) {
+    size_t len = NativeConsole::kMaxLineBytes;
+    // Don't split a UTF-8 sequence:
+    while (len > 0 && (static_cast<unsigned char>(out[len]) & 0xC0) == 0x80) {
+      len--;
+    }
+    out.resize(len);
+  }
+  return v8::Just(out);
+}
+
+}  // end anonymous namespace
+
+void ConsoleBuffer::SetCapacity(size_t capacity) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  capacity_ = capacity;
+  while (lines_.size() > capacity_) {
+    lines_.pop_front();
+    dropped_++;
+  }
+}
+
+void ConsoleBuffer::Append(ConsoleLevel level, std::string text) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  if (capacity_ == 0) {
+    return;
+  }
+  if (lines_.size() == capacity_) {
+    lines_.pop_front();
+    dropped_++;
+  }
+  lines_.push_back({level, std::move(text)});
+}
+
+auto ConsoleBuffer::Drain() -> std::string {
+  std::deque<Line> lines;
+  uint64_t dropped = 0;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    lines = std::exchange(lines_, {});
+    dropped = std::exchange(dropped_, 0);
+  }
+
+  std::string out = "{\"dropped\":";
+  out.append(std::to_string(dropped));
+  out.append(",\"lines\":[");
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (i != 0) {
+      out.push_back(',');
+    }
+    out.push_back('[');
+    AppendJSONString(&out, LevelName(lines[i].level));
+    out.push_back(',');
+    AppendJSONString(&out, lines[i].text);
+    out.push_back(']');
+  }
+  out.append("]}");
+  return out;
+}
+
+std::shared_ptr<IdMaker<ConsoleBuffer>> NativeConsole::buffers_;
+std::once_flag NativeConsole::buffers_init_flag_;
+
+auto NativeConsole::GetBuffers() -> std::shared_ptr<IdMaker<ConsoleBuffer>> {
+  std::call_once(buffers_init_flag_, []() {
+    buffers_ = std::make_shared<IdMaker<ConsoleBuffer>>();
+  });
+  return buffers_;
+}
+
+NativeConsole::NativeConsole(ContextHolder* context_holder)
+    : context_holder_(context_holder),
+      buffer_(std::make_shared<ConsoleBuffer>()),
+      buffer_holder_(buffer_, GetBuffers()) {}
+
+void NativeConsole::Install(v8::Isolate* isolate, size_t capacity) {
+  buffer_->SetCapacity(capacity);
+
+  const v8::Isolate::Scope isolate_scope(isolate);
+  const v8::HandleScope handle_scope(isolate);
+  const v8::Local<v8::Context> context = context_holder_->Get()->Get(isolate);
+  const v8::Context::Scope context_scope(context);
+  const v8::TryCatch trycatch(isolate);
+
+  const v8::Local<v8::String> console_name =
+      v8::String::NewFromUtf8Literal(isolate, "console");
+  v8::Local<v8::Value> console_value;
+  if (!context->Global()->Get(context, console_name).ToLocal(&console_value)) {
+    return;
+  }
+  v8::Local<v8::Object> console;
+  if (console_value->IsObject()) {
+    console = console_value.As<v8::Object>();
+  } else {
+    console = v8::Object::New(isolate);
+    if (context->Global()->Set(context, console_name, console).IsNothing()) {
+      return;
+    }
+  }
+
+  // As in JSCallbackMaker, we give each function {a BigInt indicating the
+  // buffer ID, the level}, rather than a pointer:
+  for (const ConsoleMethod& method : kConsoleMethods) {
+    std::array<v8::Local<v8::Value>, 2> data_elements = {
+        v8::BigInt::NewFromUnsigned(isolate, buffer_holder_.GetId()),
+        v8::Integer::NewFromUnsigned(isolate,
+                                     static_cast<uint32_t>(method.level))};
+    const v8::Local<v8::Array> data =
+        v8::Array::New(isolate, data_elements.data(), data_elements.size());
+
+    v8::Local<v8::Function> func;
+    if (!v8::Function::New(context, &NativeConsole::OnCalledStatic, data)
+             .ToLocal(&func)) {
+      return;
+    }
+    if (console
+            ->Set(context,
+                  v8::String::NewFromUtf8(isolate, method.name)
+                      .ToLocalChecked(),
+                  func)
+            .IsNothing()) {
+      return;
+    }
+  }
+}
+
+auto NativeConsole::Drain() -> std::string {
+  return buffer_->Drain();
+}
+
+void NativeConsole::OnCalledStatic(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  const v8::Context::Scope context_scope(context);
+
+  const v8::Local<v8::Value> data_value = info.Data();
+  if (!data_value->IsArray()) {
+    return;
+  }
+  const v8::Local<v8::Array> data_array = data_value.As<v8::Array>();
+  if (data_array->Length() != 2) {
+    return;
+  }
+
+  v8::Local<v8::Value> buffer_id_value;
+  if (!data_array->Get(context, 0).ToLocal(&buffer_id_value) ||
+      !buffer_id_value->IsBigInt()) {
+    return;
+  }
+  bool lossless = false;
+  const uint64_t buffer_id =
+      buffer_id_value.As<v8::BigInt>()->Uint64Value(&lossless);
+  if (!lossless) {
+    return;
+  }
+
+  v8::Local<v8::Value> level_value;
+  if (!data_array->Get(context, 1).ToLocal(&level_value) ||
+      !level_value->IsUint32()) {
+    return;
+  }
+  const auto level = static_cast<ConsoleLevel>(
+      level_value.As<v8::Uint32>()->Value());
+
+  const std::shared_ptr<ConsoleBuffer> buffer =
+      GetBuffers()->GetObject(buffer_id);
+  if (!buffer) {
+    return;
+  }
+
+  // Formatting can call user code (e.g., valueOf for %d, or a stack getter),
+  // which may throw. If so, we log nothing, and let the exception propagate to
+  // the caller, as browsers do. Only JSON.stringify failures other than
+  // termination are not propagated; see FormatValue.
+  std::string line;
+  if (!FormatArgs(info, context).To(&line)) {
+    return;
+  }
+  buffer->Append(level, std::move(line));
+}
+
+}  // end namespace MiniRacer
@@ -0,0 +1,81 @@
+#ifndef INCLUDE_MINI_RACER_NATIVE_CONSOLE_H
+#define INCLUDE_MINI_RACER_NATIVE_CONSOLE_H
+
+#include <v8-context.h>
+#include <v8-function-callback.h>
+#include <v8-isolate.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "context_holder.h"
+#include "id_maker.h"
+
+namespace MiniRacer {
+
+enum class ConsoleLevel : uint8_t {
+  kLog = 0,
+  kInfo = 1,
+  kWarn = 2,
+  kError = 3,
+  kDebug = 4,
+};
+
+/** A bounded buffer of console output. When full, we drop the oldest lines
+ * (and count them). */
+class ConsoleBuffer {
+ public:
+  void SetCapacity(size_t capacity);
+  void Append(ConsoleLevel level, std::string text);
+
+  /** Empties the buffer, and returns what it held (and the drop count) as
+   * JSON (see mr_drain_console). */
+  auto Drain() -> std::string;
+
+ private:
+  struct Line {
+    ConsoleLevel level;
+    std::string text;
+  };
+
+  std::mutex mutex_;
+  size_t capacity_{0};
+  std::deque<Line> lines_;
+  uint64_t dropped_{0};
+};
+
+/** Implements the JavaScript console (console.log, etc.) in C++, writing to
+ * a ConsoleBuffer for the MiniRacer user (i.e., Python) to drain in bulk.
+ *
+ * As with JSCallbackMaker, the functions we give JavaScript refer to the
+ * buffer by ID, not pointer, so that late calls are safely ignored. */
+class NativeConsole {
+ public:
+  explicit NativeConsole(ContextHolder* context_holder);
+
+  /** Replaces the console methods in the global console object. Must be
+   * called from the isolate message pump. */
+  void Install(v8::Isolate* isolate, size_t capacity);
+
+  auto Drain() -> std::string;
+
+  /** Longer lines are truncated. */
+  static constexpr size_t kMaxLineBytes = 16384;
+
+ private:
+  static void OnCalledStatic(const v8::FunctionCallbackInfo<v8::Value>& info);
+  static auto GetBuffers() -> std::shared_ptr<IdMaker<ConsoleBuffer>>;
+
+  static std::shared_ptr<IdMaker<ConsoleBuffer>> buffers_;
+  static std::once_flag buffers_init_flag_;
+
+  ContextHolder* context_holder_;
+  std::shared_ptr<ConsoleBuffer> buffer_;
+  IdHolder<ConsoleBuffer> buffer_holder_;
+};
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_NATIVE_CONSOLE_H
@@ -5,16 +5,33 @@
 #include <v8-function.h>
 #include <v8-isolate.h>
 #include <v8-local-handle.h>
+#include <v8-maybe.h>
 #include <v8-object.h>
 #include <v8-persistent-handle.h>
 #include <v8-primitive.h>
+#include <v8-value.h>
+#include <cstddef>
 #include <cstdint>
+#include <tuple>
 #include <vector>
 #include "binary_value.h"
 #include "context_holder.h"
 
 namespace MiniRacer {
 
+namespace {
+
+/** Returns the private symbol which marks the arrays we return from
+ * GetOwnPropertyNames, so that Get can tell property names from other
+ * strings. */
+auto PropertyNamesMarker(v8::Isolate* isolate) -> v8::Local<v8::Private> {
+  return v8::Private::ForApi(
+      isolate,
+      v8::String::NewFromUtf8Literal(isolate, "MiniRacer::property_names"));
+}
+
+}  // end anonymous namespace
+
 ObjectManipulator::ObjectManipulator(ContextHolder* context,
                                      BinaryValueFactory* bv_factory)
     : context_(context), bv_factory_(bv_factory) {}
@@ -47,6 +64,8 @@ auto ObjectManipulator::GetOwnPropertyNames(v8::Isolate* isolate,
 
   const v8::Local<v8::Array> names =
       local_obj->GetPropertyNames(local_context).ToLocalChecked();
+  std::ignore = names->SetPrivate(local_context, PropertyNamesMarker(isolate),
+                                  v8::True(isolate));
 
   return bv_factory_->New(local_context, names);
 }
@@ -70,6 +89,13 @@ auto ObjectManipulator::Get(v8::Isolate* isolate,
   const v8::Local<v8::Value> value =
       local_obj->Get(local_context, local_key).ToLocalChecked();
 
+  // Property names recur across objects of the same shape, so we intern them:
+  if (value->IsString() && local_obj->IsArray() &&
+      local_obj->HasPrivate(local_context, PropertyNamesMarker(isolate))
+          .FromMaybe(false)) {
+    return bv_factory_->NewInterned(local_context, value);
+  }
+
   return bv_factory_->New(local_context, value);
 }
 
@@ -214,4 +240,142 @@ auto ObjectManipulator::Call(v8::Isolate* isolate,
   return bv_factory_->New(local_context, maybe_value.ToLocalChecked());
 }
 
+auto ObjectManipulator::RunBatch(v8::Isolate* isolate,
+                                 const std::vector<BatchOp>& ops)
+    -> std::vector<BinaryValue::Ptr> {
+  const v8::Isolate::Scope isolate_scope(isolate);
+  const v8::HandleScope handle_scope(isolate);
+  const v8::Local<v8::Context> local_context = context_->Get()->Get(isolate);
+  const v8::Context::Scope context_scope(local_context);
+
+  const v8::TryCatch trycatch(isolate);
+
+  std::vector<v8::Local<v8::Value>> local_results;
+  std::vector<BinaryValue::Ptr> results;
+  local_results.reserve(ops.size());
+  results.reserve(ops.size());
+
+  for (const BatchOp& op : ops) {
+    BinaryValue::Ptr error;
+    v8::Local<v8::Value> result;
+    if (!RunBatchOp(isolate, local_context, op, local_results, &error)
+             .ToLocal(&result)) {
+      if (!error) {
+        error = bv_factory_->New(local_context, trycatch.Message(),
+                                 trycatch.Exception(),
+                                 trycatch.HasTerminated()
+                                     ? type_terminated_exception
+                                     : type_execute_exception);
+      }
+      results.push_back(std::move(error));
+      break;
+    }
+
+    local_results.push_back(result);
+    results.push_back(bv_factory_->New(local_context, result));
+  }
+
+  return results;
+}
+
+auto ObjectManipulator::RunBatchOp(
+    v8::Isolate* isolate,
+    v8::Local<v8::Context> context,
+    const BatchOp& op,
+    const std::vector<v8::Local<v8::Value>>& results,
+    BinaryValue::Ptr* error) -> v8::MaybeLocal<v8::Value> {
+  // (Operand counts were checked when the batch was decoded.)
+  auto operand = [&](size_t idx) -> v8::Local<v8::Value> {
+    const BatchOperand& operand = op.operands[idx];
+    if (operand.result_index.has_value()) {
+      return results[*operand.result_index];
+    }
+    return operand.value->ToValue(context);
+  };
+
+  if (op.code == BatchOpCode::kCall) {
+    const v8::Local<v8::Value> func_val = operand(0);
+    if (!func_val->IsFunction()) {
+      *error =
+          bv_factory_->New("function is not callable", type_execute_exception);
+      return {};
+    }
+
+    std::vector<v8::Local<v8::Value>> argv;
+    for (size_t i = 2; i < op.operands.size(); i++) {
+      argv.push_back(operand(i));
+    }
+
+    return func_val.As<v8::Function>()->Call(
+        context, operand(1), static_cast<int>(argv.size()), argv.data());
+  }
+
+  const v8::Local<v8::Value> obj_val = operand(0);
+  if (!obj_val->IsObject()) {
+    *error = bv_factory_->New("not an object", type_value_exception);
+    return {};
+  }
+  const v8::Local<v8::Object> obj = obj_val.As<v8::Object>();
+
+  switch (op.code) {
+    case BatchOpCode::kGet:
+    case BatchOpCode::kDel: {
+      const v8::Local<v8::Value> key = operand(1);
+      const v8::Maybe<bool> has = obj->Has(context, key);
+      if (has.IsNothing()) {
+        return {};
+      }
+      if (!has.FromJust()) {
+        *error = bv_factory_->New("No such key", type_key_exception);
+        return {};
+      }
+
+      if (op.code == BatchOpCode::kGet) {
+        return obj->Get(context, key);
+      }
+
+      const v8::Maybe<bool> deleted = obj->Delete(context, key);
+      if (deleted.IsNothing()) {
+        return {};
+      }
+      return v8::Boolean::New(isolate, deleted.FromJust());
+    }
+    case BatchOpCode::kSet:
+      if (obj->Set(context, operand(1), operand(2)).IsNothing()) {
+        return {};
+      }
+      return v8::True(isolate);
+    case BatchOpCode::kSplice: {
+      v8::Local<v8::Value> splice_val;
+      if (!obj->Get(context, v8::String::NewFromUtf8Literal(isolate, "splice"))
+               .ToLocal(&splice_val)) {
+        return {};
+      }
+
+      if (!splice_val->IsFunction()) {
+        *error = bv_factory_->New("splice method is not a function",
+                                  type_execute_exception);
+        return {};
+      }
+
+      std::vector<v8::Local<v8::Value>> argv = {
+          v8::Number::New(isolate,
+                          static_cast<double>(op.operands[1].int_val)),
+          v8::Number::New(isolate,
+                          static_cast<double>(op.operands[2].int_val)),
+      };
+      for (size_t i = 3; i < op.operands.size(); i++) {
+        argv.push_back(operand(i));
+      }
+
+      return splice_val.As<v8::Function>()->Call(
+          context, obj, static_cast<int>(argv.size()), argv.data());
+    }
+    case BatchOpCode::kCall:
+      break;
+  }
+
+  return {};
+}
+
 }  // end namespace MiniRacer
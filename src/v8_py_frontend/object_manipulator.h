@@ -1,14 +1,43 @@
 #ifndef INCLUDE_MINI_RACER_OBJECT_MANIPULATOR_H
 #define INCLUDE_MINI_RACER_OBJECT_MANIPULATOR_H
 
+#include <v8-context.h>
+#include <v8-exception.h>
 #include <v8-isolate.h>
+#include <v8-local-handle.h>
 #include <v8-persistent-handle.h>
+#include <cstddef>
 #include <cstdint>
+#include <optional>
+#include <vector>
 #include "binary_value.h"
 #include "context_holder.h"
 
 namespace MiniRacer {
 
+/** Operations which can be fused into one batch (see mr_run_batch). */
+enum class BatchOpCode : uint8_t {
+  kGet = 1,
+  kSet = 2,
+  kDel = 3,
+  kSplice = 4,
+  // (Keep this last; Context::DecodeBatch checks opcodes against it.)
+  kCall = 5,
+};
+
+/** One operand of a batched operation. This is either a value, the result of
+ * an earlier operation in the same batch, or an integer. */
+struct BatchOperand {
+  BinaryValue::Ptr value;
+  std::optional<size_t> result_index;
+  int64_t int_val = 0;
+};
+
+struct BatchOp {
+  BatchOpCode code;
+  std::vector<BatchOperand> operands;
+};
+
 /** Manipulates v8::Object attributes, exposing APIs reachable from C (through
  * the MiniRacer::Context).
  *
@@ -43,7 +72,22 @@ class ObjectManipulator {
             BinaryValue* this_ptr,
             BinaryValue* argv_ptr) -> BinaryValue::Ptr;
 
+  /** Runs a sequence of operations under one set of scopes, and returns their
+   * results in order. Operands may refer to results of earlier operations
+   * without converting them back and forth.
+   *
+   * Stops at the first failing operation, whose result is then an exception.
+   * Thus fewer results than operations means failure. */
+  auto RunBatch(v8::Isolate* isolate, const std::vector<BatchOp>& ops)
+      -> std::vector<BinaryValue::Ptr>;
+
  private:
+  auto RunBatchOp(v8::Isolate* isolate,
+                  v8::Local<v8::Context> context,
+                  const BatchOp& op,
+                  const std::vector<v8::Local<v8::Value>>& results,
+                  BinaryValue::Ptr* error) -> v8::MaybeLocal<v8::Value>;
+
   ContextHolder* context_;
   BinaryValueFactory* bv_factory_;
 };
@@ -0,0 +1,24 @@
+#include "string_interner.h"
+#include <string>
+#include <string_view>
+
+namespace MiniRacer {
+
+auto StringInterner::Intern(std::string_view str) -> const std::string* {
+  if (str.size() > kMaxLength) {
+    return nullptr;
+  }
+
+  auto iter = strings_.find(str);
+  if (iter != strings_.end()) {
+    return &*iter;
+  }
+
+  if (strings_.size() >= kMaxEntries) {
+    return nullptr;
+  }
+
+  return &*strings_.emplace(str).first;
+}
+
+}  // end namespace MiniRacer
@@ -0,0 +1,50 @@
+#ifndef INCLUDE_MINI_RACER_STRING_INTERNER_H
+#define INCLUDE_MINI_RACER_STRING_INTERNER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace MiniRacer {
+
+/** A table of property names which we send to Python over and over (e.g., the
+ * keys of record-shaped objects), so that we can send each as a reference to
+ * one stable copy, instead of as a fresh copy each time.
+ *
+ * The address of a string's copy in this table identifies it for as long as
+ * the table lives, so the Python side can cache the decoded str by address
+ * (see type_interned_str_utf8).
+ *
+ * We only intern property names (as read out of GetOwnPropertyNames results),
+ * up to kMaxLength bytes long, first come, first served, until the table is
+ * full. Other strings are far less likely to recur, and would otherwise fill
+ * the table up with one-off values for good.
+ *
+ * This is only used from the isolate's message pump thread, and so is not
+ * thread safe. */
+class StringInterner {
+ public:
+  static constexpr size_t kMaxLength = 64;
+  static constexpr size_t kMaxEntries = 4096;
+
+  /** Returns the table's copy of str, adding it if there's room, or nullptr if
+   * str is too long or the table is full. */
+  auto Intern(std::string_view str) -> const std::string*;
+
+ private:
+  struct Hash {
+    using is_transparent = void;
+    auto operator()(std::string_view str) const -> size_t {
+      return std::hash<std::string_view>()(str);
+    }
+  };
+
+  // Elements of an unordered_set keep their address when it rehashes:
+  std::unordered_set<std::string, Hash, std::equal_to<>> strings_;
+};
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_STRING_INTERNER_H
@@ -0,0 +1,203 @@
+#include "task_watchdog.h"
+#include <v8-debug.h>
+#include <v8-isolate.h>
+#include <v8-local-handle.h>
+#include <v8-primitive.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "isolate_manager.h"
+#include "json_util.h"
+
+namespace MiniRacer {
+
+namespace {
+
+auto ToString(v8::Isolate* isolate, v8::Local<v8::String> str) -> std::string {
+  if (str.IsEmpty()) {
+    return {};
+  }
+  const v8::String::Utf8Value utf8(isolate, str);
+  return {*utf8, static_cast<size_t>(utf8.length())};
+}
+
+}  // end anonymous namespace
+
+TaskWatchdog::TaskWatchdog(IsolateManager* isolate_manager)
+    : isolate_manager_(isolate_manager) {}
+
+TaskWatchdog::~TaskWatchdog() {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void TaskWatchdog::SetThreshold(std::chrono::milliseconds threshold) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    threshold_ = threshold;
+    if (threshold_.count() > 0 && !thread_.joinable()) {
+      isolate_manager_->EnableTaskTracking();
+      thread_ = std::thread([this]() { Watch(); });
+    }
+  }
+  cv_.notify_all();
+}
+
+auto TaskWatchdog::GetRecordsJSON() -> std::string {
+  const std::lock_guard<std::mutex> lock(mutex_);
+
+  std::string out = "[";
+  const uint64_t first =
+      record_count_ > kMaxRecords ? record_count_ - kMaxRecords : 0;
+  for (uint64_t i = first; i < record_count_; i++) {
+    const Record& record = records_.at(i % kMaxRecords);
+    if (i != first) {
+      out.push_back(',');
+    }
+    out.append("{\"id\":");
+    out.append(std::to_string(record.id));
+    out.append(",\"task_kind\":");
+    AppendJSONString(&out, record.kind == TaskKind::kJavaScript
+                               ? "javascript"
+                               : "no_javascript");
+    out.append(",\"elapsed_ms\":");
+    out.append(std::to_string(record.elapsed.count()));
+    out.append(",\"stack\":[");
+    for (size_t j = 0; j < record.stack.size(); j++) {
+      const Frame& frame = record.stack[j];
+      if (j != 0) {
+        out.push_back(',');
+      }
+      out.append("{\"function\":");
+      AppendJSONString(&out, frame.function);
+      out.append(",\"script\":");
+      AppendJSONString(&out, frame.script);
+      out.append(",\"line\":");
+      out.append(std::to_string(frame.line));
+      out.append(",\"column\":");
+      out.append(std::to_string(frame.column));
+      out.push_back('}');
+    }
+    out.append("]}");
+  }
+  out.push_back(']');
+  return out;
+}
+
+void TaskWatchdog::Watch() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    if (threshold_.count() == 0) {
+      cv_.wait(lock);
+      continue;
+    }
+
+    std::chrono::milliseconds next_check = threshold_;
+    CheckRunningTaskLocked(&next_check);
+    cv_.wait_for(lock, next_check);
+  }
+}
+
+void TaskWatchdog::CheckRunningTaskLocked(
+    std::chrono::milliseconds* next_check) {
+  const std::optional<RunningTask> task = isolate_manager_->GetRunningTask();
+  if (!task.has_value() || task->seq == flagged_task_seq_) {
+    return;
+  }
+
+  const auto elapsed = std::chrono::steady_clock::now() - task->started;
+  if (elapsed < threshold_) {
+    *next_check =
+        std::chrono::ceil<std::chrono::milliseconds>(threshold_ - elapsed);
+    return;
+  }
+
+  flagged_task_seq_ = task->seq;
+  AddRecordLocked(*task);
+
+  if (task->kind == TaskKind::kNoJavaScript) {
+    // There's no JavaScript stack to capture (and V8 wouldn't service an
+    // interrupt anyway):
+    stack_record_id_ = 0;
+    return;
+  }
+
+  // If an interrupt is still pending (e.g., because the last flagged task
+  // ended before V8 serviced it), it will serve for this task too:
+  stack_record_id_ = record_count_;
+  if (!interrupt_requested_) {
+    interrupt_requested_ = true;
+    isolate_manager_->RequestInterrupt(&TaskWatchdog::OnInterrupt, this);
+  }
+}
+
+void TaskWatchdog::AddRecordLocked(const RunningTask& task) {
+  Record& record = records_.at(record_count_ % kMaxRecords);
+  record_count_++;
+  record.id = record_count_;
+  record.kind = task.kind;
+  record.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - task.started);
+  record.stack.clear();
+}
+
+void TaskWatchdog::OnInterrupt(v8::Isolate* isolate, void* data) {
+  // We're on the message pump thread, in the middle of running a script.
+  auto* self = static_cast<TaskWatchdog*>(data);
+  const std::optional<RunningTask> task =
+      self->isolate_manager_->GetRunningTask();
+  uint64_t record_id = 0;
+  {
+    const std::lock_guard<std::mutex> lock(self->mutex_);
+    self->interrupt_requested_ = false;
+    record_id = std::exchange(self->stack_record_id_, 0);
+    if (record_id == 0 || !task.has_value() ||
+        task->seq != self->flagged_task_seq_) {
+      // The flagged task finished before we got here, so its record goes
+      // without a stack.
+      return;
+    }
+  }
+
+  std::vector<Frame> stack = CaptureStack(isolate);
+
+  const std::lock_guard<std::mutex> lock(self->mutex_);
+  // Unless the ring buffer wrapped around meanwhile:
+  Record& record = self->records_.at((record_id - 1) % kMaxRecords);
+  if (record.id == record_id) {
+    record.stack = std::move(stack);
+  }
+}
+
+auto TaskWatchdog::CaptureStack(v8::Isolate* isolate) -> std::vector<Frame> {
+  const v8::HandleScope handle_scope(isolate);
+  const v8::Local<v8::StackTrace> trace =
+      v8::StackTrace::CurrentStackTrace(isolate, kMaxFrames);
+
+  std::vector<Frame> stack;
+  stack.reserve(static_cast<size_t>(trace->GetFrameCount()));
+  for (int i = 0; i < trace->GetFrameCount(); i++) {
+    const v8::Local<v8::StackFrame> frame = trace->GetFrame(isolate, i);
+    stack.push_back({
+        ToString(isolate, frame->GetFunctionName()),
+        ToString(isolate, frame->GetScriptName()),
+        frame->GetLineNumber(),
+        frame->GetColumn(),
+    });
+  }
+  return stack;
+}
+
+}  // end namespace MiniRacer
@@ -0,0 +1,91 @@
+#ifndef INCLUDE_MINI_RACER_TASK_WATCHDOG_H
+#define INCLUDE_MINI_RACER_TASK_WATCHDOG_H
+
+#include <v8-isolate.h>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "isolate_manager.h"
+
+namespace MiniRacer {
+
+/** Watches for tasks which hog the message pump.
+ *
+ * Once a threshold is set, a watchdog thread polls the IsolateManager for the
+ * running task. When a task runs past the threshold, we record it right away.
+ * For tasks which run JavaScript, we then use an isolate interrupt to attach
+ * the JavaScript stack to the record, if the task is still running when the
+ * interrupt fires. We keep the last kMaxRecords records in a ring buffer, for
+ * GetRecordsJSON.
+ *
+ * V8 only services interrupts while running JavaScript, so the owner must stop
+ * JavaScript (see IsolateManager::StopJavaScript) before destroying this
+ * object, lest a pending interrupt fire after we're gone. */
+class TaskWatchdog {
+ public:
+  explicit TaskWatchdog(IsolateManager* isolate_manager);
+  ~TaskWatchdog();
+
+  TaskWatchdog(const TaskWatchdog&) = delete;
+  auto operator=(const TaskWatchdog&) -> TaskWatchdog& = delete;
+  TaskWatchdog(TaskWatchdog&&) = delete;
+  auto operator=(TaskWatchdog&& other) -> TaskWatchdog& = delete;
+
+  /** Sets how long a task may run before we record it. Zero (the default)
+   * disables the watchdog. */
+  void SetThreshold(std::chrono::milliseconds threshold);
+
+  /** Returns the recorded tasks as a JSON array, oldest first. */
+  auto GetRecordsJSON() -> std::string;
+
+ private:
+  static constexpr size_t kMaxRecords = 64;
+  static constexpr int kMaxFrames = 32;
+
+  struct Frame {
+    std::string function;
+    std::string script;
+    int line;
+    int column;
+  };
+
+  struct Record {
+    uint64_t id;
+    TaskKind kind;
+    std::chrono::milliseconds elapsed;
+    std::vector<Frame> stack;
+  };
+
+  void Watch();
+  void CheckRunningTaskLocked(std::chrono::milliseconds* next_check);
+  void AddRecordLocked(const RunningTask& task);
+  static void OnInterrupt(v8::Isolate* isolate, void* data);
+  static auto CaptureStack(v8::Isolate* isolate) -> std::vector<Frame>;
+
+  IsolateManager* isolate_manager_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::chrono::milliseconds threshold_{0};
+  bool stop_{false};
+  // The RunningTask::seq of the last task we recorded, so we record each task
+  // at most once:
+  uint64_t flagged_task_seq_{0};
+  // The ID of the record which the next interrupt should attach a stack to,
+  // or zero if none:
+  uint64_t stack_record_id_{0};
+  bool interrupt_requested_{false};
+  std::array<Record, kMaxRecords> records_;
+  uint64_t record_count_{0};
+  // Started on the first SetThreshold call:
+  std::thread thread_;
+};
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_TASK_WATCHDOG_H
@@ -0,0 +1,159 @@
+#include "thread_affinity.h"
+
+#include <v8config.h>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(V8_OS_LINUX)
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <array>
+#include <climits>
+#endif  // V8_OS_LINUX
+
+namespace MiniRacer {
+
+namespace {
+
+auto ParseCpu(std::string_view str, uint32_t* cpu) -> bool {
+  const char* end = str.data() + str.size();
+  auto [ptr, ec] = std::from_chars(str.data(), end, *cpu);
+  return ec == std::errc() && ptr == end;
+}
+
+}  // end anonymous namespace
+
+auto ParseCpuList(std::string_view list, std::vector<uint32_t>* cpus) -> bool {
+  // sysfs files end with a newline:
+  while (!list.empty() && (list.back() == '\n' || list.back() == ' ')) {
+    list.remove_suffix(1);
+  }
+
+  while (!list.empty()) {
+    const size_t comma = list.find(',');
+    const std::string_view item = list.substr(0, comma);
+    list = comma == std::string_view::npos ? std::string_view()
+                                           : list.substr(comma + 1);
+
+    const size_t dash = item.find('-');
+    uint32_t first = 0;
+    uint32_t last = 0;
+    if (dash == std::string_view::npos) {
+      if (!ParseCpu(item, &first)) {
+        return false;
+      }
+      last = first;
+    } else if (!ParseCpu(item.substr(0, dash), &first) ||
+               !ParseCpu(item.substr(dash + 1), &last) || last < first) {
+      return false;
+    }
+
+    for (uint32_t cpu = first; cpu <= last; cpu++) {
+      cpus->push_back(cpu);
+    }
+  }
+
+  return true;
+}
+
+#if defined(V8_OS_LINUX)
+
+namespace {
+
+// Enough for any machine we're likely to meet:
+constexpr size_t kMaxNumaNodes = 1024;
+
+auto GetNodeCpuList(int32_t numa_node, std::string* list) -> bool {
+  std::ifstream file("/sys/devices/system/node/node" +
+                     std::to_string(numa_node) + "/cpulist");
+  if (!file) {
+    return false;
+  }
+  list->assign(std::istreambuf_iterator<char>(file),
+               std::istreambuf_iterator<char>());
+  return true;
+}
+
+auto PreferNumaNode(int32_t numa_node) -> bool {
+  constexpr size_t kBitsPerWord = sizeof(unsigned long) * CHAR_BIT;
+  std::array<unsigned long, kMaxNumaNodes / kBitsPerWord> mask{};
+  const auto node = static_cast<size_t>(numa_node);
+  mask.at(node / kBitsPerWord) |= 1UL << (node % kBitsPerWord);
+  // glibc has no wrapper for set_mempolicy (that's in libnuma, which we'd
+  // rather not depend on). The kernel reads one bit fewer than maxnode says,
+  // hence the + 1:
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  return syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(),
+                 kMaxNumaNodes + 1) == 0;
+}
+
+}  // end anonymous namespace
+
+auto PinCurrentThread(std::string_view cpus, int32_t numa_node) -> bool {
+  if (numa_node >= static_cast<int32_t>(kMaxNumaNodes)) {
+    return false;
+  }
+
+  std::string node_cpus;
+  if (cpus.empty() && numa_node >= 0) {
+    if (!GetNodeCpuList(numa_node, &node_cpus)) {
+      return false;
+    }
+    cpus = node_cpus;
+  }
+
+  if (cpus.empty()) {
+    return numa_node < 0 || PreferNumaNode(numa_node);
+  }
+
+  std::vector<uint32_t> cpu_list;
+  if (!ParseCpuList(cpus, &cpu_list) || cpu_list.empty()) {
+    return false;
+  }
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (const uint32_t cpu : cpu_list) {
+    if (cpu >= CPU_SETSIZE) {
+      return false;
+    }
+    CPU_SET(cpu, &cpu_set);
+  }
+
+  // On Linux, pid 0 means the calling thread (not the whole process). We keep
+  // the old affinity around, to put it back if we can't set the memory policy
+  // (e.g., because a seccomp filter forbids set_mempolicy), so that we don't
+  // leave the thread half pinned:
+  cpu_set_t old_cpu_set;
+  if (sched_getaffinity(0, sizeof(old_cpu_set), &old_cpu_set) != 0 ||
+      sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+    return false;
+  }
+
+  if (numa_node >= 0 && !PreferNumaNode(numa_node)) {
+    sched_setaffinity(0, sizeof(old_cpu_set), &old_cpu_set);
+    return false;
+  }
+
+  return true;
+}
+
+#else  // V8_OS_LINUX
+
+auto PinCurrentThread(std::string_view /*cpus*/, int32_t /*numa_node*/)
+    -> bool {
+  return false;
+}
+
+#endif  // V8_OS_LINUX
+
+}  // end namespace MiniRacer
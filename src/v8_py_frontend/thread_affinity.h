@@ -0,0 +1,30 @@
+#ifndef INCLUDE_MINI_RACER_THREAD_AFFINITY_H
+#define INCLUDE_MINI_RACER_THREAD_AFFINITY_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace MiniRacer {
+
+/** Parses a CPU list in the Linux format (e.g., "0-3,8,10-11", as found in
+ * /sys/devices/system/node/node<N>/cpulist). Returns false if the list is
+ * malformed. */
+auto ParseCpuList(std::string_view list, std::vector<uint32_t>* cpus) -> bool;
+
+/** Pins the calling thread to the given CPUs (a CPU list, as above) and, if
+ * numa_node is non-negative, prefers that NUMA node for the thread's future
+ * memory allocations. If cpus is empty and numa_node is given, we pin to the
+ * node's CPUs.
+ *
+ * The node is a preference (MPOL_PREFERRED), not a hard binding, so that a
+ * full node spills over instead of failing allocations. Memory the thread
+ * already touched stays where it is.
+ *
+ * Returns false (leaving the thread's CPU affinity as it was) on failure, or
+ * on platforms other than Linux. */
+auto PinCurrentThread(std::string_view cpus, int32_t numa_node) -> bool;
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_THREAD_AFFINITY_H
@@ -0,0 +1,987 @@
+#include "web_builtins.h"
+
+#include <v8-array-buffer.h>
+#include <v8-context.h>
+#include <v8-exception.h>
+#include <v8-function-callback.h>
+#include <v8-function.h>
+#include <v8-isolate.h>
+#include <v8-local-handle.h>
+#include <v8-object.h>
+#include <v8-primitive.h>
+#include <v8-promise.h>
+#include <v8-template.h>
+#include <v8-typed-array.h>
+#include <v8-value-serializer.h>
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "digest.h"
+
+namespace MiniRacer {
+
+namespace {
+
+// TextDecoder instances keep their state in one internal field, as a uint32_t:
+// the flags below, and up to 3 bytes of a multi-byte UTF-8 sequence which was
+// cut off at the end of the last streaming decode() call.
+constexpr uint32_t kDecoderFatal = 1U << 0;
+constexpr uint32_t kDecoderIgnoreBOM = 1U << 1;
+constexpr uint32_t kDecoderBOMSeen = 1U << 2;
+constexpr uint32_t kDecoderFlagsMask = kDecoderFatal | kDecoderIgnoreBOM;
+constexpr int kDecoderPendingCountShift = 3;
+constexpr uint32_t kDecoderPendingCountMask = 3;
+constexpr int kDecoderPendingShift = 8;
+
+constexpr int kWriteUtf8Options =
+    v8::String::NO_NULL_TERMINATION | v8::String::REPLACE_INVALID_UTF8;
+
+constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+
+// The most getRandomValues fills per call, per the Web Crypto standard:
+constexpr size_t kMaxRandomBytes = 65536;
+
+constexpr std::string_view kBase64Chars =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+constexpr auto MakeBase64DecodeTable() -> std::array<int8_t, 256> {
+  std::array<int8_t, 256> table{};
+  for (int8_t& entry : table) {
+    entry = -1;
+  }
+  for (size_t i = 0; i < kBase64Chars.size(); i++) {
+    table.at(static_cast<uint8_t>(kBase64Chars[i])) = static_cast<int8_t>(i);
+  }
+  return table;
+}
+
+constexpr std::array<int8_t, 256> kBase64DecodeTable = MakeBase64DecodeTable();
+
+auto NewString(v8::Isolate* isolate, const char* str) -> v8::Local<v8::String> {
+  return v8::String::NewFromUtf8(isolate, str).ToLocalChecked();
+}
+
+void ThrowTypeError(v8::Isolate* isolate, const char* msg) {
+  isolate->ThrowException(v8::Exception::TypeError(NewString(isolate, msg)));
+}
+
+void ThrowRangeError(v8::Isolate* isolate, const char* msg) {
+  isolate->ThrowException(v8::Exception::RangeError(NewString(isolate, msg)));
+}
+
+/** Throws the equivalent of a DOMException with the given name (V8 has no
+ * DOMException). */
+void ThrowDOMException(v8::Isolate* isolate,
+                       const char* name,
+                       const char* msg) {
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  const v8::Local<v8::Value> error =
+      v8::Exception::Error(NewString(isolate, msg));
+  std::ignore = error.As<v8::Object>()->Set(
+      context, NewString(isolate, "name"), NewString(isolate, name));
+  isolate->ThrowException(error);
+}
+
+auto RequireConstructCall(const v8::FunctionCallbackInfo<v8::Value>& info,
+                          const char* msg) -> bool {
+  if (info.IsConstructCall()) {
+    return true;
+  }
+  ThrowTypeError(info.GetIsolate(), msg);
+  return false;
+}
+
+/** Finds the bytes of an ArrayBuffer, SharedArrayBuffer, or view of either. */
+auto GetBytes(v8::Local<v8::Value> value, std::string_view* bytes) -> bool {
+  const char* data = nullptr;
+  size_t len = 0;
+  if (value->IsArrayBufferView()) {
+    const v8::Local<v8::ArrayBufferView> view =
+        value.As<v8::ArrayBufferView>();
+    len = view->ByteLength();
+    if (len > 0) {
+      data =
+          static_cast<const char*>(view->Buffer()->Data()) + view->ByteOffset();
+    }
+  } else if (value->IsArrayBuffer()) {
+    const v8::Local<v8::ArrayBuffer> buffer = value.As<v8::ArrayBuffer>();
+    data = static_cast<const char*>(buffer->Data());
+    len = buffer->ByteLength();
+  } else if (value->IsSharedArrayBuffer()) {
+    const v8::Local<v8::SharedArrayBuffer> buffer =
+        value.As<v8::SharedArrayBuffer>();
+    data = static_cast<const char*>(buffer->Data());
+    len = buffer->ByteLength();
+  } else {
+    return false;
+  }
+  *bytes = len > 0 ? std::string_view(data, len) : std::string_view();
+  return true;
+}
+
+auto IsAscii(std::string_view bytes) -> bool {
+  size_t i = 0;
+  // 8 bytes at a time, with no branches, so that compilers can vectorize:
+  uint64_t high_bits = 0;
+  for (; i + 8 <= bytes.size(); i += 8) {
+    uint64_t chunk = 0;
+    std::memcpy(&chunk, bytes.data() + i, sizeof(chunk));
+    high_bits |= chunk;
+  }
+  for (; i < bytes.size(); i++) {
+    high_bits |= static_cast<uint8_t>(bytes[i]);
+  }
+  return (high_bits & kHighBits) == 0;
+}
+
+/** Checks for well-formed UTF-8, per table 3-7 of the Unicode standard. */
+auto IsValidUtf8(std::string_view bytes) -> bool {
+  const auto* data = reinterpret_cast<const uint8_t*>(bytes.data());
+  const size_t len = bytes.size();
+  size_t i = 0;
+  while (i < len) {
+    // Skip runs of ASCII 8 bytes at a time:
+    if (i + 8 <= len) {
+      uint64_t chunk = 0;
+      std::memcpy(&chunk, data + i, sizeof(chunk));
+      if ((chunk & kHighBits) == 0) {
+        i += 8;
+        continue;
+      }
+    }
+
+    const uint8_t lead = data[i];
+    if (lead < 0x80) {
+      i++;
+      continue;
+    }
+
+    size_t trail = 0;
+    uint8_t min_second = 0x80;
+    uint8_t max_second = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      trail = 1;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      trail = 2;
+      // Overlong encodings and surrogates:
+      min_second = lead == 0xE0 ? 0xA0 : min_second;
+      max_second = lead == 0xED ? 0x9F : max_second;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      trail = 3;
+      // Overlong encodings and code points past U+10FFFF:
+      min_second = lead == 0xF0 ? 0x90 : min_second;
+      max_second = lead == 0xF4 ? 0x8F : max_second;
+    } else {
+      return false;
+    }
+
+    if (len - i <= trail || data[i + 1] < min_second ||
+        data[i + 1] > max_second) {
+      return false;
+    }
+    for (size_t j = 2; j <= trail; j++) {
+      if ((data[i + j] & 0xC0) != 0x80) {
+        return false;
+      }
+    }
+    i += trail + 1;
+  }
+  return true;
+}
+
+/** Counts the trailing bytes which start, but don't finish, a multi-byte UTF-8
+ * sequence. */
+auto IncompleteTail(std::string_view bytes) -> size_t {
+  for (size_t back = 1; back <= 3 && back <= bytes.size(); back++) {
+    const auto byte = static_cast<uint8_t>(bytes[bytes.size() - back]);
+    if ((byte & 0xC0) == 0x80) {
+      continue;
+    }
+    size_t needed = 0;
+    if (byte >= 0xF5) {
+      needed = 0;
+    } else if (byte >= 0xF0) {
+      needed = 4;
+    } else if (byte >= 0xE0) {
+      needed = 3;
+    } else if (byte >= 0xC2) {
+      needed = 2;
+    }
+    return needed > back ? back : 0;
+  }
+  return 0;
+}
+
+auto Base64Encode(std::string_view bytes) -> std::string {
+  std::string out((bytes.size() + 2) / 3 * 4, '=');
+  const auto* src = reinterpret_cast<const uint8_t*>(bytes.data());
+  char* dst = out.data();
+  size_t i = 0;
+  // Whole 3-byte groups, with no branches, so that compilers can vectorize:
+  for (; i + 3 <= bytes.size(); i += 3) {
+    const uint32_t group = (static_cast<uint32_t>(src[i]) << 16U) |
+                           (static_cast<uint32_t>(src[i + 1]) << 8U) |
+                           src[i + 2];
+    *dst++ = kBase64Chars[group >> 18U];
+    *dst++ = kBase64Chars[(group >> 12U) & 63U];
+    *dst++ = kBase64Chars[(group >> 6U) & 63U];
+    *dst++ = kBase64Chars[group & 63U];
+  }
+
+  const size_t rest = bytes.size() - i;
+  if (rest > 0) {
+    uint32_t group = static_cast<uint32_t>(src[i]) << 16U;
+    if (rest == 2) {
+      group |= static_cast<uint32_t>(src[i + 1]) << 8U;
+    }
+    *dst++ = kBase64Chars[group >> 18U];
+    *dst++ = kBase64Chars[(group >> 12U) & 63U];
+    if (rest == 2) {
+      *dst = kBase64Chars[(group >> 6U) & 63U];
+    }
+  }
+  return out;
+}
+
+/** Implements "forgiving-base64 decode" from the WHATWG Infra standard.
+ * Returns false if the input is invalid. */
+auto Base64Decode(std::string_view chars, std::string* out) -> bool {
+  std::string clean;
+  clean.reserve(chars.size());
+  for (const char chr : chars) {
+    if (chr != ' ' && chr != '\t' && chr != '\n' && chr != '\f' &&
+        chr != '\r') {
+      clean.push_back(chr);
+    }
+  }
+  if (!clean.empty() && clean.size() % 4 == 0 && clean.back() == '=') {
+    clean.pop_back();
+    if (clean.back() == '=') {
+      clean.pop_back();
+    }
+  }
+  if (clean.size() % 4 == 1) {
+    return false;
+  }
+
+  auto sextet = [&clean](size_t pos) -> int32_t {
+    return kBase64DecodeTable.at(static_cast<uint8_t>(clean[pos]));
+  };
+
+  out->clear();
+  out->reserve(clean.size() / 4 * 3 + 2);
+  size_t i = 0;
+  for (; i + 4 <= clean.size(); i += 4) {
+    const int32_t sextets =
+        (sextet(i) << 18) | (sextet(i + 1) << 12) | (sextet(i + 2) << 6) |
+        sextet(i + 3);
+    // Any invalid character (-1) makes the whole group negative:
+    if (sextets < 0) {
+      return false;
+    }
+    out->push_back(static_cast<char>(sextets >> 16));
+    out->push_back(static_cast<char>(sextets >> 8));
+    out->push_back(static_cast<char>(sextets));
+  }
+
+  const size_t rest = clean.size() - i;
+  if (rest > 0) {
+    const int32_t third = rest == 3 ? sextet(i + 2) : 0;
+    if (sextet(i) < 0 || sextet(i + 1) < 0 || third < 0) {
+      return false;
+    }
+    const int32_t sextets =
+        (sextet(i) << 18) | (sextet(i + 1) << 12) | (third << 6);
+    out->push_back(static_cast<char>(sextets >> 16));
+    if (rest == 3) {
+      out->push_back(static_cast<char>(sextets >> 8));
+    }
+  }
+  return true;
+}
+
+/** Reads a string whose characters are all in the range U+0000 to U+00FF, as
+ * atob and btoa require, into bytes. */
+auto ReadLatin1(v8::Isolate* isolate,
+                v8::Local<v8::String> str,
+                std::string* out) -> bool {
+  if (!str->ContainsOnlyOneByte()) {
+    return false;
+  }
+  out->resize(static_cast<size_t>(str->Length()));
+  str->WriteOneByte(isolate, reinterpret_cast<uint8_t*>(out->data()), 0,
+                    str->Length(), v8::String::NO_NULL_TERMINATION);
+  return true;
+}
+
+auto NewLatin1(v8::Isolate* isolate, std::string_view bytes)
+    -> v8::MaybeLocal<v8::String> {
+  if (bytes.size() > static_cast<size_t>(v8::String::kMaxLength)) {
+    return {};
+  }
+  return v8::String::NewFromOneByte(
+      isolate, reinterpret_cast<const uint8_t*>(bytes.data()),
+      v8::NewStringType::kNormal, static_cast<int>(bytes.size()));
+}
+
+void TextEncoderNew(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  RequireConstructCall(info, "Failed to construct 'TextEncoder'");
+}
+
+void TextEncoderEncode(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+  v8::Local<v8::String> str = v8::String::Empty(isolate);
+  if (info.Length() > 0 && !info[0]->IsUndefined() &&
+      !info[0]->ToString(context).ToLocal(&str)) {
+    return;
+  }
+
+  // We write straight into the new array's backing store:
+  const int len = str->Utf8Length(isolate);
+  std::unique_ptr<v8::BackingStore> store =
+      v8::ArrayBuffer::NewBackingStore(isolate, static_cast<size_t>(len));
+  if (len > 0) {
+    str->WriteUtf8(isolate, static_cast<char*>(store->Data()), len, nullptr,
+                   kWriteUtf8Options);
+  }
+  const v8::Local<v8::ArrayBuffer> buffer =
+      v8::ArrayBuffer::New(isolate, std::move(store));
+  info.GetReturnValue().Set(
+      v8::Uint8Array::New(buffer, 0, static_cast<size_t>(len)));
+}
+
+void TextEncoderEncodeInto(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+  if (info.Length() < 2 || !info[1]->IsUint8Array()) {
+    ThrowTypeError(isolate,
+                   "TextEncoder.encodeInto: destination must be a Uint8Array");
+    return;
+  }
+  v8::Local<v8::String> str;
+  if (!info[0]->ToString(context).ToLocal(&str)) {
+    return;
+  }
+
+  const v8::Local<v8::Uint8Array> dest = info[1].As<v8::Uint8Array>();
+  const size_t capacity = std::min<size_t>(dest->ByteLength(), INT_MAX);
+  int read = 0;
+  int written = 0;
+  if (capacity > 0) {
+    // WriteUtf8 never writes part of a character, so this is exactly the
+    // prefix of str which fits:
+    written = str->WriteUtf8(
+        isolate,
+        static_cast<char*>(dest->Buffer()->Data()) + dest->ByteOffset(),
+        static_cast<int>(capacity), &read, kWriteUtf8Options);
+  }
+
+  const v8::Local<v8::Object> result = v8::Object::New(isolate);
+  if (result
+          ->Set(context, NewString(isolate, "read"),
+                v8::Integer::New(isolate, read))
+          .IsNothing() ||
+      result
+          ->Set(context, NewString(isolate, "written"),
+                v8::Integer::New(isolate, written))
+          .IsNothing()) {
+    return;
+  }
+  info.GetReturnValue().Set(result);
+}
+
+void TextDecoderNew(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+  if (!RequireConstructCall(info, "Failed to construct 'TextDecoder'")) {
+    return;
+  }
+
+  if (info.Length() > 0 && !info[0]->IsUndefined()) {
+    v8::Local<v8::String> label_str;
+    if (!info[0]->ToString(context).ToLocal(&label_str)) {
+      return;
+    }
+    const v8::String::Utf8Value label_utf8(isolate, label_str);
+    std::string label(*label_utf8, static_cast<size_t>(label_utf8.length()));
+    const size_t start = label.find_first_not_of(" \t\n\f\r");
+    const size_t end = label.find_last_not_of(" \t\n\f\r");
+    label = start == std::string::npos ? ""
+                                       : label.substr(start, end - start + 1);
+    for (char& chr : label) {
+      if (chr >= 'A' && chr <= 'Z') {
+        chr = static_cast<char>(chr - 'A' + 'a');
+      }
+    }
+    // The labels which the WHATWG Encoding standard maps to UTF-8, which is
+    // the only encoding we support:
+    if (label != "utf-8" && label != "utf8" && label != "unicode-1-1-utf-8" &&
+        label != "unicode11utf8" && label != "unicode20utf8" &&
+        label != "x-unicode20utf8") {
+      ThrowRangeError(isolate, "TextDecoder: unsupported encoding");
+      return;
+    }
+  }
+
+  bool fatal = false;
+  bool ignore_bom = false;
+  if (info.Length() > 1 && info[1]->IsObject()) {
+    const v8::Local<v8::Object> options = info[1].As<v8::Object>();
+    v8::Local<v8::Value> val;
+    if (!options->Get(context, NewString(isolate, "fatal")).ToLocal(&val)) {
+      return;
+    }
+    fatal = val->BooleanValue(isolate);
+    if (!options->Get(context, NewString(isolate, "ignoreBOM"))
+             .ToLocal(&val)) {
+      return;
+    }
+    ignore_bom = val->BooleanValue(isolate);
+  }
+
+  const v8::Local<v8::Object> self = info.This();
+  const uint32_t state =
+      (fatal ? kDecoderFatal : 0) | (ignore_bom ? kDecoderIgnoreBOM : 0);
+  self->SetInternalField(0, v8::Integer::NewFromUnsigned(isolate, state));
+
+  const std::array<std::pair<const char*, v8::Local<v8::Value>>, 3> props{{
+      {"encoding", NewString(isolate, "utf-8")},
+      {"fatal", v8::Boolean::New(isolate, fatal)},
+      {"ignoreBOM", v8::Boolean::New(isolate, ignore_bom)},
+  }};
+  for (const auto& [name, val] : props) {
+    if (self->DefineOwnProperty(context, NewString(isolate, name), val,
+                                v8::ReadOnly)
+            .IsNothing()) {
+      return;
+    }
+  }
+}
+
+void TextDecoderDecode(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+  // Our signature guarantees that This() is a TextDecoder:
+  const v8::Local<v8::Object> self = info.This();
+  const uint32_t state =
+      self->GetInternalField(0).As<v8::Value>().As<v8::Uint32>()->Value();
+
+  // Reading options can run a user getter, which could detach or shrink the
+  // input buffer, so we do that before we look at the input bytes:
+  bool stream = false;
+  if (info.Length() > 1 && info[1]->IsObject()) {
+    v8::Local<v8::Value> val;
+    if (!info[1]
+             .As<v8::Object>()
+             ->Get(context, NewString(isolate, "stream"))
+             .ToLocal(&val)) {
+      return;
+    }
+    stream = val->BooleanValue(isolate);
+  }
+
+  std::string_view input;
+  if (info.Length() > 0 && !info[0]->IsUndefined() &&
+      !GetBytes(info[0], &input)) {
+    ThrowTypeError(isolate,
+                   "TextDecoder.decode: input must be an ArrayBuffer or "
+                   "ArrayBufferView");
+    return;
+  }
+
+  // Prepend whatever the last streaming call left of a multi-byte sequence:
+  std::string joined;
+  const uint32_t pending_count =
+      (state >> kDecoderPendingCountShift) & kDecoderPendingCountMask;
+  if (pending_count > 0) {
+    for (uint32_t i = 0; i < pending_count; i++) {
+      joined.push_back(
+          static_cast<char>(state >> (kDecoderPendingShift + (8 * i))));
+    }
+    joined.append(input);
+    input = joined;
+  }
+
+  // When streaming, hold back any cut-off sequence for the next call:
+  const size_t tail = stream ? IncompleteTail(input) : 0;
+  std::string_view bytes = input.substr(0, input.size() - tail);
+
+  uint32_t new_state = state & (kDecoderFlagsMask | kDecoderBOMSeen);
+  if (!bytes.empty()) {
+    if ((state & (kDecoderIgnoreBOM | kDecoderBOMSeen)) == 0 &&
+        bytes.substr(0, 3) == "\xEF\xBB\xBF") {
+      bytes.remove_prefix(3);
+    }
+    new_state |= kDecoderBOMSeen;
+  }
+  if (stream) {
+    for (size_t i = 0; i < tail; i++) {
+      new_state |= static_cast<uint32_t>(static_cast<uint8_t>(
+                       input[input.size() - tail + i]))
+                   << (kDecoderPendingShift + (8 * i));
+    }
+    new_state |= static_cast<uint32_t>(tail) << kDecoderPendingCountShift;
+  } else {
+    // The end of the stream resets the decoder:
+    new_state &= kDecoderFlagsMask;
+  }
+
+  if ((state & kDecoderFatal) != 0 && !IsValidUtf8(bytes)) {
+    self->SetInternalField(
+        0, v8::Integer::NewFromUnsigned(isolate, state & kDecoderFlagsMask));
+    ThrowTypeError(isolate, "TextDecoder.decode: invalid UTF-8 data");
+    return;
+  }
+
+  v8::Local<v8::String> result;
+  if (IsAscii(bytes)) {
+    if (!NewLatin1(isolate, bytes).ToLocal(&result)) {
+      ThrowRangeError(isolate, "TextDecoder.decode: string too long");
+      return;
+    }
+  } else if (bytes.size() > static_cast<size_t>(v8::String::kMaxLength) ||
+             !v8::String::NewFromUtf8(isolate, bytes.data(),
+                                      v8::NewStringType::kNormal,
+                                      static_cast<int>(bytes.size()))
+                  .ToLocal(&result)) {
+    // (NewFromUtf8 replaces invalid sequences with U+FFFD, as the WHATWG
+    // Encoding standard requires of non-fatal decoders.)
+    ThrowRangeError(isolate, "TextDecoder.decode: string too long");
+    return;
+  }
+
+  self->SetInternalField(0, v8::Integer::NewFromUnsigned(isolate, new_state));
+  info.GetReturnValue().Set(result);
+}
+
+void Atob(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+  if (info.Length() < 1) {
+    ThrowTypeError(isolate, "atob: 1 argument required");
+    return;
+  }
+  v8::Local<v8::String> str;
+  if (!info[0]->ToString(context).ToLocal(&str)) {
+    return;
+  }
+
+  std::string chars;
+  std::string bytes;
+  if (!ReadLatin1(isolate, str, &chars) || !Base64Decode(chars, &bytes)) {
+    ThrowDOMException(isolate, "InvalidCharacterError",
+                      "atob: the string is not correctly encoded");
+    return;
+  }
+
+  v8::Local<v8::String> result;
+  if (!NewLatin1(isolate, bytes).ToLocal(&result)) {
+    ThrowRangeError(isolate, "atob: string too long");
+    return;
+  }
+  info.GetReturnValue().Set(result);
+}
+
+void Btoa(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+  if (info.Length() < 1) {
+    ThrowTypeError(isolate, "btoa: 1 argument required");
+    return;
+  }
+  v8::Local<v8::String> str;
+  if (!info[0]->ToString(context).ToLocal(&str)) {
+    return;
+  }
+
+  std::string bytes;
+  if (!ReadLatin1(isolate, str, &bytes)) {
+    ThrowDOMException(
+        isolate, "InvalidCharacterError",
+        "btoa: the string contains characters outside of Latin1");
+    return;
+  }
+
+  v8::Local<v8::String> result;
+  if (!NewLatin1(isolate, Base64Encode(bytes)).ToLocal(&result)) {
+    ThrowRangeError(isolate, "btoa: string too long");
+    return;
+  }
+  info.GetReturnValue().Set(result);
+}
+
+struct FreeDeleter {
+  void operator()(uint8_t* ptr) const {
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    std::free(ptr);
+  }
+};
+
+void StructuredClone(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+  if (info.Length() < 1) {
+    ThrowTypeError(isolate, "structuredClone: 1 argument required");
+    return;
+  }
+
+  // With no delegate, V8 throws on uncloneable values (including host
+  // objects and SharedArrayBuffers):
+  v8::ValueSerializer serializer(isolate);
+  serializer.WriteHeader();
+  bool success = false;
+  if (!serializer.WriteValue(context, info[0]).To(&success) || !success) {
+    return;
+  }
+  // Release() hands over a buffer allocated with realloc:
+  const std::pair<uint8_t*, size_t> data = serializer.Release();
+  const std::unique_ptr<uint8_t, FreeDeleter> data_owner(data.first);
+
+  v8::ValueDeserializer deserializer(isolate, data.first, data.second);
+  if (!deserializer.ReadHeader(context).To(&success) || !success) {
+    return;
+  }
+  v8::Local<v8::Value> result;
+  if (!deserializer.ReadValue(context).ToLocal(&result)) {
+    return;
+  }
+  info.GetReturnValue().Set(result);
+}
+
+/** Fills out with cryptographically secure random bytes. */
+void FillRandom(uint8_t* out, size_t len) {
+  // std::random_device draws from the OS (e.g., getrandom or /dev/urandom on
+  // Linux, and rand_s on Windows):
+  static std::mutex mutex;
+  static std::random_device device;
+  const std::lock_guard<std::mutex> lock(mutex);
+  while (len > 0) {
+    const std::random_device::result_type word = device();
+    const size_t count = std::min(len, sizeof(word));
+    std::memcpy(out, &word, count);
+    out += count;
+    len -= count;
+  }
+}
+
+/** Finds the bytes to hash: those of a BufferSource, in place, or else the
+ * UTF-8 encoding of the value as a string, which we write to storage. */
+auto GetHashInput(v8::Isolate* isolate,
+                  v8::Local<v8::Context> context,
+                  v8::Local<v8::Value> value,
+                  std::string* storage,
+                  std::string_view* bytes) -> bool {
+  if (GetBytes(value, bytes)) {
+    return true;
+  }
+  v8::Local<v8::String> str;
+  if (!value->ToString(context).ToLocal(&str)) {
+    return false;
+  }
+  const int len = str->Utf8Length(isolate);
+  storage->resize(static_cast<size_t>(len));
+  str->WriteUtf8(isolate, storage->data(), len, nullptr, kWriteUtf8Options);
+  *bytes = *storage;
+  return true;
+}
+
+/** Parses a Web Crypto algorithm identifier: a name like "SHA-256", or an
+ * object with such a name. */
+auto GetDigestAlgorithm(v8::Isolate* isolate,
+                        v8::Local<v8::Context> context,
+                        v8::Local<v8::Value> value,
+                        DigestAlgorithm* algorithm) -> bool {
+  if (value->IsObject()) {
+    if (!value.As<v8::Object>()
+             ->Get(context, NewString(isolate, "name"))
+             .ToLocal(&value)) {
+      return false;
+    }
+  }
+  v8::Local<v8::String> name_str;
+  if (!value->ToString(context).ToLocal(&name_str)) {
+    return false;
+  }
+  const v8::String::Utf8Value name_utf8(isolate, name_str);
+  std::string name(*name_utf8, static_cast<size_t>(name_utf8.length()));
+  for (char& chr : name) {
+    if (chr >= 'a' && chr <= 'z') {
+      chr = static_cast<char>(chr - 'a' + 'A');
+    }
+  }
+
+  const std::array<std::pair<const char*, DigestAlgorithm>, 4> names{{
+      {"SHA-1", DigestAlgorithm::kSha1},
+      {"SHA-256", DigestAlgorithm::kSha256},
+      {"SHA-384", DigestAlgorithm::kSha384},
+      {"SHA-512", DigestAlgorithm::kSha512},
+  }};
+  for (const auto& [known_name, known_algorithm] : names) {
+    if (name == known_name) {
+      *algorithm = known_algorithm;
+      return true;
+    }
+  }
+  ThrowDOMException(isolate, "NotSupportedError",
+                    "digest: unrecognized algorithm name");
+  return false;
+}
+
+/** Implements digest(algorithm, data), returning the digest in a new
+ * ArrayBuffer, or throwing. */
+auto ComputeDigest(const v8::FunctionCallbackInfo<v8::Value>& info)
+    -> v8::MaybeLocal<v8::ArrayBuffer> {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+  if (info.Length() < 2) {
+    ThrowTypeError(isolate, "digest: 2 arguments required");
+    return {};
+  }
+  DigestAlgorithm algorithm = DigestAlgorithm::kSha256;
+  if (!GetDigestAlgorithm(isolate, context, info[0], &algorithm)) {
+    return {};
+  }
+  std::string storage;
+  std::string_view bytes;
+  if (!GetHashInput(isolate, context, info[1], &storage, &bytes)) {
+    return {};
+  }
+
+  std::unique_ptr<v8::BackingStore> store =
+      v8::ArrayBuffer::NewBackingStore(isolate, DigestSize(algorithm));
+  Digest(algorithm, bytes, static_cast<uint8_t*>(store->Data()));
+  return v8::ArrayBuffer::New(isolate, std::move(store));
+}
+
+void CryptoDigestSync(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  const v8::HandleScope scope(info.GetIsolate());
+  v8::Local<v8::ArrayBuffer> result;
+  if (ComputeDigest(info).ToLocal(&result)) {
+    info.GetReturnValue().Set(result);
+  }
+}
+
+void CryptoSubtleDigest(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+  v8::Local<v8::Promise::Resolver> resolver;
+  if (!v8::Promise::Resolver::New(context).ToLocal(&resolver)) {
+    return;
+  }
+
+  // We hash synchronously, but report the result (or error) through a
+  // Promise, as the Web Crypto standard requires:
+  const v8::TryCatch trycatch(isolate);
+  v8::Local<v8::ArrayBuffer> result;
+  if (ComputeDigest(info).ToLocal(&result)) {
+    std::ignore = resolver->Resolve(context, result);
+  } else if (trycatch.CanContinue()) {
+    std::ignore = resolver->Reject(context, trycatch.Exception());
+  } else {
+    // We're being terminated.
+    return;
+  }
+  info.GetReturnValue().Set(resolver->GetPromise());
+}
+
+void CryptoXxHash64(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+  const v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+  if (info.Length() < 1) {
+    ThrowTypeError(isolate, "xxhash64: 1 argument required");
+    return;
+  }
+  // Converting the seed can run a user valueOf, which could detach or shrink
+  // the input buffer, so we capture the input bytes last:
+  uint64_t seed = 0;
+  if (info.Length() > 1 && info[1]->IsBigInt()) {
+    seed = info[1].As<v8::BigInt>()->Uint64Value();
+  } else if (info.Length() > 1 && !info[1]->IsUndefined()) {
+    int64_t seed_int = 0;
+    if (!info[1]->IntegerValue(context).To(&seed_int)) {
+      return;
+    }
+    seed = static_cast<uint64_t>(seed_int);
+  }
+
+  std::string storage;
+  std::string_view bytes;
+  if (!GetHashInput(isolate, context, info[0], &storage, &bytes)) {
+    return;
+  }
+
+  info.GetReturnValue().Set(
+      v8::BigInt::NewFromUnsigned(isolate, XxHash64(bytes, seed)));
+}
+
+void CryptoGetRandomValues(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+
+  if (info.Length() < 1 || !info[0]->IsTypedArray() ||
+      info[0]->IsFloat32Array() || info[0]->IsFloat64Array()) {
+    ThrowDOMException(isolate, "TypeMismatchError",
+                      "getRandomValues: argument must be an integer array");
+    return;
+  }
+  const v8::Local<v8::TypedArray> array = info[0].As<v8::TypedArray>();
+  const size_t len = array->ByteLength();
+  if (len > kMaxRandomBytes) {
+    ThrowDOMException(isolate, "QuotaExceededError",
+                      "getRandomValues: array exceeds 65536 bytes");
+    return;
+  }
+  if (len > 0) {
+    FillRandom(
+        static_cast<uint8_t*>(array->Buffer()->Data()) + array->ByteOffset(),
+        len);
+  }
+  info.GetReturnValue().Set(array);
+}
+
+void CryptoRandomUUID(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  const v8::HandleScope scope(isolate);
+
+  std::array<uint8_t, 16> bytes{};
+  FillRandom(bytes.data(), bytes.size());
+  // Version 4, variant 1 (RFC 9562):
+  bytes[6] = (bytes[6] & 0x0fU) | 0x40U;
+  bytes[8] = (bytes[8] & 0x3fU) | 0x80U;
+
+  constexpr std::string_view kHexDigits = "0123456789abcdef";
+  std::string uuid;
+  for (size_t i = 0; i < bytes.size(); i++) {
+    if (i == 4 || i == 6 || i == 8 || i == 10) {
+      uuid.push_back('-');
+    }
+    uuid.push_back(kHexDigits[bytes.at(i) >> 4U]);
+    uuid.push_back(kHexDigits[bytes.at(i) & 0x0fU]);
+  }
+  info.GetReturnValue().Set(NewString(isolate, uuid.c_str()));
+}
+
+/** Makes an object with the given native methods. */
+auto NewNamespace(
+    v8::Isolate* isolate,
+    v8::Local<v8::Context> context,
+    const std::vector<std::pair<const char*, v8::FunctionCallback>>& methods)
+    -> v8::Local<v8::Object> {
+  const v8::Local<v8::Object> obj = v8::Object::New(isolate);
+  for (const auto& [name, callback] : methods) {
+    const v8::Local<v8::Function> func =
+        v8::Function::New(context, callback).ToLocalChecked();
+    func->SetName(NewString(isolate, name));
+    obj->DefineOwnProperty(context, NewString(isolate, name), func,
+                           v8::DontEnum)
+        .Check();
+  }
+  return obj;
+}
+
+}  // end anonymous namespace
+
+void WebBuiltins::Install(v8::Isolate* isolate,
+                          v8::Local<v8::Context> context) {
+  const v8::Context::Scope context_scope(context);
+  const v8::Local<v8::Object> global = context->Global();
+
+  // Like other web APIs, these are writable, configurable, and not enumerable:
+  auto set_global = [&](const char* name, v8::Local<v8::Value> val) {
+    global->DefineOwnProperty(context, NewString(isolate, name), val,
+                              v8::DontEnum)
+        .Check();
+  };
+
+  const v8::Local<v8::FunctionTemplate> encoder =
+      v8::FunctionTemplate::New(isolate, &TextEncoderNew);
+  encoder->SetClassName(NewString(isolate, "TextEncoder"));
+  const v8::Local<v8::Signature> encoder_sig =
+      v8::Signature::New(isolate, encoder);
+  const v8::Local<v8::ObjectTemplate> encoder_proto =
+      encoder->PrototypeTemplate();
+  encoder_proto->Set(isolate, "encode",
+                     v8::FunctionTemplate::New(isolate, &TextEncoderEncode, {},
+                                               encoder_sig, 0));
+  encoder_proto->Set(isolate, "encodeInto",
+                     v8::FunctionTemplate::New(isolate, &TextEncoderEncodeInto,
+                                               {}, encoder_sig, 2));
+  encoder_proto->Set(NewString(isolate, "encoding"),
+                     NewString(isolate, "utf-8"), v8::ReadOnly);
+  set_global("TextEncoder", encoder->GetFunction(context).ToLocalChecked());
+
+  const v8::Local<v8::FunctionTemplate> decoder =
+      v8::FunctionTemplate::New(isolate, &TextDecoderNew);
+  decoder->SetClassName(NewString(isolate, "TextDecoder"));
+  decoder->InstanceTemplate()->SetInternalFieldCount(1);
+  const v8::Local<v8::Signature> decoder_sig =
+      v8::Signature::New(isolate, decoder);
+  decoder->PrototypeTemplate()->Set(
+      isolate, "decode",
+      v8::FunctionTemplate::New(isolate, &TextDecoderDecode, {}, decoder_sig,
+                                0));
+  set_global("TextDecoder", decoder->GetFunction(context).ToLocalChecked());
+
+  const std::array<std::pair<const char*, v8::FunctionCallback>, 3> funcs{{
+      {"atob", &Atob},
+      {"btoa", &Btoa},
+      {"structuredClone", &StructuredClone},
+  }};
+  for (const auto& [name, callback] : funcs) {
+    const v8::Local<v8::Function> func =
+        v8::Function::New(context, callback, {}, 1).ToLocalChecked();
+    func->SetName(NewString(isolate, name));
+    set_global(name, func);
+  }
+
+  // crypto.digestSync and crypto.xxhash64 are MiniRacer extensions:
+  const v8::Local<v8::Object> crypto =
+      NewNamespace(isolate, context,
+                   {
+                       {"getRandomValues", &CryptoGetRandomValues},
+                       {"randomUUID", &CryptoRandomUUID},
+                       {"digestSync", &CryptoDigestSync},
+                       {"xxhash64", &CryptoXxHash64},
+                   });
+  const v8::Local<v8::Object> subtle =
+      NewNamespace(isolate, context, {{"digest", &CryptoSubtleDigest}});
+  crypto
+      ->DefineOwnProperty(context, NewString(isolate, "subtle"), subtle,
+                          v8::ReadOnly)
+      .Check();
+  set_global("crypto", crypto);
+}
+
+}  // end namespace MiniRacer
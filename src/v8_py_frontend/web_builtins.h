@@ -0,0 +1,27 @@
+#ifndef INCLUDE_MINI_RACER_WEB_BUILTINS_H
+#define INCLUDE_MINI_RACER_WEB_BUILTINS_H
+
+#include <v8-context.h>
+#include <v8-isolate.h>
+#include <v8-local-handle.h>
+
+namespace MiniRacer {
+
+/** Native implementations of web APIs which bare V8 lacks: TextEncoder,
+ * TextDecoder, atob, btoa, structuredClone, and crypto (getRandomValues,
+ * randomUUID, and subtle.digest, plus the non-standard digestSync and
+ * xxhash64). (setTimeout and clearTimeout are implemented in JavaScript
+ * instead; see _set_timeout.py.)
+ *
+ * These keep no state outside the JavaScript objects they create, so unlike
+ * JSCallbackMaker or NativeConsole, they need no link back to the Context. */
+class WebBuiltins {
+ public:
+  /** Installs the builtins as globals. Must be called from the isolate
+   * message pump, within a HandleScope. */
+  static void Install(v8::Isolate* isolate, v8::Local<v8::Context> context);
+};
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_WEB_BUILTINS_H
@@ -0,0 +1,268 @@
+#include "worker_pool_platform.h"
+
+#include <libplatform/libplatform.h>
+#include <v8-isolate.h>
+#include <v8-platform.h>
+#include <v8-source-location.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "huge_pages.h"
+
+namespace MiniRacer {
+
+namespace {
+
+auto Index(v8::TaskPriority priority) -> size_t {
+  return static_cast<size_t>(priority);
+}
+
+auto DefaultWorkerCount() -> uint32_t {
+  const uint32_t cores = std::thread::hardware_concurrency();
+  return std::clamp<uint32_t>(cores > 0 ? cores - 1 : 1, 1,
+                              WorkerPoolPlatform::kMaxDefaultWorkers);
+}
+
+}  // end anonymous namespace
+
+WorkerPoolPlatform::WorkerPoolPlatform(
+    std::unique_ptr<v8::Platform> default_platform,
+    const PlatformConfig& config,
+    bool single_threaded)
+    : default_platform_(std::move(default_platform)), queues_() {
+  if (config.huge_pages) {
+    huge_page_allocator_ = std::make_unique<HugePageAllocator>(
+        default_platform_->GetPageAllocator());
+  }
+
+  uint32_t worker_count = 0;
+  if (!single_threaded) {
+    worker_count = config.worker_threads > 0 ? config.worker_threads
+                                             : DefaultWorkerCount();
+  }
+
+  const auto cap = [worker_count](uint32_t limit) -> size_t {
+    return limit > 0 ? std::min(limit, worker_count) : worker_count;
+  };
+  queues_[Index(v8::TaskPriority::kUserBlocking)].max_running = worker_count;
+  queues_[Index(v8::TaskPriority::kUserVisible)].max_running =
+      cap(config.max_user_visible_workers);
+  queues_[Index(v8::TaskPriority::kBestEffort)].max_running =
+      cap(config.max_best_effort_workers);
+
+  workers_.reserve(worker_count);
+  for (uint32_t i = 0; i < worker_count; i++) {
+    workers_.emplace_back([this]() { Work(); });
+  }
+}
+
+WorkerPoolPlatform::~WorkerPoolPlatform() {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+auto WorkerPoolPlatform::GetDefaultPlatform() const -> v8::Platform* {
+  return default_platform_.get();
+}
+
+auto WorkerPoolPlatform::GetStats() -> PlatformStats {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  PlatformStats stats{};
+  stats.worker_threads = workers_.size();
+  stats.delayed = delayed_.size();
+  for (size_t i = 0; i < queues_.size(); i++) {
+    const Queue& queue = queues_.at(i);
+    stats.priorities.at(i) = {queue.posted, queue.executed,
+                              queue.tasks.size(), queue.running,
+                              queue.peak_running};
+  }
+  return stats;
+}
+
+void WorkerPoolPlatform::Work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    v8::TaskPriority priority{};
+    double wake_time = 0;
+    std::unique_ptr<v8::Task> task = NextTaskLocked(&priority, &wake_time);
+    if (!task) {
+      if (std::isinf(wake_time)) {
+        cv_.wait(lock);
+      } else {
+        cv_.wait_for(lock, std::chrono::duration<double>(
+                               wake_time - MonotonicallyIncreasingTime()));
+      }
+      continue;
+    }
+
+    Queue& queue = queues_.at(Index(priority));
+    queue.running++;
+    queue.peak_running = std::max(queue.peak_running, queue.running);
+    lock.unlock();
+    task->Run();
+    task.reset();
+    lock.lock();
+    queue.running--;
+    queue.executed++;
+
+    // We freed up a slot under this queue's cap, which another worker may be
+    // waiting on:
+    cv_.notify_one();
+  }
+}
+
+auto WorkerPoolPlatform::NextTaskLocked(v8::TaskPriority* priority,
+                                        double* wake_time)
+    -> std::unique_ptr<v8::Task> {
+  const double now = MonotonicallyIncreasingTime();
+  while (!delayed_.empty() && delayed_.begin()->first <= now) {
+    DelayedTask& delayed = delayed_.begin()->second;
+    Queue& queue = queues_.at(Index(delayed.priority));
+    queue.tasks.push_back(std::move(delayed.task));
+    delayed_.erase(delayed_.begin());
+  }
+
+  // Most urgent first:
+  for (size_t i = queues_.size(); i-- > 0;) {
+    Queue& queue = queues_.at(i);
+    if (!queue.tasks.empty() && queue.running < queue.max_running) {
+      std::unique_ptr<v8::Task> task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      *priority = static_cast<v8::TaskPriority>(i);
+      return task;
+    }
+  }
+
+  *wake_time = delayed_.empty() ? std::numeric_limits<double>::infinity()
+                                : delayed_.begin()->first;
+  return {};
+}
+
+auto WorkerPoolPlatform::CreateJobImpl(
+    v8::TaskPriority priority,
+    std::unique_ptr<v8::JobTask> job_task,
+    const v8::SourceLocation& /*location*/) -> std::unique_ptr<v8::JobHandle> {
+  // Jobs post their worker tasks back to us, so our caps apply to them anyway,
+  // but telling the job about the cap up front spares it from posting tasks
+  // which would only sit in the queue:
+  return v8::platform::NewDefaultJobHandle(
+      this, priority, std::move(job_task),
+      queues_.at(Index(priority)).max_running);
+}
+
+void WorkerPoolPlatform::PostTaskOnWorkerThreadImpl(
+    v8::TaskPriority priority,
+    std::unique_ptr<v8::Task> task,
+    const v8::SourceLocation& /*location*/) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    Queue& queue = queues_.at(Index(priority));
+    queue.tasks.push_back(std::move(task));
+    queue.posted++;
+  }
+  cv_.notify_one();
+}
+
+void WorkerPoolPlatform::PostDelayedTaskOnWorkerThreadImpl(
+    v8::TaskPriority priority,
+    std::unique_ptr<v8::Task> task,
+    double delay_in_seconds,
+    const v8::SourceLocation& /*location*/) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    delayed_.emplace(MonotonicallyIncreasingTime() + delay_in_seconds,
+                     DelayedTask{priority, std::move(task)});
+    queues_.at(Index(priority)).posted++;
+  }
+  // Wake a worker to recompute how long it may sleep:
+  cv_.notify_one();
+}
+
+auto WorkerPoolPlatform::GetPageAllocator() -> v8::PageAllocator* {
+  if (huge_page_allocator_) {
+    return huge_page_allocator_.get();
+  }
+  return default_platform_->GetPageAllocator();
+}
+
+auto WorkerPoolPlatform::GetThreadIsolatedAllocator()
+    -> v8::ThreadIsolatedAllocator* {
+  return default_platform_->GetThreadIsolatedAllocator();
+}
+
+auto WorkerPoolPlatform::GetZoneBackingAllocator()
+    -> v8::ZoneBackingAllocator* {
+  return default_platform_->GetZoneBackingAllocator();
+}
+
+void WorkerPoolPlatform::OnCriticalMemoryPressure() {
+  default_platform_->OnCriticalMemoryPressure();
+}
+
+auto WorkerPoolPlatform::NumberOfWorkerThreads() -> int {
+  return static_cast<int>(workers_.size());
+}
+
+auto WorkerPoolPlatform::GetForegroundTaskRunner(v8::Isolate* isolate,
+                                                 v8::TaskPriority priority)
+    -> std::shared_ptr<v8::TaskRunner> {
+  return default_platform_->GetForegroundTaskRunner(isolate, priority);
+}
+
+auto WorkerPoolPlatform::IdleTasksEnabled(v8::Isolate* isolate) -> bool {
+  return default_platform_->IdleTasksEnabled(isolate);
+}
+
+auto WorkerPoolPlatform::CreateBlockingScope(v8::BlockingType blocking_type)
+    -> std::unique_ptr<v8::ScopedBlockingCall> {
+  return default_platform_->CreateBlockingScope(blocking_type);
+}
+
+auto WorkerPoolPlatform::MonotonicallyIncreasingTime() -> double {
+  return default_platform_->MonotonicallyIncreasingTime();
+}
+
+auto WorkerPoolPlatform::CurrentClockTimeMilliseconds() -> int64_t {
+  return default_platform_->CurrentClockTimeMilliseconds();
+}
+
+auto WorkerPoolPlatform::CurrentClockTimeMillis() -> double {
+  return default_platform_->CurrentClockTimeMillis();
+}
+
+auto WorkerPoolPlatform::CurrentClockTimeMillisecondsHighResolution()
+    -> double {
+  return default_platform_->CurrentClockTimeMillisecondsHighResolution();
+}
+
+auto WorkerPoolPlatform::GetStackTracePrinter() -> StackTracePrinter {
+  return default_platform_->GetStackTracePrinter();
+}
+
+auto WorkerPoolPlatform::GetTracingController() -> v8::TracingController* {
+  return default_platform_->GetTracingController();
+}
+
+void WorkerPoolPlatform::DumpWithoutCrashing() {
+  default_platform_->DumpWithoutCrashing();
+}
+
+auto WorkerPoolPlatform::GetHighAllocationThroughputObserver()
+    -> v8::HighAllocationThroughputObserver* {
+  return default_platform_->GetHighAllocationThroughputObserver();
+}
+
+}  // end namespace MiniRacer
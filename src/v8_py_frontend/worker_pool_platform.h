@@ -0,0 +1,172 @@
+#ifndef INCLUDE_MINI_RACER_WORKER_POOL_PLATFORM_H
+#define INCLUDE_MINI_RACER_WORKER_POOL_PLATFORM_H
+
+#include <v8-isolate.h>
+#include <v8-platform.h>
+#include <v8-source-location.h>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "huge_pages.h"
+
+namespace MiniRacer {
+
+/** Settings for the WorkerPoolPlatform. Zero (or false) means "use the
+ * default" for every field. */
+struct PlatformConfig {
+  /** How many background worker threads to run. The default, like V8's own,
+   * is one fewer than the number of cores, capped at kMaxDefaultWorkers. */
+  uint32_t worker_threads;
+  /** How many workers may run kUserVisible tasks at once. V8 uses this
+   * priority for most concurrent GC work (e.g., marking) and for optimizing
+   * compiles. */
+  uint32_t max_user_visible_workers;
+  /** How many workers may run kBestEffort tasks at once. V8 uses this priority
+   * for background work which is nice to have done early, like sweeping and
+   * lazy compiles. */
+  uint32_t max_best_effort_workers;
+  /** Whether to ask for transparent huge pages on large regions V8 allocates
+   * (see HugePageAllocator). */
+  bool huge_pages;
+};
+
+/** Counters for one task priority. */
+struct PriorityStats {
+  uint64_t posted;
+  uint64_t executed;
+  uint64_t queued;
+  uint64_t running;
+  // The most tasks which ever ran at once:
+  uint64_t peak_running;
+};
+
+/** Counters for the WorkerPoolPlatform, with one PriorityStats per
+ * v8::TaskPriority (indexed by its value). */
+struct PlatformStats {
+  uint64_t worker_threads;
+  uint64_t delayed;
+  std::array<PriorityStats, 3> priorities;
+};
+
+/** A v8::Platform which runs V8's background tasks on a worker pool of our
+ * own, and delegates everything else (foreground task runners, clocks,
+ * tracing, and the page allocator) to a libplatform default platform.
+ *
+ * The default platform sizes its worker pool to the whole machine, which
+ * oversubscribes cores when many processes on one host each run V8. Our pool
+ * has a configurable size, keeps one queue per task priority (always running
+ * the most urgent task first), can cap how many workers run lower-priority
+ * tasks at once, and counts what it does.
+ *
+ * V8 doesn't label background tasks by subsystem, so the per-priority caps are
+ * the closest handle we have on GC and compiler concurrency. (Jobs, which V8
+ * uses for most parallel GC and compile work, are built on top of the same
+ * queues via v8::platform::NewDefaultJobHandle.)
+ *
+ * With PlatformConfig::huge_pages, our page allocator also asks for
+ * transparent huge pages (see HugePageAllocator).
+ *
+ * In single-threaded mode (i.e., with V8's --single-threaded flag), V8 posts
+ * no background tasks, and we run no workers.
+ *
+ * libplatform's PumpMessageLoop only works with the default platform itself,
+ * so message loops must pump GetDefaultPlatform(), not this object. */
+class WorkerPoolPlatform : public v8::Platform {
+ public:
+  WorkerPoolPlatform(std::unique_ptr<v8::Platform> default_platform,
+                     const PlatformConfig& config,
+                     bool single_threaded);
+  ~WorkerPoolPlatform() override;
+
+  WorkerPoolPlatform(const WorkerPoolPlatform&) = delete;
+  auto operator=(const WorkerPoolPlatform&) -> WorkerPoolPlatform& = delete;
+  WorkerPoolPlatform(WorkerPoolPlatform&&) = delete;
+  auto operator=(WorkerPoolPlatform&& other) -> WorkerPoolPlatform& = delete;
+
+  [[nodiscard]] auto GetDefaultPlatform() const -> v8::Platform*;
+  auto GetStats() -> PlatformStats;
+
+  static constexpr uint32_t kMaxDefaultWorkers = 16;
+
+  // v8::Platform implementation:
+  using v8::Platform::GetForegroundTaskRunner;
+  auto GetPageAllocator() -> v8::PageAllocator* override;
+  auto GetThreadIsolatedAllocator() -> v8::ThreadIsolatedAllocator* override;
+  auto GetZoneBackingAllocator() -> v8::ZoneBackingAllocator* override;
+  void OnCriticalMemoryPressure() override;
+  auto NumberOfWorkerThreads() -> int override;
+  auto GetForegroundTaskRunner(v8::Isolate* isolate,
+                               v8::TaskPriority priority)
+      -> std::shared_ptr<v8::TaskRunner> override;
+  auto IdleTasksEnabled(v8::Isolate* isolate) -> bool override;
+  auto CreateBlockingScope(v8::BlockingType blocking_type)
+      -> std::unique_ptr<v8::ScopedBlockingCall> override;
+  auto MonotonicallyIncreasingTime() -> double override;
+  auto CurrentClockTimeMilliseconds() -> int64_t override;
+  auto CurrentClockTimeMillis() -> double override;
+  auto CurrentClockTimeMillisecondsHighResolution() -> double override;
+  auto GetStackTracePrinter() -> StackTracePrinter override;
+  auto GetTracingController() -> v8::TracingController* override;
+  void DumpWithoutCrashing() override;
+  auto GetHighAllocationThroughputObserver()
+      -> v8::HighAllocationThroughputObserver* override;
+
+ protected:
+  auto CreateJobImpl(v8::TaskPriority priority,
+                     std::unique_ptr<v8::JobTask> job_task,
+                     const v8::SourceLocation& location)
+      -> std::unique_ptr<v8::JobHandle> override;
+  void PostTaskOnWorkerThreadImpl(v8::TaskPriority priority,
+                                  std::unique_ptr<v8::Task> task,
+                                  const v8::SourceLocation& location) override;
+  void PostDelayedTaskOnWorkerThreadImpl(
+      v8::TaskPriority priority,
+      std::unique_ptr<v8::Task> task,
+      double delay_in_seconds,
+      const v8::SourceLocation& location) override;
+
+ private:
+  struct DelayedTask {
+    v8::TaskPriority priority;
+    std::unique_ptr<v8::Task> task;
+  };
+
+  struct Queue {
+    std::deque<std::unique_ptr<v8::Task>> tasks;
+    // How many workers may run tasks from this queue at once:
+    size_t max_running;
+    size_t running;
+    size_t peak_running;
+    uint64_t posted;
+    uint64_t executed;
+  };
+
+  void Work();
+  /** Moves due delayed tasks into their queues, and returns the next task to
+   * run (or nullptr, having set *wake_time to when a delayed task comes due,
+   * or to infinity). */
+  auto NextTaskLocked(v8::TaskPriority* priority, double* wake_time)
+      -> std::unique_ptr<v8::Task>;
+
+  std::unique_ptr<v8::Platform> default_platform_;
+  std::unique_ptr<HugePageAllocator> huge_page_allocator_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_{false};
+  // Indexed by v8::TaskPriority:
+  std::array<Queue, 3> queues_;
+  // Keyed by due time, in MonotonicallyIncreasingTime seconds:
+  std::multimap<double, DelayedTask> delayed_;
+  std::vector<std::thread> workers_;
+};
+
+}  // end namespace MiniRacer
+
+#endif  // INCLUDE_MINI_RACER_WORKER_POOL_PLATFORM_H
@@ -3,7 +3,13 @@
 from datetime import datetime, timezone
 from json import JSONEncoder
 
-from py_mini_racer import MiniRacer
+import pytest
+from py_mini_racer import (
+    JSEvalException,
+    JSParseException,
+    JSTimeoutException,
+    MiniRacer,
+)
 
 
 def test_call_js(gc_check):
@@ -41,3 +47,102 @@ def test_call_custom_encoder(gc_check):
     assert mr.call("f", now, encoder=CustomEncoder) == now.isoformat()
 
     gc_check.check(mr)
+
+
+def test_call_reevaluates_expr(gc_check):
+    mr = MiniRacer()
+    mr.eval("var f = (a, b) => a + b; var obj = {g: (x) => [x, x]};")
+
+    for i in range(100):
+        assert mr.call("f", i, 1) == i + 1
+    assert mr.call("obj.g", {"a": 1}) == [{"a": 1}, {"a": 1}]
+
+    # Redefinitions are honored, even though we cache the compiled expression:
+    mr.eval("f = (a, b) => a * b")
+    assert mr.call("f", 6, 7) == 42
+
+    # Trailing comments in expr are OK:
+    assert mr.call("f // the function", 2, 3) == 6
+
+    gc_check.check(mr)
+
+
+def test_call_errors(gc_check):
+    mr = MiniRacer()
+    mr.eval("function thrower() { throw new Error('oops'); }")
+
+    with pytest.raises(JSParseException):
+        mr.call("not valid js (")
+
+    with pytest.raises(JSEvalException, match="oops"):
+        mr.call("thrower")
+
+    with pytest.raises(JSEvalException, match="not defined"):
+        mr.call("no_such_func")
+
+    with pytest.raises(JSEvalException, match="not callable"):
+        mr.call("42")
+
+    mr.eval("function spin() { while (true) {} }")
+    with pytest.raises(JSTimeoutException):
+        mr.call("spin", timeout_sec=0.5)
+
+    gc_check.check(mr)
+
+
+def test_map(gc_check):
+    mr = MiniRacer()
+    mr.eval("var seen = 0; function double(r) { seen++; return r * 2; }")
+
+    # Results come back in order, across many batches:
+    assert list(mr.map("double", range(1000), batch_size=7, max_in_flight=3)) == [
+        i * 2 for i in range(1000)
+    ]
+    assert mr.eval("seen") == 1000
+
+    # Records are any JSON-serializable value, and results without a JSON
+    # representation come back as None:
+    mr.eval("function shape(r) { return r.skip ? undefined : [r.a, r.a]; }")
+    assert list(mr.map("shape", [{"a": 1}, {"skip": True}, {"a": "x"}])) == [
+        [1, 1],
+        None,
+        ["x", "x"],
+    ]
+
+    assert list(mr.map("double", [])) == []
+
+    # Records are consumed lazily, as results are:
+    def records():
+        yield from range(10)
+        msg = "records exhausted"
+        raise AssertionError(msg)
+
+    results = mr.map("double", records(), batch_size=2, max_in_flight=1)
+    assert [next(results) for _ in range(4)] == [0, 2, 4, 6]
+    results.close()
+
+    with pytest.raises(ValueError, match="batch_size"):
+        list(mr.map("double", range(5), batch_size=0))
+
+    gc_check.check(mr)
+
+
+def test_map_errors(gc_check):
+    mr = MiniRacer()
+    mr.eval("function check(r) { if (r === 5) throw new Error('bad ' + r); return r; }")
+
+    results = mr.map("check", range(100), batch_size=2)
+    with pytest.raises(JSEvalException, match="bad 5"):
+        list(results)
+
+    with pytest.raises(JSEvalException, match="not defined"):
+        list(mr.map("no_such_func", [1]))
+
+    mr.eval("function spin() { while (true) {} }")
+    with pytest.raises(JSTimeoutException):
+        list(mr.map("spin", [1, 2, 3], batch_size=1, timeout_sec=0.5))
+
+    # The context is still usable:
+    assert list(mr.map("check", [1, 2])) == [1, 2]
+
+    gc_check.check(mr)
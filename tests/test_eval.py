@@ -1,6 +1,8 @@
 """Test .eval() method"""
 
+import sys
 from asyncio import run as asyncio_run
+from hashlib import sha1, sha256, sha384, sha512
 from time import sleep, time
 
 import pytest
@@ -13,6 +15,7 @@ from py_mini_racer import (
     JSSymbol,
     JSTimeoutException,
     JSUndefined,
+    MicrotaskPolicy,
     MiniRacer,
 )
 
@@ -269,6 +272,63 @@ while(true) {
     gc_check.check(mr)
 
 
+def test_auto_recycle(gc_check):
+    recycled = []
+    mr = MiniRacer()
+    mr.enable_auto_recycle(on_recycle=recycled.append)
+    mr.set_hard_memory_limit(100000000)
+    mr.eval("var x = 42")
+    obj = mr.eval("({a: 1})")
+    with pytest.raises(JSOOMException):
+        mr.eval(
+            """\
+let s = 1000;
+var a = new Array(s);
+a.fill(0);
+while(true) {
+    s *= 1.1;
+    let n = new Array(Math.floor(s));
+    n.fill(0);
+    a = a.concat(n);
+}"""
+        )
+
+    # The next request runs on a fresh isolate, with the same memory limit:
+    assert mr.recycle_count == 1
+    assert recycled == [mr]
+    assert not mr.was_hard_memory_limit_reached()
+    assert mr.eval("typeof x") == "undefined"
+    assert mr.eval("typeof setTimeout") == "function"
+    with pytest.raises(ValueError, match="closed Context"):
+        obj["a"]
+
+    # Explicit recycling works too:
+    mr.recycle()
+    assert mr.recycle_count == 2
+
+    mr.enable_auto_recycle(standby=0)
+    del obj
+    gc_check.check(mr)
+
+
+def test_recycle_keeps_settings(gc_check):
+    mr = MiniRacer()
+    mr.enable_console_buffer(capacity=2)
+    mr.set_task_watchdog(0.05)
+    mr.eval("console.log('old')")
+
+    mr.recycle()
+
+    # The console buffer and watchdog come back on the new isolate:
+    mr.eval("for (let i = 0; i < 3; i++) console.log(i)")
+    assert mr.drain_console() == {"dropped": 1, "lines": [["log", "1"], ["log", "2"]]}
+    mr.eval("const start = Date.now(); while (Date.now() - start < 100) {}")
+    (record,) = mr.task_watchdog_records()
+    assert record["elapsed_ms"] >= 50
+
+    gc_check.check(mr)
+
+
 def test_max_memory_hard_eval_arg(gc_check):
     # Same as above but passing the argument into the eval method (which is a
     # deprecated thing to do because the parameter is really affine to the
@@ -354,6 +414,45 @@ foo();
     gc_check.check(mr)
 
 
+@pytest.mark.parametrize("policy", list(MicrotaskPolicy))
+def test_microtask_policy(gc_check, policy):
+    mr = MiniRacer()
+    mr.set_microtask_policy(policy)
+
+    # Microtasks queued by an evaluation run before its result is observable from the
+    # next one:
+    assert not mr.eval(
+        """
+var done = false;
+Promise.resolve().then(() => {done = true});
+done
+"""
+    )
+    assert mr.eval("done")
+
+    # ... including through a chain of async functions and timers:
+    promise = mr.eval(
+        """
+(async () => {
+    await new Promise((res) => setTimeout(res, 10));
+    await null;
+    return 42;
+})()
+"""
+    )
+    assert promise.get(timeout=10) == 42
+
+    # Object access still sees microtask results:
+    obj = mr.eval("var obj = {}; Promise.resolve().then(() => obj.a = 1); obj")
+    assert obj["a"] == 1
+
+    with pytest.raises(ValueError, match="Invalid microtask policy"):
+        mr.set_microtask_policy(7)
+
+    del promise, obj
+    gc_check.check(mr)
+
+
 def test_polling(gc_check):
     mr = MiniRacer()
     assert not mr.eval(
@@ -509,3 +608,335 @@ JavaScript rejected promise with reason: this is a string
 
     del exc_info
     gc_check.check(mr)
+
+
+def test_run_script(gc_check):
+    mr = MiniRacer()
+
+    # Results are discarded, even for objects:
+    assert mr.run_script("var x = 1; ({a: x})") is None
+
+    for _ in range(10):
+        mr.run_script("x += 1", wait=False)
+    mr.run_script("")
+    assert mr.eval("x") == 11
+
+    with pytest.raises(JSParseException):
+        mr.run_script("var")
+
+    with pytest.raises(ValueError, match="requires wait=True"):
+        mr.run_script("x", wait=False, timeout_sec=1)
+
+    gc_check.check(mr)
+
+
+def test_run_script_deferred_errors(gc_check):
+    mr = MiniRacer()
+
+    mr.run_script("var x = 0", wait=False)
+    mr.run_script("throw new Error('first')", wait=False)
+    mr.run_script("x += 1", wait=False)
+    mr.run_script("throw new Error('second')", wait=False)
+
+    # Errors from queued scripts surface on the next waiting call, earliest first:
+    with pytest.raises(JSEvalException, match="first"):
+        mr.run_script("x += 1")
+    assert mr.eval("x") == 2
+
+    # ... and only once:
+    mr.run_script("")
+
+    gc_check.check(mr)
+
+
+def test_task_watchdog(gc_check):
+    mr = MiniRacer()
+    assert mr.task_watchdog_records() == []
+
+    mr.eval(
+        """
+function spin() {
+    const end = Date.now() + 500;
+    while (Date.now() < end) {}
+}
+function outer() {
+    spin();
+}
+"""
+    )
+
+    mr.set_task_watchdog(0.05)
+    mr.eval("outer()")
+    mr.eval("1 + 1")
+
+    (record,) = mr.task_watchdog_records()
+    assert record["task_kind"] == "javascript"
+    assert record["elapsed_ms"] >= 50
+    assert [frame["function"] for frame in record["stack"][:2]] == ["spin", "outer"]
+
+    mr.set_task_watchdog(None)
+    mr.eval("outer()")
+    assert len(mr.task_watchdog_records()) == 1
+
+    gc_check.check(mr)
+
+
+def test_console_buffer(gc_check):
+    mr = MiniRacer()
+    mr.enable_console_buffer(capacity=3)
+
+    mr.eval(
+        """
+console.log("hello", 1, {a: [1, 2]});
+console.warn("%s is %d%% done", "job", 42.7);
+console.error(new Error("oops"));
+"""
+    )
+    drained = mr.drain_console()
+    assert drained["dropped"] == 0
+    assert [level for level, _ in drained["lines"]] == ["log", "warn", "error"]
+    assert drained["lines"][0][1] == 'hello 1 {"a":[1,2]}'
+    assert drained["lines"][1][1] == "job is 42% done"
+    assert drained["lines"][2][1].startswith("Error: oops")
+
+    assert mr.drain_console() == {"dropped": 0, "lines": []}
+
+    mr.eval("for (let i = 0; i < 10; i++) console.info(i)")
+    assert mr.drain_console() == {
+        "dropped": 7,
+        "lines": [["info", "7"], ["info", "8"], ["info", "9"]],
+    }
+
+    # Exceptions from converting arguments propagate, and nothing is logged:
+    with pytest.raises(JSEvalException, match="boom"):
+        mr.eval("console.log('%d', {valueOf() { throw new Error('boom'); }})")
+    assert mr.drain_console() == {"dropped": 0, "lines": []}
+
+    # ... except that objects which JSON.stringify can't handle get a summary:
+    mr.eval("var cyclic = {}; cyclic.self = cyclic; console.log(cyclic)")
+    assert mr.drain_console()["lines"] == [["log", "#<Object>"]]
+
+    with pytest.raises(ValueError):
+        mr.enable_console_buffer(capacity=0)
+
+    gc_check.check(mr)
+
+
+def test_web_builtins(gc_check):
+    mr = MiniRacer()
+
+    assert mr.eval("Array.from(new TextEncoder().encode('hé€'))") == [
+        0x68,
+        0xC3,
+        0xA9,
+        0xE2,
+        0x82,
+        0xAC,
+    ]
+    assert (
+        mr.eval(
+            "const buf = new Uint8Array(4);"
+            "JSON.stringify(new TextEncoder().encodeInto('a€b', buf))"
+        )
+        == '{"read":2,"written":4}'
+    )
+    decode = "new TextDecoder().decode(new Uint8Array({}))"
+    assert mr.eval(decode.format("[0xEF, 0xBB, 0xBF, 0x68, 0xC3, 0xA9]")) == "hé"
+    assert mr.eval(decode.format("[0x68, 0xFF]")) == "h\ufffd"
+    assert (
+        mr.eval(
+            """
+const decoder = new TextDecoder();
+decoder.decode(new Uint8Array([0xE2, 0x82]), {stream: true}) +
+    decoder.decode(new Uint8Array([0xAC]))
+"""
+        )
+        == "€"
+    )
+    with pytest.raises(JSEvalException, match="TypeError"):
+        mr.eval(
+            "new TextDecoder('utf-8', {fatal: true}).decode(new Uint8Array([0xFF]))"
+        )
+    with pytest.raises(JSEvalException, match="RangeError"):
+        mr.eval("new TextDecoder('latin1')")
+    # Options which detach or shrink the input buffer take effect before
+    # decoding:
+    assert (
+        mr.eval(
+            """
+const big = new ArrayBuffer(1 << 20);
+new Uint8Array(big).fill(0x61);
+new TextDecoder().decode(
+    new Uint8Array(big), {get stream() { big.transfer(); return false; }})
+"""
+        )
+        == ""
+    )
+    assert (
+        mr.eval(
+            """
+const resizable = new ArrayBuffer(4, {maxByteLength: 4});
+new Uint8Array(resizable).set([0x61, 0x62, 0x63, 0x64]);
+new TextDecoder().decode(
+    new Uint8Array(resizable), {get stream() { resizable.resize(2); return false; }})
+"""
+        )
+        == "ab"
+    )
+
+    assert mr.eval("btoa('foobarÿ')") == "Zm9vYmFy/w=="
+    assert mr.eval("atob(' Zm9v YmFy/w ')") == "foobarÿ"
+    with pytest.raises(JSEvalException, match="InvalidCharacterError"):
+        mr.eval("btoa('€')")
+    with pytest.raises(JSEvalException, match="InvalidCharacterError"):
+        mr.eval("atob('Zm9vY')")
+
+    assert (
+        mr.eval(
+            """
+const orig = {a: [1, {b: new Map([[1, 2]])}], d: new Date(0)};
+orig.self = orig;
+const copy = structuredClone(orig);
+copy !== orig && copy.self === copy && copy.a[1].b.get(1) === 2 &&
+    copy.d.getTime() === 0
+"""
+        )
+        is True
+    )
+    with pytest.raises(JSEvalException):
+        mr.eval("structuredClone(() => 1)")
+
+    gc_check.check(mr)
+
+
+def test_crypto(gc_check):
+    mr = MiniRacer()
+
+    mr.eval(
+        """
+const hexDigest = (alg, data) => Array.from(
+    new Uint8Array(crypto.digestSync(alg, data)),
+    (b) => b.toString(16).padStart(2, "0")).join("");
+"""
+    )
+    data = "hé" * 100
+    assert (
+        mr.eval("hexDigest('SHA-1', 'hé'.repeat(100))")
+        == sha1(data.encode()).hexdigest()
+    )
+    assert (
+        mr.eval("hexDigest({name: 'sha-512'}, 'hé'.repeat(100))")
+        == sha512(data.encode()).hexdigest()
+    )
+    assert (
+        mr.eval(
+            """
+(async () => {
+  const buf = await crypto.subtle.digest("SHA-256", new Uint8Array([1, 2, 3]));
+  return new Uint8Array(buf)[0];
+})()
+"""
+        ).get()
+        == sha256(bytes([1, 2, 3])).digest()[0]
+    )
+    with pytest.raises(JSEvalException, match="NotSupportedError"):
+        mr.eval("crypto.digestSync('MD5', 'x')")
+
+    # FIPS 180 test vectors:
+    assert (
+        mr.eval("hexDigest('SHA-256', 'abc')")
+        == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"
+    )
+    assert mr.eval("hexDigest('SHA-384', 'abc')") == (
+        "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded163"
+        "1a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7"
+    )
+
+    # Inputs around the padding boundaries, where the length no longer fits in
+    # the last block (55 and 56 bytes for 64-byte blocks, 111 and 112 for
+    # 128-byte blocks), or fills it exactly:
+    for length in (55, 56, 64, 111, 112):
+        data = bytes(range(length))
+        js_data = f"new Uint8Array({list(data)})"
+        for alg, hasher in (
+            ("SHA-1", sha1),
+            ("SHA-256", sha256),
+            ("SHA-384", sha384),
+            ("SHA-512", sha512),
+        ):
+            assert mr.eval(f"hexDigest('{alg}', {js_data})") == hasher(data).hexdigest()
+
+    # XXH64 test vectors, for short inputs and for inputs which take the 32-byte
+    # stripe loop:
+    assert mr.eval("crypto.xxhash64('abc') === 0x44bc2cf5ad770999n")
+    assert mr.eval(
+        "crypto.xxhash64(new TextEncoder().encode('a'), 0) === 0xd24ec4f1a98c6e5bn"
+    )
+    assert mr.eval(
+        "crypto.xxhash64('Nobody inspects the spammish repetition') === "
+        "0xfbcea83c8a378bf1n"
+    )
+    assert mr.eval(
+        "crypto.xxhash64('Nobody inspects the spammish repetition', 1n) === "
+        "0x43f425448d954db6n"
+    )
+    assert mr.eval("crypto.xxhash64('x'.repeat(100)) === 0x92f0de5a88a3c094n")
+
+    # A seed whose conversion detaches the input buffer sees the detached
+    # (empty) input:
+    assert mr.eval(
+        """
+const buf = new ArrayBuffer(64);
+crypto.xxhash64(new Uint8Array(buf), {valueOf() { buf.transfer(); return 0; }}) ===
+    crypto.xxhash64('')
+"""
+    )
+
+    assert mr.eval("crypto.getRandomValues(new Uint32Array(64)).some((x) => x !== 0)")
+    with pytest.raises(JSEvalException, match="QuotaExceededError"):
+        mr.eval("crypto.getRandomValues(new Uint8Array(65537))")
+    with pytest.raises(JSEvalException, match="TypeMismatchError"):
+        mr.eval("crypto.getRandomValues(new Float64Array(1))")
+    assert len(mr.eval("crypto.randomUUID()")) == 36
+
+    gc_check.check(mr)
+
+
+@pytest.mark.skipif(sys.platform == "win32", reason="file reads need POSIX")
+def test_read_file_sync(gc_check, tmp_path):
+    allowed = tmp_path / "allowed"
+    allowed.mkdir()
+    (allowed / "sub").mkdir()
+    (allowed / "sub" / "data.txt").write_text("hello, file")
+    (allowed / "empty.txt").write_text("")
+    (tmp_path / "secret.txt").write_text("secret")
+    (allowed / "link.txt").symlink_to(tmp_path / "secret.txt")
+
+    mr = MiniRacer()
+    assert mr.eval("typeof readFileSync") == "undefined"
+
+    mr.allow_file_reads(allowed)
+    read = "new TextDecoder().decode(readFileSync({!r}))"
+    assert mr.eval(read.format(str(allowed / "sub" / "data.txt"))) == "hello, file"
+    assert mr.eval(read.format(str(allowed / "sub" / ".." / "empty.txt"))) == ""
+
+    # Writes change only our copy:
+    mr.eval(
+        f"new Uint8Array(readFileSync({str(allowed / 'sub' / 'data.txt')!r}))[0] = 74"
+    )
+    assert (allowed / "sub" / "data.txt").read_text() == "hello, file"
+
+    for path in (
+        tmp_path / "secret.txt",
+        allowed / ".." / "secret.txt",
+        allowed / "link.txt",
+        allowed / "missing.txt",
+        allowed / "sub",
+    ):
+        with pytest.raises(JSEvalException, match="readFileSync"):
+            mr.eval(f"readFileSync({str(path)!r})")
+
+    with pytest.raises(ValueError, match="Cannot allow file reads"):
+        mr.allow_file_reads(tmp_path / "missing")
+
+    gc_check.check(mr)
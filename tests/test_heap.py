@@ -1,4 +1,7 @@
-from py_mini_racer import MiniRacer
+from time import sleep, time
+
+import pytest
+from py_mini_racer import JSValueError, MiniRacer
 
 
 def test_heap_stats(gc_check):
@@ -8,3 +11,152 @@ def test_heap_stats(gc_check):
     assert mr.heap_stats()["total_heap_size"] > 0
 
     gc_check.check(mr)
+
+
+def test_heap_summary(gc_check):
+    mr = MiniRacer()
+    mr.eval(
+        """
+class Leaky {
+    constructor() {
+        this.payload = new Array(100).fill(0).map((_, i) => ({i}));
+    }
+}
+var leaks = [];
+for (let i = 0; i < 50; i++) {
+    leaks.push(new Leaky());
+}
+"""
+    )
+
+    summary = mr.heap_summary(top_n=5)
+    assert summary["node_count"] > 0
+    assert summary["total_size"] > 0
+    assert summary["columns"] == ["name", "count", "shallow_size", "retained_size"]
+    assert len(summary["rows"]) == 5
+    retained_sizes = [row[3] for row in summary["rows"]]
+    assert retained_sizes == sorted(retained_sizes, reverse=True)
+
+    rows = {row[0]: row for row in mr.heap_summary(top_n=0)["rows"]}
+    _, count, shallow_size, retained_size = rows["Leaky"]
+    assert count == 50
+    # Each Leaky retains its payload array, and the objects in it:
+    assert retained_size > shallow_size
+    assert rows["Object"][1] >= 50 * 100
+
+    gc_check.check(mr)
+
+
+def test_heap_growth(gc_check):
+    mr = MiniRacer()
+
+    with pytest.raises(JSValueError):
+        mr.heap_growth()
+
+    mr.eval("class Leaky {}; var leaks = [];")
+    mr.set_heap_growth_baseline()
+    mr.eval(
+        """
+for (let i = 0; i < 100; i++) {
+    leaks.push(new Leaky());
+}
+// Garbage doesn't count:
+for (let i = 0; i < 100; i++) {
+    new Leaky();
+}
+"""
+    )
+
+    growth = mr.heap_growth(top_n=0)
+    assert growth["columns"] == ["name", "count", "size"]
+    assert growth["object_count"] > 0
+    rows = {row[0]: row for row in growth["rows"]}
+    assert rows["Leaky"][1] == 100
+
+    # Moving the baseline forgets older objects:
+    mr.set_heap_growth_baseline()
+    rows = {row[0]: row for row in mr.heap_growth(top_n=0)["rows"]}
+    assert "Leaky" not in rows
+
+    gc_check.check(mr)
+
+
+def test_value_stats(gc_check):
+    mr = MiniRacer()
+
+    stats = mr.value_stats()
+    assert stats["total"] == 0
+    assert stats["collector_backlog"] >= 0
+
+    obj = mr.eval("({a: 1})")
+    arr = mr.eval("[1, 2, 3]")
+    func = mr.eval("(function() {})")
+    buf = mr.eval("new ArrayBuffer(100)")
+
+    stats = mr.value_stats()
+    assert stats["total"] == 4
+    assert stats["objects"] == 1
+    assert stats["arrays"] == 1
+    assert stats["functions"] == 1
+    assert stats["buffers"] == 1
+    assert stats["buffer_bytes"] == 100
+    assert stats["persistents"] == 4
+
+    del obj, arr, func, buf
+    gc_check.check(mr)
+
+
+def test_collect_during_long_script(gc_check):
+    mr = MiniRacer()
+    objs = [mr.eval("({})") for _ in range(2000)]
+
+    script_sec = 3
+    start = time()
+    mr.run_script(
+        f"const end = Date.now() + {script_sec * 1000}; while (Date.now() < end) {{}}",
+        wait=False,
+    )
+    # Freed objects pile up while the script occupies the message loop, until
+    # there are enough of them to interrupt it and collect them then and there:
+    del objs
+    while mr.value_stats()["collector_backlog"] >= 1024:
+        assert time() - start < script_sec, "no collection while the script ran"
+        sleep(0.01)
+    assert time() - start < script_sec
+
+    mr.run_script("")
+    gc_check.check(mr)
+
+
+def test_trim_memory(gc_check):
+    mr = MiniRacer()
+    mr.eval("var garbage = new Array(1000000).fill(0).map((_, i) => ({i}))")
+    mr.eval("garbage = null")
+
+    assert mr.trim_memory() > 0
+    assert mr.eval("1 + 1") == 2
+
+    stats = mr.trim_stats()
+    assert stats["trims"] == 1
+    assert stats["idle_trims"] == 0
+    assert stats["bytes_reclaimed"] > 0
+
+    gc_check.check(mr)
+
+
+def test_idle_trim(gc_check):
+    mr = MiniRacer()
+    mr.set_idle_trim(0.05)
+
+    start = time()
+    while time() - start < 5 and mr.trim_stats()["idle_trims"] == 0:
+        sleep(0.05)
+
+    # We trim once per idle spell:
+    stats = mr.trim_stats()
+    assert stats["idle_trims"] == 1
+    sleep(0.3)
+    assert mr.trim_stats()["idle_trims"] == 1
+
+    mr.set_idle_trim(None)
+    gc_check.check(mr)
@@ -1,5 +1,9 @@
+import sys
 from gc import collect
+from pathlib import Path
 from re import match
+from subprocess import run
+from threading import Thread, get_native_id
 from time import sleep, time
 
 import pytest
@@ -38,6 +42,109 @@ def test_sandbox():
     assert mr._ctx.v8_is_using_sandbox()  # noqa: SLF001
 
 
+def test_platform_stats():
+    mr = MiniRacer()
+    stats = mr.platform_stats()
+
+    # By default, V8 runs single-threaded, without a worker pool:
+    assert stats["worker_threads"] == 0
+    for priority in ("best_effort", "user_visible", "user_blocking"):
+        assert stats[priority] == {
+            "posted": 0,
+            "executed": 0,
+            "queued": 0,
+            "running": 0,
+            "peak_running": 0,
+        }
+
+
+# Since only the first use of V8 can configure the worker pool, we test it in a
+# fresh Python process:
+_WORKER_POOL_SCRIPT = """
+from py_mini_racer import MiniRacer, PlatformConfig, init_mini_racer
+
+init_mini_racer(
+    flags=(),
+    platform_config=PlatformConfig(
+        worker_threads=2, max_best_effort_workers=1, huge_pages=True
+    ),
+)
+mr = MiniRacer()
+mr.eval("let a = []; for (let i = 0; i < 100000; i++) { a.push({i}); } a = null;")
+assert mr.eval("new Uint8Array(16 << 20).fill(7)[12345]") == 7
+mr.low_memory_notification()
+stats = mr.platform_stats()
+assert stats["worker_threads"] == 2, stats
+priorities = [stats[p] for p in ("best_effort", "user_visible", "user_blocking")]
+assert sum(p["posted"] for p in priorities) > 0, stats
+# The cap on best effort workers held throughout:
+assert stats["best_effort"]["peak_running"] <= 1, stats
+assert all(p["peak_running"] <= 2 for p in priorities), stats
+"""
+
+
+def test_worker_pool_platform():
+    run([sys.executable, "-c", _WORKER_POOL_SCRIPT], check=True)  # noqa: S603
+
+
+def _thread_cpus():
+    """Return the allowed CPU list of each of our threads, by thread ID."""
+
+    cpus = {}
+    for status in Path("/proc/self/task").glob("*/status"):
+        for line in status.read_text().splitlines():
+            if line.startswith("Cpus_allowed_list:"):
+                cpus[status.parent.name] = line.split(":")[1].strip()
+    return cpus
+
+
+@pytest.mark.skipif(sys.platform != "linux", reason="Thread pinning is Linux-only")
+def test_pin_isolate_thread(gc_check):
+    from os import sched_getaffinity
+
+    init_mini_racer(ignore_duplicate_init=True)
+    before = _thread_cpus()
+    mr = MiniRacer()
+    # The new context's threads:
+    new_tids = _thread_cpus().keys() - before.keys()
+    assert new_tids
+
+    main_cpus = _thread_cpus()[str(get_native_id())]
+    cpu = min(sched_getaffinity(0))
+    mr.pin_isolate_thread(cpus=[cpu])
+    assert mr.eval("1 + 1") == 2
+    cpus = _thread_cpus()
+    # One of those threads (the one which runs JavaScript), but not ours, is now
+    # pinned:
+    pinned = [tid for tid in new_tids if cpus[tid] == str(cpu)]
+    assert pinned
+    if len(sched_getaffinity(0)) > 1:
+        assert len(pinned) == 1
+    assert cpus[str(get_native_id())] == main_cpus
+
+    node_cpus = Path("/sys/devices/system/node/node0/cpulist")
+    if node_cpus.exists():
+        try:
+            mr.pin_isolate_thread(numa_node=0)
+        except ValueError:
+            # set_mempolicy is forbidden (e.g., by a seccomp filter), so the
+            # thread stays pinned as before:
+            expected = str(cpu)
+        else:
+            expected = node_cpus.read_text().strip()
+        cpus = _thread_cpus()
+        assert expected in [cpus[tid] for tid in new_tids]
+        assert mr.eval("1 + 1") == 2
+
+    with pytest.raises(ValueError, match="Cannot pin"):
+        mr.pin_isolate_thread(numa_node=100000)
+
+    with pytest.raises(ValueError, match="Pass cpus"):
+        mr.pin_isolate_thread()
+
+    gc_check.check(mr)
+
+
 def test_del():
     # Collect any leftover contexts:
     start = time()
@@ -58,6 +165,33 @@ def test_del():
     assert context_count() == 0
 
 
+def test_close_during_calls():
+    mr = MiniRacer()
+    obj = mr.eval("({a: 0})")
+    errors = []
+
+    def call_until_closed():
+        try:
+            while True:
+                obj["a"] += 1
+        except ValueError:
+            # Calls which start after close() raise. Calls already in progress (whose
+            # pin close() leaves for them to release) complete:
+            pass
+        except Exception as e:  # noqa: BLE001
+            errors.append(e)
+
+    threads = [Thread(target=call_until_closed) for _ in range(4)]
+    for thread in threads:
+        thread.start()
+    sleep(0.1)
+    mr.close()
+    for thread in threads:
+        thread.join()
+
+    assert errors == []
+
+
 def test_interrupts_background_task_on_shutdown():
     with MiniRacer() as mr:
         # Schedule a never-ending background task:
@@ -1,7 +1,9 @@
 import pytest
 from py_mini_racer import (
     JSArray,
+    JSEvalException,
     JSFunction,
+    JSKeyError,
     JSObject,
     JSPromise,
     JSSymbol,
@@ -310,3 +312,129 @@ a
 
     del obj
     gc_check.check(mr)
+
+
+def test_interned_strings(gc_check):
+    mr = MiniRacer()
+    rows = mr.eval("[{id: 1, 'prénom': 'zoë'}, {id: 2, 'prénom': 'zoë'}]")
+
+    # Property names which recur are served from the context's string table, and
+    # so come back as the very same Python str:
+    keys = [list(row.keys()) for row in rows]
+    assert keys == [["id", "prénom"], ["id", "prénom"]]
+    assert keys[0][1] is keys[1][1]
+    assert rows[0][keys[0][1]] == "zoë"
+
+    # Other strings aren't interned:
+    assert rows[0]["prénom"] is not rows[1]["prénom"]
+    assert mr.eval("'x'.repeat(1000)") == "x" * 1000
+    assert mr.eval("''") == ""
+
+    del rows
+    gc_check.check(mr)
+
+
+def test_spin_wait(gc_check):
+    mr = MiniRacer()
+    mr.set_spin_wait(50)
+
+    obj = mr.eval("({a: 1})")
+    assert isinstance(obj, JSObject)
+    for i in range(100):
+        obj["a"] = i
+        assert obj["a"] == i
+    assert mr.eval("1 + 1") == 2
+
+    mr.set_spin_wait(0)
+    assert obj["a"] == 99
+
+    del obj
+    gc_check.check(mr)
+
+
+def test_batch(gc_check):
+    mr = MiniRacer()
+    obj = mr.eval(
+        """\
+var obj = {
+    inner: {x: 1},
+    arr: [1, 2, 3],
+    doomed: true,
+    add(a, b) { return a + b + this.inner.x; },
+};
+obj
+"""
+    )
+    assert isinstance(obj, JSObject)
+
+    batch = mr.batch()
+    inner = batch.get(obj, "inner")
+    batch.set(inner, "x", 10)
+    arr = batch.get(obj, "arr")
+    removed = batch.splice(arr, 1, 1, "a", "b")
+    batch.delete(obj, "doomed")
+    func = batch.get(obj, "add")
+    batch.call(func, 2, 3, this=obj)
+    batch.get(removed, 0)
+    assert len(batch) == 8
+
+    results = batch.run()
+    assert len(batch) == 0
+    assert len(results) == 8
+    assert isinstance(results[0], JSObject)
+    assert results[0]["x"] == 10
+    assert results[1] is True
+    assert isinstance(results[2], JSArray)
+    assert list(results[2]) == [1, "a", "b", 3]
+    assert isinstance(results[3], JSArray)
+    assert list(results[3]) == [2]
+    assert results[4] is True
+    assert isinstance(results[5], JSFunction)
+    assert results[6:] == [15, 2]
+    assert mr.eval("JSON.stringify(obj.arr)") == '[1,"a","b",3]'
+    assert "doomed" not in obj
+
+    # Results from a batch which already ran can't be reused:
+    with pytest.raises(ValueError, match="not from this batch"):
+        batch.get(inner, "x")
+
+    assert mr.batch().run() == []
+
+    del obj, results
+    gc_check.check(mr)
+
+
+def test_batch_errors(gc_check):
+    mr = MiniRacer()
+    obj = mr.eval(
+        """\
+var obj = {
+    count: 0,
+    fail() { throw new Error("oops"); },
+};
+obj
+"""
+    )
+    assert isinstance(obj, JSObject)
+
+    # Batches stop at the first error:
+    batch = mr.batch()
+    batch.set(obj, "count", 1)
+    batch.call(batch.get(obj, "fail"))
+    batch.set(obj, "count", 2)
+    with pytest.raises(JSEvalException, match="oops"):
+        batch.run()
+    assert obj["count"] == 1
+
+    batch = mr.batch()
+    batch.get(obj, "missing")
+    with pytest.raises(JSKeyError):
+        batch.run()
+
+    batch = mr.batch()
+    batch.call(batch.get(obj, "count"))
+    with pytest.raises(JSEvalException, match="not callable"):
+        batch.run()
+
+    del obj
+    gc_check.check(mr)
@@ -0,0 +1,42 @@
+from io import StringIO
+from os.path import dirname
+
+import py_mini_racer
+from helpers.trace_replay import OP_CALLBACK, OP_INIT_CONTEXT, read_trace, replay_trace
+from py_mini_racer import MiniRacer, start_trace, stop_trace
+
+
+def test_trace_and_replay(gc_check, tmp_path):
+    trace_path = str(tmp_path / "trace.bin")
+
+    start_trace(trace_path)
+    try:
+        mr = MiniRacer()
+        obj = mr.eval("var x = {a: 42}; x")
+        assert obj["a"] == 42
+        obj["b"] = "hello"
+        assert mr.eval("x.b") == "hello"
+    finally:
+        stop_trace()
+
+    records = read_trace(trace_path)
+    ops = [r.op for r in records]
+    assert ops[0] == OP_INIT_CONTEXT
+    assert OP_CALLBACK in ops
+    assert records == sorted(records, key=lambda r: r.start_ns)
+
+    out = StringIO()
+    stats = replay_trace(
+        trace_path,
+        lib_dir=dirname(py_mini_racer.__file__),
+        flags="--single-threaded",
+        callback_timeout_sec=10,
+        out=out,
+    )
+    assert stats["mr_eval"].count == 2
+    assert stats["mr_get_object_item"].count >= 1
+    assert stats["(async task completion)"].count >= 2
+    assert "warning" not in out.getvalue()
+
+    del obj
+    gc_check.check(mr)